@@ -0,0 +1,129 @@
+// BatchFilter.h
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "SqlParser.h"   // sqlmini::Cmp
+
+// =================== CONFIG ===================
+#ifndef SQL_SIMD
+#define SQL_SIMD 1   // comparación SIMD de columnas INT/FLOAT en los filtros por lote (AVX2 o SSE2 según flags)
+#endif
+// ==============================================
+#if SQL_SIMD && (defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64))
+#define BATCHFILTER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace batchfilter {
+
+using sqlmini::Cmp;
+
+// Kernels del filtro por lote. Un lote son filas de ancho fijo (stride) a partir de base con un
+// vector de selección sel[0..n); el resultado es una máscara de bits (bit i = la fila sel[i]
+// cumple) de n bits. Los offsets base + sel[i] * stride + off deben caber en 31 bits (los lotes
+// son bloques de ~1 MiB).
+
+// Reúne en out[i] el campo de 4 bytes de la fila sel[i]
+template<class T>
+inline void gather32(const char* base, size_t stride, size_t off, const uint32_t* sel, size_t n, T* out) {
+    static_assert(sizeof(T) == 4, "campos de 4 bytes");
+    size_t i = 0;
+#if defined(BATCHFILTER_X86) && defined(__AVX2__)
+    const __m256i vs = _mm256_set1_epi32((int)stride), vo = _mm256_set1_epi32((int)off);
+    for (; i + 8 <= n; i += 8) {
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sel + i));
+        __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(s, vs), vo);
+        __m256i v = _mm256_i32gather_epi32(reinterpret_cast<const int*>(base), idx, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+    }
+#endif
+    for (; i < n; ++i) std::memcpy(out + i, base + (size_t)sel[i] * stride + off, 4);
+}
+
+namespace detail {
+inline void put_bits(uint64_t* mask, size_t i, unsigned bits) { mask[i >> 6] |= (uint64_t)bits << (i & 63); }
+
+template<class T>
+inline bool cmp1(Cmp c, T a, T b) {
+    switch (c) {
+    case Cmp::EQ: return a == b;
+    case Cmp::NE: return a != b;
+    case Cmp::LT: return a <  b;
+    case Cmp::LE: return a <= b;
+    case Cmp::GT: return a >  b;
+    case Cmp::GE: return a >= b;
+    }
+    return false;
+}
+} // namespace detail
+
+// mask |= bits de (vals[i] c v), i en [0,n). mask debe venir en cero.
+inline void compare(const int32_t* vals, size_t n, Cmp c, int32_t v, uint64_t* mask) {
+    size_t i = 0;
+#if defined(BATCHFILTER_X86)
+    // EQ/GT/LT directos; NE/LE/GE como negación (sin NaN en enteros)
+    const bool neg = (c == Cmp::NE || c == Cmp::LE || c == Cmp::GE);
+    const Cmp base = c == Cmp::NE ? Cmp::EQ : c == Cmp::LE ? Cmp::GT : c == Cmp::GE ? Cmp::LT : c;
+#if defined(__AVX2__)
+    const __m256i pv = _mm256_set1_epi32(v);
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vals + i));
+        __m256i m = base == Cmp::EQ ? _mm256_cmpeq_epi32(x, pv)
+                  : base == Cmp::GT ? _mm256_cmpgt_epi32(x, pv) : _mm256_cmpgt_epi32(pv, x);
+        unsigned bits = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(m));
+        detail::put_bits(mask, i, neg ? bits ^ 0xFFu : bits);
+    }
+#endif
+    const __m128i pv4 = _mm_set1_epi32(v);
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vals + i));
+        __m128i m = base == Cmp::EQ ? _mm_cmpeq_epi32(x, pv4)
+                  : base == Cmp::GT ? _mm_cmpgt_epi32(x, pv4) : _mm_cmpgt_epi32(pv4, x);
+        unsigned bits = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(m));
+        detail::put_bits(mask, i, neg ? bits ^ 0xFu : bits);
+    }
+#endif
+    for (; i < n; ++i) if (detail::cmp1(c, vals[i], v)) detail::put_bits(mask, i, 1u);
+}
+
+// Igual para FLOAT, con la semántica de C++ ante NaN: solo != es verdadero
+inline void compare(const float* vals, size_t n, Cmp c, float v, uint64_t* mask) {
+    size_t i = 0;
+#if defined(BATCHFILTER_X86)
+#if defined(__AVX2__)
+    const __m256 pv = _mm256_set1_ps(v);
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(vals + i);
+        __m256 m;
+        switch (c) {
+        case Cmp::EQ: m = _mm256_cmp_ps(x, pv, _CMP_EQ_OQ);  break;
+        case Cmp::NE: m = _mm256_cmp_ps(x, pv, _CMP_NEQ_UQ); break;
+        case Cmp::LT: m = _mm256_cmp_ps(x, pv, _CMP_LT_OQ);  break;
+        case Cmp::LE: m = _mm256_cmp_ps(x, pv, _CMP_LE_OQ);  break;
+        case Cmp::GT: m = _mm256_cmp_ps(x, pv, _CMP_GT_OQ);  break;
+        default:      m = _mm256_cmp_ps(x, pv, _CMP_GE_OQ);  break;
+        }
+        detail::put_bits(mask, i, (unsigned)_mm256_movemask_ps(m));
+    }
+#endif
+    const __m128 pv4 = _mm_set1_ps(v);
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(vals + i);
+        __m128 m;
+        switch (c) {
+        case Cmp::EQ: m = _mm_cmpeq_ps(x, pv4);  break;
+        case Cmp::NE: m = _mm_cmpneq_ps(x, pv4); break;
+        case Cmp::LT: m = _mm_cmplt_ps(x, pv4);  break;
+        case Cmp::LE: m = _mm_cmple_ps(x, pv4);  break;
+        case Cmp::GT: m = _mm_cmpgt_ps(x, pv4);  break;
+        default:      m = _mm_cmpge_ps(x, pv4);  break;
+        }
+        detail::put_bits(mask, i, (unsigned)_mm_movemask_ps(m));
+    }
+#endif
+    for (; i < n; ++i) if (detail::cmp1(c, vals[i], v)) detail::put_bits(mask, i, 1u);
+}
+
+} // namespace batchfilter
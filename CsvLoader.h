@@ -0,0 +1,306 @@
+// CsvLoader.h
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <charconv>
+#include <algorithm>
+#include <stdexcept>
+
+#include "GenericFixedTable.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// =================== CONFIG ===================
+#define CSV_CHUNK_MB 8   // tamaño de cada trozo de entrada que parsea un hilo
+// ==============================================
+
+namespace csvload {
+
+using gft::ColType;
+
+// Archivo de entrada mapeado completo en memoria (solo lectura)
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#if defined(_WIN32)
+        fh = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fh == INVALID_HANDLE_VALUE) throw std::runtime_error("No se pudo abrir: " + path);
+        LARGE_INTEGER li;
+        if (!GetFileSizeEx(fh, &li)) { close(); throw std::runtime_error("No se pudo leer tamaño: " + path); }
+        len = (size_t)li.QuadPart;
+        if (len == 0) return;
+        mh = CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* p = mh ? MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!p) { close(); throw std::runtime_error("No se pudo mapear: " + path); }
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("No se pudo abrir: " + path);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) { close(); throw std::runtime_error("No se pudo leer tamaño: " + path); }
+        len = (size_t)st.st_size;
+        if (len == 0) return;
+        void* p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) { close(); throw std::runtime_error("No se pudo mapear: " + path); }
+        ::madvise(p, len, MADV_SEQUENTIAL);
+#endif
+        base = static_cast<const char*>(p);
+    }
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return base; }
+    size_t size() const { return len; }
+
+private:
+    const char* base = nullptr;
+    size_t len = 0;
+#if defined(_WIN32)
+    HANDLE fh = INVALID_HANDLE_VALUE, mh = nullptr;
+    void close() {
+        if (base) UnmapViewOfFile(base);
+        if (mh) CloseHandle(mh);
+        if (fh != INVALID_HANDLE_VALUE) CloseHandle(fh);
+        base = nullptr; mh = nullptr; fh = INVALID_HANDLE_VALUE;
+    }
+#else
+    int fd = -1;
+    void close() {
+        if (base) ::munmap(const_cast<char*>(base), len);
+        if (fd >= 0) ::close(fd);
+        base = nullptr; fd = -1;
+    }
+#endif
+};
+
+struct CsvOptions {
+    char     delim   = ',';
+    bool     header  = false;    // la primera línea trae nombres de columna
+    unsigned threads = 0;        // 0 = hardware_concurrency()
+    size_t   chunk_bytes = (size_t)CSV_CHUNK_MB << 20;
+};
+
+// Destino de un campo del CSV dentro de la fila empaquetada (offset < 0: se ignora)
+struct FieldTarget {
+    ColType type   = ColType::INT32;
+    int     width  = 0;
+    int     offset = -1;
+};
+
+// Carga de CSV a filas de ancho fijo. El archivo se mapea, se corta en trozos en límites de
+// línea y cada trozo se parsea en un hilo (std::from_chars) directo al formato empaquetado de
+// GenericFixedTable. Los trozos se entregan en orden de archivo a sink(char* filas, n) (el
+// buffer es del cargador y se puede modificar, p.ej. para completar el id), varios por
+// ronda (un trozo por hilo), así la memoria queda acotada a threads * chunk_bytes aprox.
+// Campos: números sin comillas; texto opcionalmente entre "..." o '...' (sin saltos de línea
+// dentro); campo vacío = 0 / "". Líneas vacías se ignoran.
+class CsvLoader {
+public:
+    CsvLoader(const std::string& path, CsvOptions o) : in(path), opt(o) {
+        if (opt.threads == 0) opt.threads = std::max(1u, std::thread::hardware_concurrency());
+        if (opt.chunk_bytes < 4096) opt.chunk_bytes = 4096;
+        data_begin = 0;
+        if (opt.header) {
+            size_t e = line_end(0);
+            header_fields = split_line(in.data(), e);
+            data_begin = next_line(e);
+            first_line = 2;
+        }
+    }
+
+    const std::vector<std::string>& header() const { return header_fields; }
+
+    // Cantidad de campos de la primera línea de datos (0 si no hay datos)
+    size_t first_record_fields() const {
+        size_t b = data_begin;
+        while (b < in.size()) {
+            size_t e = line_end(b);
+            if (!blank(b, e)) return split_line(in.data() + b, e - b).size();
+            b = next_line(e);
+        }
+        return 0;
+    }
+
+    // Parsea todo el archivo; sink(char* filas, size_t n) recibe bloques empaquetados.
+    // Lanza std::runtime_error con el número de línea ante un campo inválido.
+    template<class SINK>
+    uint64_t load(const std::vector<FieldTarget>& targets, int row_size, SINK sink) {
+        struct Chunk {
+            size_t b = 0, e = 0;
+            std::vector<char> rows;
+            size_t nrows = 0, nlines = 0;
+            std::string error; size_t error_line = 0;   // línea relativa al trozo
+        };
+        uint64_t total = 0;
+        size_t pos = data_begin;
+        uint64_t line_no = first_line;
+        while (pos < in.size()) {
+            // cortar la ronda en trozos que terminan en fin de línea
+            std::vector<Chunk> chunks;
+            for (unsigned t = 0; t < opt.threads && pos < in.size(); ++t) {
+                Chunk c; c.b = pos;
+                size_t e = std::min(in.size(), pos + opt.chunk_bytes);
+                if (e < in.size()) e = next_line(line_end(e > pos ? e - 1 : e));
+                c.e = e; pos = e;
+                chunks.push_back(std::move(c));
+            }
+            auto work = [&](Chunk& c) { parse_chunk(c.b, c.e, targets, row_size, c.rows, c.nrows, c.nlines, c.error, c.error_line); };
+            if (chunks.size() == 1) {
+                work(chunks[0]);
+            } else {
+                std::vector<std::thread> th;
+                for (size_t i = 1; i < chunks.size(); ++i) th.emplace_back(work, std::ref(chunks[i]));
+                work(chunks[0]);
+                for (auto& x : th) x.join();
+            }
+            for (auto& c : chunks) {
+                if (!c.error.empty()) {
+                    throw std::runtime_error("CSV línea " + std::to_string(line_no + c.error_line) + ": " + c.error);
+                }
+                if (c.nrows) sink(c.rows.data(), c.nrows);
+                total += c.nrows;
+                line_no += c.nlines;
+            }
+        }
+        return total;
+    }
+
+private:
+    MappedFile in;
+    CsvOptions opt;
+    size_t data_begin = 0;
+    uint64_t first_line = 1;
+    std::vector<std::string> header_fields;
+
+    // fin de la línea que contiene 'pos' (posición del '\n' o size())
+    size_t line_end(size_t pos) const {
+        if (pos >= in.size()) return in.size();
+        const void* nl = std::memchr(in.data() + pos, '\n', in.size() - pos);
+        return nl ? (size_t)(static_cast<const char*>(nl) - in.data()) : in.size();
+    }
+    size_t next_line(size_t e) const { return e < in.size() ? e + 1 : e; }
+    bool blank(size_t b, size_t e) const {
+        for (size_t i = b; i < e; ++i) if (!is_space(in.data()[i])) return false;
+        return true;
+    }
+    static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    // siguiente campo de [p, end): devuelve [fb, fe) sin espacios ni comillas, avanza p
+    const char* next_field(const char*& p, const char* end, const char*& fe) const {
+        while (p < end && is_space(*p)) ++p;
+        const char* fb;
+        if (p < end && (*p == '"' || *p == '\'')) {
+            const char q = *p++;
+            fb = p;
+            while (p < end && *p != q) ++p;
+            fe = p;
+            if (p < end) ++p;
+            while (p < end && *p != opt.delim) ++p;
+        } else {
+            fb = p;
+            while (p < end && *p != opt.delim) ++p;
+            fe = p;
+            while (fe > fb && is_space(fe[-1])) --fe;
+        }
+        return fb;
+    }
+
+    std::vector<std::string> split_line(const char* p, size_t n) const {
+        std::vector<std::string> out;
+        const char* end = p + n;
+        while (end > p && is_space(end[-1])) --end;
+        while (true) {
+            const char* fe;
+            const char* fb = next_field(p, end, fe);
+            out.emplace_back(fb, fe);
+            if (p >= end) break;
+            ++p;   // delimitador
+        }
+        return out;
+    }
+
+    void parse_chunk(size_t b, size_t e, const std::vector<FieldTarget>& targets, int row_size,
+                     std::vector<char>& rows, size_t& nrows, size_t& nlines,
+                     std::string& error, size_t& error_line) const {
+        rows.reserve(e - b);   // el texto ocupa aprox. lo mismo que las filas empaquetadas
+        nrows = 0; nlines = 0;
+        const char* base = in.data();
+        size_t ls = b;
+        while (ls < e) {
+            size_t le = line_end(ls);
+            if (le > e) le = e;
+            ++nlines;
+            if (!blank(ls, le)) {
+                const size_t off = rows.size();
+                rows.resize(off + (size_t)row_size, 0);
+                char* row = rows.data() + off;
+                const char* p = base + ls;
+                const char* end = base + le;
+                while (end > p && is_space(end[-1])) --end;
+                size_t f = 0;
+                while (true) {
+                    const char* fe;
+                    const char* fb = next_field(p, end, fe);
+                    if (f >= targets.size()) { error = "más campos que columnas"; error_line = nlines - 1; return; }
+                    if (!put_field(targets[f], fb, fe, row)) {
+                        error = "valor inválido '" + std::string(fb, fe) + "' en el campo " + std::to_string(f + 1);
+                        error_line = nlines - 1; return;
+                    }
+                    ++f;
+                    if (p >= end) break;
+                    ++p;
+                }
+                if (f != targets.size()) { error = "faltan campos"; error_line = nlines - 1; return; }
+                ++nrows;
+            }
+            ls = next_line(le);
+        }
+    }
+
+    static bool put_field(const FieldTarget& t, const char* b, const char* e, char* row) {
+        if (t.offset < 0) return true;
+        char* dst = row + t.offset;
+        switch (t.type) {
+        case ColType::INT32: {
+            int32_t v = 0;
+            if (b != e) {
+                if (*b == '+') ++b;
+                auto r = std::from_chars(b, e, v);
+                if (r.ec != std::errc() || r.ptr != e) return false;
+            }
+            std::memcpy(dst, &v, 4);
+            return true;
+        }
+        case ColType::FLOAT32: {
+            float v = 0.f;
+            if (b != e) {
+                if (*b == '+') ++b;
+                auto r = std::from_chars(b, e, v);
+                if (r.ec != std::errc() || r.ptr != e) return false;
+            }
+            std::memcpy(dst, &v, 4);
+            return true;
+        }
+        case ColType::CHAR: {
+            // mismo formato que pack_row: hasta width-1 bytes y relleno con ceros
+            size_t n = std::min<size_t>((size_t)(e - b), (size_t)t.width - 1);
+            std::memcpy(dst, b, n);
+            return true;
+        }
+        }
+        return false;
+    }
+};
+
+} // namespace csvload
@@ -0,0 +1,486 @@
+// DiskBPlusTree.h
+#pragma once
+#include <climits>
+#include <functional>
+#include "DiskBTreeMulti.h"
+
+namespace diskbtree {
+
+// --------- B+Tree con hojas enlazadas ---------
+// Todas las entradas (clave, pageID) viven en las hojas; los nodos internos solo guardan
+// separadores. Cada hoja apunta a la siguiente, así un rango desciende una sola vez y luego
+// recorre la cadena de hojas en orden. Las entradas se ordenan por el par (clave, pageID),
+// de modo que las claves duplicadas quedan contiguas y el borrado exacto es determinista.
+// El borrado es perezoso: no se fusionan ni redistribuyen nodos (una hoja puede quedar vacía
+// y se salta al recorrer); el espacio se recupera al reconstruir el índice.
+
+#pragma pack(push,1)
+struct BPFileHeader {
+    char     magic[8];       // "BP" + tipo de clave + versión
+    uint64_t node_size;      // tamaño del nodo (bytes)
+    int32_t  key_bytes;      // tamaño del campo clave por entrada
+    uint64_t root_off;       // offset de la raíz (0 == vacío)
+    uint64_t first_leaf;     // primera hoja de la cadena (0 == vacío)
+    uint64_t entries;        // número de entradas (clave,pageID)
+};
+#pragma pack(pop)
+
+// Formato de nodo (mismo tamaño para hojas e internos):
+//   [isLeaf u8][pad u8][n i16][pad u32][next u64]
+//   hoja:    pages[leaf_cap] (i32)  keys[leaf_cap][KEY_BYTES]
+//   interno: children[inner_cap+1] (u64)  pages[inner_cap] (i32)  keys[inner_cap][KEY_BYTES]
+// En un interno, el separador i es la menor entrada (key(i),page(i)) del hijo i+1.
+struct BPLayout {
+    uint64_t node_size = 0;
+    int      key_bytes = 0;
+    int      leaf_cap = 0;
+    int      inner_cap = 0;
+    uint32_t leaf_pages = 16, leaf_keys = 0;
+    uint32_t inner_children = 16, inner_pages = 0, inner_keys = 0;
+
+    static BPLayout make(uint64_t node_size, int key_bytes) {
+        BPLayout L;
+        L.node_size = node_size;
+        L.key_bytes = key_bytes;
+        L.leaf_cap  = (int)((node_size - 16) / (4 + key_bytes));
+        L.inner_cap = (int)((node_size - 24) / (8 + 4 + key_bytes));
+        L.leaf_cap  = std::min(L.leaf_cap, (int)INT16_MAX);
+        L.inner_cap = std::min(L.inner_cap, (int)INT16_MAX - 1);
+        if (L.leaf_cap < 3 || L.inner_cap < 3) throw std::invalid_argument("node_size demasiado pequeño");
+        L.leaf_keys   = L.leaf_pages + 4u * (uint32_t)L.leaf_cap;
+        L.inner_pages = L.inner_children + 8u * (uint32_t)(L.inner_cap + 1);
+        L.inner_keys  = L.inner_pages + 4u * (uint32_t)L.inner_cap;
+        return L;
+    }
+    size_t words() const { return (size_t)(node_size / 8); }
+};
+
+template<class BYTE>
+class BPNodeView {
+    template<class T> using Q = typename std::conditional<std::is_const<BYTE>::value, const T, T>::type;
+public:
+    using Layout = BPLayout;
+    BPNodeView(BYTE* base, const BPLayout& layout) : p(base), L(&layout) {}
+
+    Q<uint8_t>& isLeaf() const { return *reinterpret_cast<Q<uint8_t>*>(p); }
+    Q<int16_t>& n() const { return *reinterpret_cast<Q<int16_t>*>(p + 2); }
+    Q<uint64_t>& next() const { return *reinterpret_cast<Q<uint64_t>*>(p + 8); }
+    Q<uint64_t>& child(int i) const { return reinterpret_cast<Q<uint64_t>*>(p + L->inner_children)[i]; }
+    Q<int32_t>& page(int i) const {
+        return reinterpret_cast<Q<int32_t>*>(p + (isLeaf() ? L->leaf_pages : L->inner_pages))[i];
+    }
+    BYTE* key(int i) const {
+        return p + (isLeaf() ? L->leaf_keys : L->inner_keys) + (size_t)i * L->key_bytes;
+    }
+    int cap() const { return isLeaf() ? L->leaf_cap : L->inner_cap; }
+    BYTE* bytes() const { return p; }
+
+protected:
+    BYTE* p;
+    const BPLayout* L;
+};
+using BPView = BPNodeView<const uint8_t>;
+using BPNode = OwnedNode<BPNodeView<uint8_t>>;
+
+template<class TRAITS>
+class DiskBPlusTree {
+    using Key = typename TRAITS::Key;
+    static constexpr int KBYTES = TRAITS::KEY_BYTES;
+
+public:
+    using Traits = TRAITS;
+    // pool: caché de nodos compartida; nullptr usa BufferPool::shared_default()
+    explicit DiskBPlusTree(const std::string& path, bool create_new = true,
+                           std::shared_ptr<BufferPool> pool = nullptr,
+                           uint64_t node_size = PAGE_BYTES)
+        : store(std::move(pool)) {
+        char magic[8]; make_magic(magic);
+        if (create_new) {
+            layout = BPLayout::make(node_size, KBYTES);
+            store.open(path, /*create*/true);
+            BPFileHeader hdr{};
+            std::memcpy(hdr.magic, magic, 8);
+            hdr.node_size = layout.node_size;
+            hdr.key_bytes = KBYTES;
+            store.write_header(&hdr, sizeof(hdr));
+            header = hdr;
+        } else {
+            store.open(path, /*create*/false);
+            BPFileHeader hdr{};
+            store.read_header(&hdr, sizeof(hdr));
+            if (std::memcmp(hdr.magic, magic, 3) != 0) {
+                throw std::runtime_error("Tipo/magic incompatible con este índice");
+            }
+            if (std::memcmp(hdr.magic, magic, 8) != 0) {
+                throw IndexFormatError("Formato de índice anterior: " + path);
+            }
+            if (hdr.key_bytes != KBYTES || hdr.node_size < 64 || hdr.node_size % 8 != 0) {
+                throw std::runtime_error("node_size/key_bytes incompatible");
+            }
+            layout = BPLayout::make(hdr.node_size, KBYTES);
+            header = hdr;
+        }
+        store.set_node_size(layout.node_size);
+    }
+    ~DiskBPlusTree(){ try { sync_header(); } catch (...) {} }
+    DiskBPlusTree(const DiskBPlusTree&) = delete;
+    DiskBPlusTree& operator=(const DiskBPlusTree&) = delete;
+
+    bool empty() const { return header.entries == 0; }
+    uint64_t size() const { return header.entries; }
+    uint64_t node_bytes() const { return layout.node_size; }
+
+    // Insertar (key,value)
+    void insert(const Key& key, int value) {
+        uint8_t kb[KBYTES]; TRAITS::put(kb, key);
+        if (header.root_off == 0) {
+            uint64_t r = alloc_node();
+            BPNode R = new_node(); R.isLeaf()=1; R.n()=0; R.next()=0;
+            leaf_insert_at(R, 0, kb, value);
+            write_node(r, R);
+            header.root_off = header.first_leaf = r;
+            header.entries = 1; sync_header();
+            return;
+        }
+        Split s;
+        if (insert_rec(header.root_off, kb, value, s)) {
+            // la raíz se partió: nueva raíz interna con dos hijos
+            uint64_t r = alloc_node();
+            BPNode R = new_node(); R.isLeaf()=0; R.n()=1; R.next()=0;
+            R.child(0) = header.root_off;
+            R.child(1) = s.right;
+            std::memcpy(R.key(0), s.key, KBYTES);
+            R.page(0) = s.page;
+            write_node(r, R);
+            header.root_off = r; sync_header();
+        }
+        header.entries++;
+    }
+
+    // Carga masiva de abajo hacia arriba sobre un índice vacío. next(kb, value) entrega las n
+    // entradas ordenadas por (clave, pageID) y devuelve false al terminar. Las hojas se llenan a
+    // fill*leaf_cap entradas y los internos a fill*(inner_cap+1) hijos (repartiendo el resto
+    // de forma pareja); cada nodo se escribe una sola vez, en orden.
+    template<class NEXT>
+    void bulk_load(uint64_t n, NEXT next, double fill = BULK_FILL_FACTOR) {
+        if (header.root_off != 0) throw std::logic_error("bulk_load requiere un índice vacío");
+        if (n == 0) return;
+        auto per_node = [&](int maxv, int minv) {
+            long q = std::lround(fill * (double)maxv);
+            return (uint64_t)std::max<long>(std::min<long>(q, maxv), minv);
+        };
+        const uint64_t leaf_q = per_node(layout.leaf_cap, 1);
+        const uint64_t inner_q = per_node(layout.inner_cap + 1, 2);
+
+        // Por nivel: 'items' (entradas en hojas, hijos en internos) repartidos en 'nodes' nodos
+        struct Level {
+            uint64_t nodes, base, rem, j = 0, c = 0, off = 0;
+            uint8_t first_key[KBYTES]; int32_t first_page = 0;   // menor entrada del nodo actual
+            BPNode cur;
+        };
+        std::vector<Level> lv;
+        for (uint64_t items = n;;) {
+            uint64_t q = lv.empty() ? leaf_q : inner_q;
+            uint64_t L = (items + q - 1) / q;
+            Level l{L, items / L, items % L, 0, 0, 0, {}, 0, new_node()};
+            l.cur.isLeaf() = lv.empty() ? 1 : 0;
+            lv.push_back(std::move(l));
+            if (L == 1) break;
+            items = L;
+        }
+        for (auto& l : lv) l.off = alloc_node();
+        header.first_leaf = lv[0].off;
+
+        auto quota = [](const Level& l) { return l.base + (l.j < l.rem ? 1 : 0); };
+        // Agrega el hijo (off, menor entrada) al nivel h; si el nodo actual está lleno lo cierra
+        std::function<void(size_t, uint64_t, const uint8_t*, int32_t)> add_child;
+        auto finish_node = [&](size_t h) {
+            Level& l = lv[h];
+            bool leaf = (h == 0);
+            l.cur.n() = (int16_t)(leaf ? l.c : l.c - 1);
+            bool more = (l.j + 1 < l.nodes);
+            uint64_t next_off = more ? alloc_node() : 0;
+            if (leaf) l.cur.next() = next_off;
+            write_node(l.off, l.cur);
+            uint64_t done = l.off;
+            uint8_t fk[KBYTES]; std::memcpy(fk, l.first_key, KBYTES);
+            int32_t fp = l.first_page;
+            l.cur = new_node(); l.cur.isLeaf() = leaf ? 1 : 0;
+            l.c = 0; l.j++; l.off = next_off;
+            if (h + 1 < lv.size()) add_child(h + 1, done, fk, fp);
+            else header.root_off = done;
+        };
+        add_child = [&](size_t h, uint64_t off, const uint8_t* kb, int32_t page) {
+            Level& l = lv[h];
+            if (l.c == quota(l)) finish_node(h);
+            if (l.c == 0) { std::memcpy(l.first_key, kb, KBYTES); l.first_page = page; }
+            else { std::memcpy(l.cur.key((int)l.c - 1), kb, KBYTES); l.cur.page((int)l.c - 1) = page; }
+            l.cur.child((int)l.c) = off;
+            l.c++;
+        };
+
+        uint8_t kb[KBYTES]; int value = 0;
+        uint64_t got = 0;
+        while (got < n && next(kb, value)) {
+            Level& l = lv[0];
+            if (l.c == quota(l)) finish_node(0);
+            if (l.c == 0) { std::memcpy(l.first_key, kb, KBYTES); l.first_page = value; }
+            std::memcpy(l.cur.key((int)l.c), kb, KBYTES);
+            l.cur.page((int)l.c) = value;
+            l.c++; ++got;
+        }
+        if (got != n) throw std::runtime_error("bulk_load: cantidad de entradas inconsistente");
+        for (size_t h = 0; h < lv.size(); ++h) finish_node(h);
+        header.entries = n;
+        sync_header();
+    }
+
+    // Búsqueda exacta (el menor pageID si hay duplicados). -1 si no existe.
+    int search_get_value(const Key& k) const {
+        int out = -1;
+        uint8_t kb[KBYTES]; TRAITS::put(kb, k);
+        scan_from(kb, INT_MIN, [&](const uint8_t* key, int page) {
+            if (TRAITS::cmp_mem(key, kb) == 0) out = page;
+            return false;
+        });
+        return out;
+    }
+
+    // Rango: devuelve las CLAVES en [a,b] (incluye duplicados)
+    std::vector<Key> range_search_keys(const Key& a_in, const Key& b_in) const {
+        std::vector<Key> out;
+        range_scan(a_in, b_in, [&](const uint8_t* key, int) {
+            Key k; TRAITS::get(key, k); out.push_back(k);
+            return true;
+        });
+        return out;
+    }
+
+    // Rango: devuelve los VALUES (pageID) de cada entrada en [a,b], en orden de (clave,pageID)
+    std::vector<int> range_search_values(const Key& a_in, const Key& b_in) const {
+        std::vector<int> out;
+        range_scan(a_in, b_in, [&](const uint8_t*, int page) { out.push_back(page); return true; });
+        return out;
+    }
+
+    // Rango: llama fn(key, page) por cada entrada en [a,b], en orden de (clave,pageID) (key en bruto,
+    // comparable con TRAITS::cmp_mem); si fn devuelve false el recorrido termina ahí
+    template<class FN>
+    void range_scan(const Key& a_in, const Key& b_in, FN fn) const {
+        uint8_t A[KBYTES], B[KBYTES];
+        TRAITS::put(A, a_in); TRAITS::put(B, b_in);
+        if (TRAITS::cmp_mem(A, B) > 0) std::swap(A, B);
+        scan_from(A, INT_MIN, [&](const uint8_t* key, int page) {
+            if (TRAITS::cmp_mem(key, B) > 0) return false;
+            return fn(key, page);
+        });
+    }
+
+    // Borrado exacto de la entrada (key,value). Devuelve false si no existe.
+    bool remove(const Key& k, int value) {
+        if (header.root_off == 0) return false;
+        uint8_t kb[KBYTES]; TRAITS::put(kb, k);
+        uint64_t off = header.root_off;
+        for (;;) {
+            BPNode x = read_node(off);
+            if (!x.isLeaf()) { off = x.child(child_for(x, kb, value)); continue; }
+            int i = lower_bound_in(x, kb, value);
+            if (i >= x.n() || cmp_entry(x.key(i), x.page(i), kb, value) != 0) return false;
+            leaf_erase_at(x, i);
+            write_node(off, x);
+            break;
+        }
+        if (--header.entries == 0) {
+            header.root_off = header.first_leaf = 0;
+            sync_header();
+        }
+        return true;
+    }
+
+    // Borrado de una ocurrencia de la clave (la de menor pageID)
+    void remove_key(const Key& k) {
+        int v = search_get_value(k);
+        if (v != -1) remove(k, v);
+    }
+
+    // Debug
+    void traverse_print() const {
+        if (header.root_off==0) return;
+        traverse_rec(header.root_off, 0);
+    }
+
+    uint64_t root_offset() const { return header.root_off; }
+
+private:
+    NodeFile store;
+    BPFileHeader header{};
+    BPLayout layout;
+
+    struct Split { uint8_t key[KBYTES]; int32_t page; uint64_t right; };
+
+    static void make_magic(char m[8]) {
+        std::memcpy(m, TRAITS::MAGIC(), 8);
+        m[0] = 'B'; m[1] = 'P'; m[3] = 1;  // "BP" + tipo de clave, versión 1
+    }
+
+    // Orden compuesto (clave, pageID)
+    static int cmp_entry(const void* ka, int pa, const void* kb, int pb) {
+        int c = TRAITS::cmp_mem(ka, kb);
+        if (c != 0) return c;
+        return (pa < pb) ? -1 : (pa > pb ? 1 : 0);
+    }
+    // Posición de (kb,pb) en el nodo: se acota el tramo de claves iguales a kb con
+    // NodeSearch (binaria/SIMD) y dentro de él se busca binariamente por pageID.
+    // UPPER=false: primera entrada >= (kb,pb); UPPER=true: primera entrada > (kb,pb).
+    template<bool UPPER, class VIEW>
+    static int search_in(const VIEW& x, const uint8_t* kb, int pb) {
+        int lo = NodeSearch<TRAITS>::lower_bound(x.key(0), x.n(), kb);
+        if (lo == x.n() || TRAITS::cmp_mem(x.key(lo), kb) != 0) return lo;
+        int hi = NodeSearch<TRAITS>::upper_bound(x.key(lo), x.n() - lo, kb) + lo;
+        while (lo < hi) {
+            int mid = (lo + hi) >> 1;
+            if (UPPER ? x.page(mid) <= pb : x.page(mid) < pb) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+    template<class VIEW>
+    static int lower_bound_in(const VIEW& x, const uint8_t* kb, int pb) { return search_in<false>(x, kb, pb); }
+    // Hijo que contiene (kb,pb): número de separadores <= (kb,pb)
+    template<class VIEW>
+    static int child_for(const VIEW& x, const uint8_t* kb, int pb) { return search_in<true>(x, kb, pb); }
+
+    // Recorre en orden las entradas >= (kb,pb) mientras fn(key,page) devuelva true
+    template<class FN>
+    void scan_from(const uint8_t* kb, int pb, FN fn) const {
+        if (header.root_off == 0) return;
+        uint64_t off = header.root_off;
+        for (;;) {
+            PageGuard g = pin_node(off);
+            BPView x = view(g);
+            if (x.isLeaf()) break;
+            off = x.child(child_for(x, kb, pb));
+        }
+        bool first = true;
+        while (off != 0) {
+            PageGuard g = pin_node(off);
+            BPView x = view(g);
+            int i = first ? lower_bound_in(x, kb, pb) : 0;
+            first = false;
+            for (; i < x.n(); ++i) {
+                if (!fn(x.key(i), (int)x.page(i))) return;
+            }
+            off = x.next();
+        }
+    }
+
+    // IO nodos
+    void sync_header(){ store.write_header(&header, sizeof(header)); }
+    BPNode new_node() const { return BPNode(layout); }
+    uint64_t alloc_node() { return store.alloc(); }
+    PageGuard pin_node(uint64_t off) const { return store.pin(off); }
+    BPView view(const PageGuard& g) const { return BPView(g.data(), layout); }
+    BPNode read_node(uint64_t off) const {
+        BPNode n = new_node(); store.read(off, n.bytes()); return n;
+    }
+    void write_node(uint64_t off, const BPNode& n){ store.write(off, n.bytes()); }
+
+    // Desplazamientos dentro del nodo
+    void leaf_insert_at(BPNode& x, int i, const void* kb, int page) const {
+        int n = x.n();
+        std::memmove(&x.page(i+1), &x.page(i), (size_t)(n - i) * 4);
+        std::memmove(x.key(i+1), x.key(i), (size_t)(n - i) * KBYTES);
+        x.page(i) = page;
+        std::memcpy(x.key(i), kb, KBYTES);
+        x.n() = (int16_t)(n + 1);
+    }
+    void leaf_erase_at(BPNode& x, int i) const {
+        int n = x.n();
+        std::memmove(&x.page(i), &x.page(i+1), (size_t)(n - i - 1) * 4);
+        std::memmove(x.key(i), x.key(i+1), (size_t)(n - i - 1) * KBYTES);
+        x.n() = (int16_t)(n - 1);
+    }
+    // Inserta el separador i y el hijo derecho i+1
+    void inner_insert_at(BPNode& x, int i, const void* kb, int page, uint64_t right) const {
+        int n = x.n();
+        std::memmove(&x.child(i+2), &x.child(i+1), (size_t)(n - i) * 8);
+        std::memmove(&x.page(i+1), &x.page(i), (size_t)(n - i) * 4);
+        std::memmove(x.key(i+1), x.key(i), (size_t)(n - i) * KBYTES);
+        x.child(i+1) = right;
+        x.page(i) = page;
+        std::memcpy(x.key(i), kb, KBYTES);
+        x.n() = (int16_t)(n + 1);
+    }
+
+    // ---------- INSERT ----------
+    // Devuelve true si x se partió; s recibe el separador y el nuevo hermano derecho
+    bool insert_rec(uint64_t x_off, const uint8_t* kb, int value, Split& s) {
+        BPNode x = read_node(x_off);
+        if (x.isLeaf()) {
+            int i = lower_bound_in(x, kb, value);
+            if (x.n() < layout.leaf_cap) {
+                leaf_insert_at(x, i, kb, value);
+                write_node(x_off, x);
+                return false;
+            }
+            // hoja llena: la mitad superior pasa a una hoja nueva enlazada a continuación
+            int mid = x.n() / 2, moved = x.n() - mid;
+            uint64_t z_off = alloc_node();
+            BPNode z = new_node(); z.isLeaf()=1; z.n()=(int16_t)moved; z.next()=x.next();
+            std::memcpy(&z.page(0), &x.page(mid), (size_t)moved * 4);
+            std::memcpy(z.key(0), x.key(mid), (size_t)moved * KBYTES);
+            x.n() = (int16_t)mid; x.next() = z_off;
+            if (i <= mid) leaf_insert_at(x, i, kb, value);
+            else          leaf_insert_at(z, i - mid, kb, value);
+            std::memcpy(s.key, z.key(0), KBYTES);
+            s.page = z.page(0);
+            s.right = z_off;
+            write_node(z_off, z);
+            write_node(x_off, x);
+            return true;
+        }
+
+        int c = child_for(x, kb, value);
+        Split cs;
+        if (!insert_rec(x.child(c), kb, value, cs)) return false;
+        if (x.n() < layout.inner_cap) {
+            inner_insert_at(x, c, cs.key, cs.page, cs.right);
+            write_node(x_off, x);
+            return false;
+        }
+        // interno lleno: el separador central sube, la mitad derecha pasa a un nodo nuevo
+        int n = x.n(), mid = n / 2, moved = n - mid - 1;
+        uint64_t z_off = alloc_node();
+        BPNode z = new_node(); z.isLeaf()=0; z.n()=(int16_t)moved; z.next()=0;
+        std::memcpy(&z.child(0), &x.child(mid+1), (size_t)(moved + 1) * 8);
+        std::memcpy(&z.page(0), &x.page(mid+1), (size_t)moved * 4);
+        std::memcpy(z.key(0), x.key(mid+1), (size_t)moved * KBYTES);
+        std::memcpy(s.key, x.key(mid), KBYTES);
+        s.page = x.page(mid);
+        s.right = z_off;
+        x.n() = (int16_t)mid;
+        if (c <= mid) inner_insert_at(x, c, cs.key, cs.page, cs.right);
+        else          inner_insert_at(z, c - mid - 1, cs.key, cs.page, cs.right);
+        write_node(z_off, z);
+        write_node(x_off, x);
+        return true;
+    }
+
+    void traverse_rec(uint64_t x_off, int level) const {
+        PageGuard g = pin_node(x_off);
+        BPView x = view(g);
+        std::cout << std::string(level*2,' ') << "Nivel " << level
+                  << " (n="<<x.n()<<", leaf="<<int(x.isLeaf())<<") keys: ";
+        for (int i=0;i<x.n();++i) {
+            std::cout << TRAITS::to_string(x.key(i)) << "(" << x.page(i) << ") ";
+        }
+        std::cout << "\n";
+        if (!x.isLeaf()) for (int i=0;i<=x.n();++i) traverse_rec(x.child(i), level+1);
+    }
+};
+
+// Aliases listos para usar
+using BPTreeInt    = DiskBPlusTree<KeyInt>;
+using BPTreeFloat  = DiskBPlusTree<KeyFloat>;
+using BPTreeChar32 = DiskBPlusTree<KeyChar32>;
+
+} // namespace diskbtree
@@ -3,16 +3,30 @@
                 #include <cstdint>
                 #include <cstdio>
                 #include <cstring>
+                #include <cmath>
                 #include <string>
                 #include <vector>
                 #include <stdexcept>
                 #include <algorithm>
                 #include <iostream>
                 #include <type_traits>
+                #include <memory>
+                #include <unordered_map>
 
                 // =================== CONFIG ===================
-                #define MAX_T 128  // grado mínimo máximo; claves por nodo = 2*MAX_T - 1
+                #define MAX_T 128  // grado mínimo máximo admitido; el tamaño del nodo se deriva del t del archivo
+                #define BUFFER_POOL_MB 64  // capacidad por defecto del buffer pool compartido de nodos
+                #define BULK_FILL_FACTOR 0.9  // ocupación de nodos en la carga masiva (CREATE INDEX)
+                #ifndef BTREE_SIMD
+                #define BTREE_SIMD 1       // comparación SIMD de claves INT/FLOAT (AVX2 o SSE2 según flags del compilador)
+                #endif
                 // ==============================================
+                #if BTREE_SIMD && (defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64))
+                #include <immintrin.h>
+                #if defined(_MSC_VER)
+                #include <intrin.h>
+                #endif
+                #endif
 
                 namespace diskbtree {
 
@@ -21,7 +35,7 @@
                 // INT
                 struct KeyInt {
                     using Key = int32_t;
-                    static constexpr const char* MAGIC() { return "BTi\1\0\0\0"; } // 8 bytes
+                    static constexpr const char* MAGIC() { return "BTi\2\0\0\0"; } // 8 bytes
                     static constexpr int KEY_BYTES = 4;
                     static void put(void* dst, const Key& k) { std::memcpy(dst, &k, 4); }
                     static void get(const void* src, Key& k) { std::memcpy(&k, src, 4); }
@@ -37,7 +51,7 @@
                 // FLOAT
                 struct KeyFloat {
                     using Key = float;
-                    static constexpr const char* MAGIC() { return "BTf\1\0\0\0"; }
+                    static constexpr const char* MAGIC() { return "BTf\2\0\0\0"; }
                     static constexpr int KEY_BYTES = 4;
                     static void put(void* dst, const Key& k) { std::memcpy(dst, &k, 4); }
                     static void get(const void* src, Key& k) { std::memcpy(&k, src, 4); }
@@ -53,7 +67,7 @@
                 // CHAR[32] (string fija, lexicográfica binaria)
                 struct KeyChar32 {
                     using Key = std::string; // al insertar/consultar, usamos std::string (se trunca/pad)
-                    static constexpr const char* MAGIC() { return "BTs\1\0\0\0"; }
+                    static constexpr const char* MAGIC() { return "BTs\2\0\0\0"; }
                     static constexpr int KEY_BYTES = 32;
                     static void put(void* dst, const Key& s) {
                         char tmp[KEY_BYTES]; std::memset(tmp, 0, KEY_BYTES);
@@ -73,16 +87,133 @@
                     }
                 };
 
-                // --------- Infraestructura común ---------
-                static constexpr int MAX_KEYS  = 2 * MAX_T - 1;
-                static constexpr int MAX_CHILD = 2 * MAX_T;
+                // --------- Búsqueda dentro del nodo ---------
+                // Las claves de un nodo están contiguas (stride KEY_BYTES) y ordenadas. La clave buscada se
+                // codifica una sola vez con TRAITS::put y se compara en bruto contra el arreglo:
+                // búsqueda binaria hasta una ventana pequeña y barrido final. Para INT/FLOAT el barrido cuenta
+                // con SIMD cuántas claves de la ventana quedan por debajo de la buscada (8 por instrucción con
+                // AVX2, 4 con SSE2); como el arreglo está ordenado, ese conteo es la posición buscada.
+                template<class TRAITS>
+                struct NodeSearch {
+                    static constexpr int KB = TRAITS::KEY_BYTES;
+                    // primera posición i con key(i) >= probe
+                    static int lower_bound(const uint8_t* keys, int n, const uint8_t* probe) {
+                        int lo = 0, hi = n;
+                        while (lo < hi) {
+                            int mid = (lo + hi) >> 1;
+                            if (TRAITS::cmp_mem(keys + (size_t)mid * KB, probe) < 0) lo = mid + 1; else hi = mid;
+                        }
+                        return lo;
+                    }
+                    // primera posición i con key(i) > probe
+                    static int upper_bound(const uint8_t* keys, int n, const uint8_t* probe) {
+                        int lo = 0, hi = n;
+                        while (lo < hi) {
+                            int mid = (lo + hi) >> 1;
+                            if (TRAITS::cmp_mem(keys + (size_t)mid * KB, probe) <= 0) lo = mid + 1; else hi = mid;
+                        }
+                        return lo;
+                    }
+                };
+
+                #if BTREE_SIMD && (defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64))
+                namespace simd {
+                inline int popcnt(unsigned m) {
+                #if defined(_MSC_VER) && !defined(__clang__)
+                    return (int)__popcnt(m);
+                #else
+                    return __builtin_popcount(m);
+                #endif
+                }
+                // Cuenta las claves de keys[0..n) menores (o menores/iguales si LE) que v
+                template<bool LE>
+                inline int count_below_i32(const uint8_t* keys, int n, int32_t v) {
+                    int c = 0, i = 0;
+                #if defined(__AVX2__)
+                    const __m256i pv = _mm256_set1_epi32(v);
+                    for (; i + 8 <= n; i += 8) {
+                        __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + 4*(size_t)i));
+                        __m256i m = LE ? _mm256_cmpgt_epi32(k, pv) : _mm256_cmpgt_epi32(pv, k);
+                        int bits = popcnt((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+                        c += LE ? 8 - bits : bits;
+                    }
+                #endif
+                    const __m128i pv4 = _mm_set1_epi32(v);
+                    for (; i + 4 <= n; i += 4) {
+                        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + 4*(size_t)i));
+                        __m128i m = LE ? _mm_cmpgt_epi32(k, pv4) : _mm_cmpgt_epi32(pv4, k);
+                        int bits = popcnt((unsigned)_mm_movemask_ps(_mm_castsi128_ps(m)));
+                        c += LE ? 4 - bits : bits;
+                    }
+                    for (; i < n; ++i) {
+                        int32_t k; std::memcpy(&k, keys + 4*(size_t)i, 4);
+                        c += LE ? (k <= v) : (k < v);
+                    }
+                    return c;
+                }
+                template<bool LE>
+                inline int count_below_f32(const uint8_t* keys, int n, float v) {
+                    int c = 0, i = 0;
+                #if defined(__AVX2__)
+                    const __m256 pv = _mm256_set1_ps(v);
+                    for (; i + 8 <= n; i += 8) {
+                        __m256 k = _mm256_loadu_ps(reinterpret_cast<const float*>(keys + 4*(size_t)i));
+                        __m256 m = LE ? _mm256_cmp_ps(k, pv, _CMP_LE_OQ) : _mm256_cmp_ps(k, pv, _CMP_LT_OQ);
+                        c += popcnt((unsigned)_mm256_movemask_ps(m));
+                    }
+                #endif
+                    const __m128 pv4 = _mm_set1_ps(v);
+                    for (; i + 4 <= n; i += 4) {
+                        __m128 k = _mm_loadu_ps(reinterpret_cast<const float*>(keys + 4*(size_t)i));
+                        __m128 m = LE ? _mm_cmple_ps(k, pv4) : _mm_cmplt_ps(k, pv4);
+                        c += popcnt((unsigned)_mm_movemask_ps(m));
+                    }
+                    for (; i < n; ++i) {
+                        float k; std::memcpy(&k, keys + 4*(size_t)i, 4);
+                        c += LE ? (k <= v) : (k < v);
+                    }
+                    return c;
+                }
+                } // namespace simd
+
+                // Claves numéricas de 4 bytes: binaria hasta una ventana de SIMD_WINDOW claves y conteo SIMD
+                template<class T, int (*COUNT_LT)(const uint8_t*, int, T), int (*COUNT_LE)(const uint8_t*, int, T)>
+                struct NodeSearchSimd {
+                    static constexpr int SIMD_WINDOW = 32;
+                    static int lower_bound(const uint8_t* keys, int n, const uint8_t* probe) {
+                        T v; std::memcpy(&v, probe, 4);
+                        int lo = 0, hi = n;
+                        while (hi - lo > SIMD_WINDOW) {
+                            int mid = (lo + hi) >> 1;
+                            T k; std::memcpy(&k, keys + 4*(size_t)mid, 4);
+                            if (k < v) lo = mid + 1; else hi = mid;
+                        }
+                        return lo + COUNT_LT(keys + 4*(size_t)lo, hi - lo, v);
+                    }
+                    static int upper_bound(const uint8_t* keys, int n, const uint8_t* probe) {
+                        T v; std::memcpy(&v, probe, 4);
+                        int lo = 0, hi = n;
+                        while (hi - lo > SIMD_WINDOW) {
+                            int mid = (lo + hi) >> 1;
+                            T k; std::memcpy(&k, keys + 4*(size_t)mid, 4);
+                            if (!(v < k)) lo = mid + 1; else hi = mid;
+                        }
+                        return lo + COUNT_LE(keys + 4*(size_t)lo, hi - lo, v);
+                    }
+                };
+                template<> struct NodeSearch<KeyInt>
+                    : NodeSearchSimd<int32_t, simd::count_below_i32<false>, simd::count_below_i32<true>> {};
+                template<> struct NodeSearch<KeyFloat>
+                    : NodeSearchSimd<float, simd::count_below_f32<false>, simd::count_below_f32<true>> {};
+                #endif
 
+                // --------- Infraestructura común ---------
                 #pragma pack(push,1)
                 struct FileHeader {
                     char     magic[8];       // depende del tipo
                     int32_t  t;              // grado mínimo
                     uint64_t root_off;       // offset de la raíz (0 == none)
-                    uint64_t node_size;      // tamaño fijo del nodo (bytes)
+                    uint64_t node_size;      // tamaño del nodo (bytes), derivado de t (NodeLayout)
                     int32_t  key_bytes;      // tamaño del campo clave por entrada
                 };
                 #pragma pack(pop)
@@ -117,101 +248,445 @@
                     void flush(){ std::fflush(f); }
                 };
 
-                // Nodo genérico: las claves se guardan como bytes de longitud fija TRAITS::KEY_BYTES
-                #pragma pack(push,1)
-                template<int KEY_BYTES>
-                struct NodeDiskGeneric {
-                    uint8_t  isLeaf;
-                    int16_t  n;
-                    uint8_t  keys[MAX_KEYS][KEY_BYTES]; // claves en crudo
-                    int32_t  pages[MAX_KEYS];           // values
-                    uint64_t children[MAX_CHILD];
-                    uint32_t _reserved;
+                // --------- Buffer pool de nodos ---------
+                // Caché de capacidad fija (en bytes) compartida por varios árboles. Cada frame guarda
+                // la imagen de un nodo identificado por (archivo, offset). Los frames se fijan (pin)
+                // mientras se usan, se marcan sucios al modificarse y se expulsan con CLOCK; un frame
+                // sucio se escribe a disco al expulsarlo o en flush_file()/flush_all().
+                // Si todos los frames están fijados se permite exceder la capacidad temporalmente.
+                class BufferPool {
+                public:
+                    struct Stats { uint64_t hits = 0, misses = 0, evictions = 0, writebacks = 0; };
+
+                    explicit BufferPool(size_t capacity_bytes) : capacity(capacity_bytes) {}
+                    ~BufferPool(){ try { flush_all(); } catch (...) {} }
+                    BufferPool(const BufferPool&) = delete;
+                    BufferPool& operator=(const BufferPool&) = delete;
+
+                    static std::shared_ptr<BufferPool> with_mb(size_t mb) {
+                        return std::make_shared<BufferPool>(mb << 20);
+                    }
+                    // Pool por defecto del proceso (para árboles abiertos sin pool explícito)
+                    static std::shared_ptr<BufferPool> shared_default() {
+                        static std::shared_ptr<BufferPool> p = with_mb(BUFFER_POOL_MB);
+                        return p;
+                    }
+
+                    int register_file(Pager* p) {
+                        for (size_t i=0;i<files.size();++i) if (!files[i]) { files[i] = p; return (int)i; }
+                        files.push_back(p); return (int)files.size()-1;
+                    }
+                    // Escribe los frames sucios del archivo y los descarta del pool
+                    void unregister_file(int fid) {
+                        for (size_t i=0;i<frames.size();++i) {
+                            if (frames[i].fid == fid) { write_back(frames[i]); drop(i); }
+                        }
+                        if (fid >= 0 && fid < (int)files.size()) files[fid] = nullptr;
+                    }
+
+                    // Fija el nodo (fid,off) y devuelve el índice de frame. Con load=false y fallo
+                    // de caché no se lee el disco: el llamador sobrescribirá el nodo completo.
+                    size_t pin(int fid, uint64_t off, size_t len, bool load) {
+                        auto it = table.find({fid, off});
+                        if (it != table.end()) {
+                            Frame& f = frames[it->second];
+                            f.pins++; f.ref = true; st.hits++;
+                            return it->second;
+                        }
+                        st.misses++;
+                        evict_until(len);
+                        size_t idx;
+                        if (!free_frames.empty()) { idx = free_frames.back(); free_frames.pop_back(); }
+                        else { frames.emplace_back(); idx = frames.size()-1; }
+                        Frame& f = frames[idx];
+                        f.buf.reset(new uint64_t[(len + 7) / 8]);
+                        f.fid = fid; f.off = off; f.len = len;
+                        f.pins = 1; f.dirty = false; f.ref = true;
+                        if (load) {
+                            try { files[fid]->read_bytes(off, f.buf.get(), len); }
+                            catch (...) { f.fid = -1; f.buf.reset(); free_frames.push_back(idx); throw; }
+                        } else {
+                            std::memset(f.buf.get(), 0, len);
+                        }
+                        table[{fid, off}] = idx;
+                        used += len;
+                        return idx;
+                    }
+                    uint8_t* data(size_t frame) { return reinterpret_cast<uint8_t*>(frames[frame].buf.get()); }
+                    void unpin(size_t frame, bool dirty) {
+                        Frame& f = frames[frame];
+                        if (dirty) f.dirty = true;
+                        if (f.pins > 0) f.pins--;
+                    }
+
+                    void flush_file(int fid) {
+                        for (auto& f : frames) if (f.fid == fid) write_back(f);
+                        if (fid >= 0 && fid < (int)files.size() && files[fid]) files[fid]->flush();
+                    }
+                    void flush_all() {
+                        for (auto& f : frames) if (f.fid >= 0) write_back(f);
+                        for (auto* p : files) if (p) p->flush();
+                    }
+
+                    size_t capacity_bytes() const { return capacity; }
+                    size_t used_bytes() const { return used; }
+                    const Stats& stats() const { return st; }
+
+                private:
+                    struct Frame {
+                        int      fid = -1;          // -1 == libre
+                        uint64_t off = 0;
+                        size_t   len = 0;
+                        int      pins = 0;
+                        bool     dirty = false;
+                        bool     ref = false;       // bit de referencia (CLOCK)
+                        std::unique_ptr<uint64_t[]> buf; // alineado a 8 bytes
+                    };
+                    struct KeyHash {
+                        size_t operator()(const std::pair<int,uint64_t>& k) const {
+                            return std::hash<uint64_t>()(k.second * 0x9E3779B97F4A7C15ULL ^ (uint64_t)k.first);
+                        }
+                    };
+
+                    size_t capacity;
+                    size_t used = 0;
+                    size_t hand = 0;
+                    Stats  st;
+                    std::vector<Frame>  frames;
+                    std::vector<size_t> free_frames;
+                    std::vector<Pager*> files;
+                    std::unordered_map<std::pair<int,uint64_t>, size_t, KeyHash> table;
+
+                    void write_back(Frame& f) {
+                        if (f.fid < 0 || !f.dirty) return;
+                        files[f.fid]->write_bytes(f.off, f.buf.get(), f.len);
+                        f.dirty = false; st.writebacks++;
+                    }
+                    void drop(size_t idx) {
+                        Frame& f = frames[idx];
+                        if (f.fid < 0) return;
+                        table.erase({f.fid, f.off});
+                        used -= f.len;
+                        f.fid = -1; f.buf.reset(); f.pins = 0; f.dirty = false;
+                        free_frames.push_back(idx);
+                    }
+                    // CLOCK: libera frames no fijados hasta que quepan 'need' bytes más
+                    void evict_until(size_t need) {
+                        size_t scanned = 0;
+                        while (used + need > capacity && !frames.empty() && scanned < 2*frames.size()) {
+                            hand = (hand + 1) % frames.size();
+                            Frame& f = frames[hand];
+                            ++scanned;
+                            if (f.fid < 0 || f.pins > 0) continue;
+                            if (f.ref) { f.ref = false; continue; }
+                            write_back(f);
+                            drop(hand);
+                            st.evictions++;
+                            scanned = 0;
+                        }
+                    }
+                };
+
+                // Fija un nodo del pool durante su alcance (RAII)
+                class PageGuard {
+                public:
+                    PageGuard(BufferPool& p, int fid, uint64_t off, size_t len, bool load = true)
+                        : pool(&p), frame(p.pin(fid, off, len, load)) {}
+                    ~PageGuard(){ if (pool) pool->unpin(frame, dirty); }
+                    PageGuard(const PageGuard&) = delete;
+                    PageGuard& operator=(const PageGuard&) = delete;
+                    PageGuard(PageGuard&& o) noexcept : pool(o.pool), frame(o.frame), dirty(o.dirty) { o.pool = nullptr; }
+
+                    uint8_t* data() const { return pool->data(frame); }
+                    void mark_dirty() { dirty = true; }
+
+                private:
+                    BufferPool* pool;
+                    size_t frame;
+                    bool dirty = false;
+                };
+
+                // --------- Formato de nodo dimensionado por t ---------
+                // El tamaño del nodo se deriva del grado t guardado en FileHeader:
+                //   [isLeaf u8][pad u8][n i16][pad u32] children[2t] (u64) pages[2t-1] (i32) keys[2t-1][KEY_BYTES]
+                // y se redondea a potencia de 2 (< 4 KiB) o a múltiplo de 4 KiB, de modo que ningún nodo
+                // cruce un límite de página. La página 0 del archivo queda para la cabecera.
+                static constexpr uint64_t PAGE_BYTES = 4096;
+
+                struct NodeLayout {
+                    int      t = 0;
+                    int      key_bytes = 0;
+                    uint32_t off_children = 8;
+                    uint32_t off_pages = 0;
+                    uint32_t off_keys = 0;
+                    uint64_t node_size = 0;
+
+                    static NodeLayout make(int t, int key_bytes) {
+                        NodeLayout L;
+                        L.t = t; L.key_bytes = key_bytes;
+                        L.off_pages = L.off_children + 8u * (uint32_t)(2*t);
+                        L.off_keys  = L.off_pages + 4u * (uint32_t)(2*t - 1);
+                        uint64_t raw = L.off_keys + (uint64_t)key_bytes * (uint64_t)(2*t - 1);
+                        if (raw >= PAGE_BYTES) L.node_size = (raw + PAGE_BYTES - 1) / PAGE_BYTES * PAGE_BYTES;
+                        else { L.node_size = 64; while (L.node_size < raw) L.node_size <<= 1; }
+                        return L;
+                    }
+                    size_t words() const { return (size_t)((node_size + 7) / 8); }
+                };
+
+                // Vista sobre los bytes de un nodo (frame del pool o buffer propio).
+                // BYTE = uint8_t (mutable) o const uint8_t (solo lectura).
+                template<class BYTE>
+                class BasicNodeView {
+                    template<class T> using Q = typename std::conditional<std::is_const<BYTE>::value, const T, T>::type;
+                public:
+                    using Layout = NodeLayout;
+                    BasicNodeView(BYTE* base, const NodeLayout& layout) : p(base), L(&layout) {}
+
+                    BYTE&       isLeaf() const { return p[0]; }
+                    Q<int16_t>& n() const { return *reinterpret_cast<Q<int16_t>*>(p + 2); }
+                    Q<uint64_t>& child(int i) const { return reinterpret_cast<Q<uint64_t>*>(p + L->off_children)[i]; }
+                    Q<int32_t>& page(int i) const { return reinterpret_cast<Q<int32_t>*>(p + L->off_pages)[i]; }
+                    BYTE*       key(int i) const { return p + L->off_keys + (size_t)i * L->key_bytes; }
+                    BYTE*       bytes() const { return p; }
+
+                protected:
+                    BYTE* p;
+                    const NodeLayout* L;
+                };
+                using NodeView = BasicNodeView<const uint8_t>;
+
+                // Nodo en memoria con su propio buffer (alineado a 8 bytes); VIEW da los accesores
+                template<class VIEW>
+                class OwnedNode : public VIEW {
+                    using Layout = typename VIEW::Layout;
+                public:
+                    explicit OwnedNode(const Layout& layout)
+                        : VIEW(nullptr, layout), buf(layout.words(), 0) { this->p = data(); }
+                    OwnedNode(const OwnedNode& o) : VIEW(o), buf(o.buf) { this->p = data(); }
+                    OwnedNode(OwnedNode&& o) noexcept : VIEW(o), buf(std::move(o.buf)) { this->p = data(); }
+                    OwnedNode& operator=(const OwnedNode& o) { this->L = o.L; buf = o.buf; this->p = data(); return *this; }
+                    OwnedNode& operator=(OwnedNode&& o) noexcept { this->L = o.L; buf = std::move(o.buf); this->p = data(); return *this; }
+
+                private:
+                    std::vector<uint64_t> buf;
+                    uint8_t* data() { return reinterpret_cast<uint8_t*>(buf.data()); }
+                };
+                using Node = OwnedNode<BasicNodeView<uint8_t>>;
+
+                // Archivo de nodos de tamaño fijo servido a través de un BufferPool.
+                // La página 0 es la cabecera (se lee/escribe directo); los nodos empiezan en PAGE_BYTES.
+                class NodeFile {
+                public:
+                    explicit NodeFile(std::shared_ptr<BufferPool> pool_in)
+                        : pool(pool_in ? std::move(pool_in) : BufferPool::shared_default()) {}
+                    ~NodeFile(){ close(); }
+                    NodeFile(const NodeFile&) = delete;
+                    NodeFile& operator=(const NodeFile&) = delete;
+
+                    void open(const std::string& path, bool create) {
+                        pager.open(path, create);
+                        fid = pool->register_file(&pager);
+                        next_off = std::max<uint64_t>(pager.size(), PAGE_BYTES);
+                    }
+                    // Vuelca los nodos sucios del pool y cierra el registro del archivo
+                    void close() {
+                        if (fid < 0) return;
+                        try { pool->unregister_file(fid); } catch (...) {}
+                        fid = -1;
+                        pager.flush();
+                    }
+                    void set_node_size(uint64_t bytes) { node_size = bytes; }
+
+                    void read_header(void* dst, size_t len) { pager.read_bytes(0, dst, len); }
+                    void write_header(const void* src, size_t len) { pager.write_bytes(0, src, len); }
+                    void flush() { pool->flush_file(fid); }
+
+                    // Reserva el offset del nodo; el contenido llega con write() (vía pool)
+                    uint64_t alloc() {
+                        uint64_t off = next_off;
+                        next_off += node_size;
+                        return off;
+                    }
+                    // Fija el nodo en el pool: lectura sin copia mientras viva el guard
+                    PageGuard pin(uint64_t off) const { return PageGuard(*pool, fid, off, node_size); }
+                    void read(uint64_t off, void* dst) const {
+                        PageGuard g = pin(off);
+                        std::memcpy(dst, g.data(), node_size);
+                    }
+                    void write(uint64_t off, const void* src) {
+                        PageGuard g(*pool, fid, off, node_size, /*load*/false);
+                        std::memcpy(g.data(), src, node_size);
+                        g.mark_dirty();
+                    }
+
+                private:
+                    std::shared_ptr<BufferPool> pool;
+                    Pager pager;
+                    int fid = -1;             // id del archivo dentro del pool
+                    uint64_t node_size = 0;
+                    uint64_t next_off = 0;    // fin lógico del archivo (incluye nodos aún en el pool)
+                };
+
+                // Archivo de índice con un formato de nodo anterior (se puede reconstruir desde la tabla)
+                struct IndexFormatError : std::runtime_error {
+                    using std::runtime_error::runtime_error;
                 };
-                #pragma pack(pop)
 
                 // B-Tree genérico parametrizado por TRAITS
                 template<class TRAITS>
                 class DiskBTree {
                     using Key = typename TRAITS::Key;
                     static constexpr int KBYTES = TRAITS::KEY_BYTES;
-                    using NodeDisk = NodeDiskGeneric<KBYTES>;
 
                 public:
-                    explicit DiskBTree(const std::string& path, int t, bool create_new = true) {
-                        if (t < 2) throw std::invalid_argument("t debe ser >= 2");
-                        if (t > MAX_T) throw std::invalid_argument("t excede MAX_T compilado");
-                        node_size = sizeof(NodeDisk);
+                    using Traits = TRAITS;
+                    // pool: caché de nodos compartida; nullptr usa BufferPool::shared_default()
+                    explicit DiskBTree(const std::string& path, int t, bool create_new = true,
+                                       std::shared_ptr<BufferPool> pool = nullptr)
+                        : store(std::move(pool)) {
                         if (create_new) {
-                            pager.open(path, /*create*/true);
+                            if (t < 2) throw std::invalid_argument("t debe ser >= 2");
+                            if (t > MAX_T) throw std::invalid_argument("t excede MAX_T compilado");
+                            layout = NodeLayout::make(t, KBYTES);
+                            store.open(path, /*create*/true);
                             FileHeader hdr{};
                             std::memset(hdr.magic, 0, 8);
                             std::memcpy(hdr.magic, TRAITS::MAGIC(), 8);
                             hdr.t = t;
                             hdr.root_off = 0;
-                            hdr.node_size = node_size;
+                            hdr.node_size = layout.node_size;
                             hdr.key_bytes = KBYTES;
-                            pager.write_bytes(0, &hdr, sizeof(hdr));
-                            pager.flush();
+                            store.write_header(&hdr, sizeof(hdr));
                             header = hdr;
                         } else {
-                            pager.open(path, /*create*/false);
+                            store.open(path, /*create*/false);
                             FileHeader hdr{};
-                            pager.read_bytes(0, &hdr, sizeof(hdr));
-                            if (std::memcmp(hdr.magic, TRAITS::MAGIC(), 8) != 0) {
+                            store.read_header(&hdr, sizeof(hdr));
+                            if (std::memcmp(hdr.magic, TRAITS::MAGIC(), 3) != 0) {
                                 throw std::runtime_error("Tipo/magic incompatible con este índice");
                             }
-                            if ((uint64_t)hdr.node_size != sizeof(NodeDisk) || hdr.key_bytes != KBYTES) {
+                            if (std::memcmp(hdr.magic, TRAITS::MAGIC(), 8) != 0) {
+                                throw IndexFormatError("Formato de índice anterior: " + path);
+                            }
+                            if (hdr.t < 2 || hdr.t > MAX_T) throw std::runtime_error("t del archivo fuera de rango");
+                            layout = NodeLayout::make(hdr.t, KBYTES);
+                            if (hdr.node_size != layout.node_size || hdr.key_bytes != KBYTES) {
                                 throw std::runtime_error("node_size/key_bytes incompatible");
                             }
-                            if (hdr.t > MAX_T) throw std::runtime_error("t del archivo excede MAX_T");
                             header = hdr;
                         }
+                        store.set_node_size(layout.node_size);
                     }
-                    ~DiskBTree(){ sync_header(); pager.flush(); }
+                    ~DiskBTree(){ try { sync_header(); } catch (...) {} }
+                    DiskBTree(const DiskBTree&) = delete;
+                    DiskBTree& operator=(const DiskBTree&) = delete;
 
                     int  T() const { return header.t; }
                     bool empty() const { return header.root_off == 0; }
+                    uint64_t node_bytes() const { return layout.node_size; }
 
                     // Insertar (key,value)
                     void insert(const Key& key, int value) {
+                        uint8_t kb[KBYTES]; TRAITS::put(kb, key);
                         if (header.root_off == 0) {
                             uint64_t r = alloc_node();
-                            NodeDisk R{}; R.isLeaf=1; R.n=1;
-                            TRAITS::put(R.keys[0], key);
-                            R.pages[0] = value;
-                            std::fill(std::begin(R.children), std::end(R.children), 0ULL);
+                            Node R = new_node(); R.isLeaf()=1; R.n()=1;
+                            TRAITS::put(R.key(0), key);
+                            R.page(0) = value;
                             write_node(r, R);
                             header.root_off = r; sync_header();
                             return;
                         }
-                        NodeDisk root = read_node(header.root_off);
-                        if (root.n == 2*T()-1) {
+                        Node root = read_node(header.root_off);
+                        if (root.n() == 2*T()-1) {
                             uint64_t s_off = alloc_node();
-                            NodeDisk S{}; S.isLeaf=0; S.n=0;
-                            std::fill(std::begin(S.children), std::end(S.children), 0ULL);
-                            S.children[0] = header.root_off; write_node(s_off, S);
+                            Node S = new_node(); S.isLeaf()=0; S.n()=0;
+                            S.child(0) = header.root_off; write_node(s_off, S);
                             split_child(s_off, 0, header.root_off);
                             S = read_node(s_off);
                             int i = 0;
-                            if (TRAITS::cmp_mem(S.keys[0], key_as_bytes(key)) < 0) i = 1;
-                            insert_non_full(S.children[i], key, value);
+                            if (TRAITS::cmp_mem(S.key(0), kb) < 0) i = 1;
+                            insert_non_full(S.child(i), kb, value);
                             header.root_off = s_off; sync_header();
                         } else {
-                            insert_non_full(header.root_off, key, value);
+                            insert_non_full(header.root_off, kb, value);
                         }
                     }
 
+                    // Carga masiva de abajo hacia arriba sobre un índice vacío. next(kb, value) entrega las n
+                    // entradas ya ordenadas (kb = clave codificada con TRAITS::put) y devuelve false al terminar.
+                    // Cada nivel se llena a fill*(2t-1) claves por nodo, repartiendo el resto de forma pareja
+                    // para respetar el mínimo de t-1; los nodos se escriben una sola vez y en orden.
+                    template<class NEXT>
+                    void bulk_load(uint64_t n, NEXT next, double fill = BULK_FILL_FACTOR) {
+                        if (!empty()) throw std::logic_error("bulk_load requiere un índice vacío");
+                        if (n == 0) return;
+                        const uint64_t t = (uint64_t)T(), maxk = 2*t - 1;
+                        uint64_t cap = (uint64_t)std::llround(fill * (double)maxk);
+                        cap = std::max<uint64_t>(std::min<uint64_t>(cap, maxk), std::max<uint64_t>(t - 1, 1));
+
+                        // Por nivel: N claves repartidas en L nodos; los L-1 separadores suben al nivel siguiente
+                        struct Level { uint64_t nodes, base, rem, j = 0; int k = 0, c = 0; Node cur; };
+                        std::vector<Level> lv;
+                        for (uint64_t N = n;;) {
+                            uint64_t L = 1;
+                            if (N > maxk) {
+                                L = (N + 1 + cap) / (cap + 1);
+                                L = std::max<uint64_t>(L, (N + 1 + 2*t - 1) / (2*t));
+                                L = std::min<uint64_t>(L, (N + 1) / t);
+                            }
+                            uint64_t per = N - (L - 1);
+                            Level l{L, per / L, per % L, 0, 0, 0, new_node()};
+                            l.cur.isLeaf() = lv.empty() ? 1 : 0;
+                            lv.push_back(std::move(l));
+                            if (L == 1) break;
+                            N = L - 1;
+                        }
+
+                        uint64_t root = 0;
+                        // cierra el nodo actual del nivel h y lo cuelga como hijo del nivel h+1
+                        auto finish_node = [&](size_t h) {
+                            Level& l = lv[h];
+                            l.cur.n() = (int16_t)l.k;
+                            uint64_t off = alloc_node();
+                            write_node(off, l.cur);
+                            bool leaf = (h == 0);
+                            l.cur = new_node(); l.cur.isLeaf() = leaf ? 1 : 0;
+                            l.k = 0; l.c = 0; l.j++;
+                            if (h + 1 < lv.size()) { Level& p = lv[h+1]; p.cur.child(p.c++) = off; }
+                            else root = off;
+                        };
+                        auto push = [&](const uint8_t* kb, int value) {
+                            size_t h = 0;
+                            // nodo completo: se cierra y la entrada sube como separador del padre
+                            while (h + 1 < lv.size() && (uint64_t)lv[h].k == lv[h].base + (lv[h].j < lv[h].rem ? 1 : 0)) finish_node(h++);
+                            Level& l = lv[h];
+                            std::memcpy(l.cur.key(l.k), kb, KBYTES);
+                            l.cur.page(l.k) = value;
+                            l.k++;
+                        };
+
+                        uint8_t kb[KBYTES]; int value = 0;
+                        uint64_t got = 0;
+                        while (got < n && next(kb, value)) { push(kb, value); ++got; }
+                        if (got != n) throw std::runtime_error("bulk_load: cantidad de entradas inconsistente");
+                        for (size_t h = 0; h < lv.size(); ++h) finish_node(h);
+                        header.root_off = root; sync_header();
+                    }
+
                     // Búsqueda exacta (retorna un value cualquiera si hay duplicados). -1 si no existe.
                     int search_get_value(const Key& k) const {
                         if (header.root_off == 0) return -1;
-                        return search_rec(header.root_off, k);
+                        uint8_t kb[KBYTES]; TRAITS::put(kb, k);
+                        return search_rec(header.root_off, kb);
                     }
 
                     // Rango: devuelve las CLAVES (útil para debug)
                     std::vector<Key> range_search_keys(const Key& a_in, const Key& b_in) const {
-                        Key a=a_in, b=b_in;
-                        if (cmp_key(a,b)>0) std::swap(a,b);
+                        uint8_t a[KBYTES], b[KBYTES];
+                        TRAITS::put(a, a_in); TRAITS::put(b, b_in);
+                        if (TRAITS::cmp_mem(a, b) > 0) std::swap(a, b);
                         std::vector<Key> out;
                         if (header.root_off==0) return out;
                         range_rec_keys(header.root_off, a, b, out);
@@ -220,23 +695,40 @@
 
                     // Rango: devuelve los VALUES (pageID) de cada entrada en [a,b] (incluye duplicados)
                     std::vector<int> range_search_values(const Key& a_in, const Key& b_in) const {
-                        Key a=a_in, b=b_in;
-                        if (cmp_key(a,b)>0) std::swap(a,b);
                         std::vector<int> out;
-                        if (header.root_off==0) return out;
-                        range_rec_values(header.root_off, a, b, out);
+                        range_scan(a_in, b_in, [&](const uint8_t*, int page) { out.push_back(page); return true; });
                         return out;
                     }
 
-                    // Borrado de una ocurrencia de la clave
-                    void remove_key(const Key& k) {
+                    // Rango: llama fn(key, page) por cada entrada en [a,b], en orden de clave (key en bruto,
+                    // comparable con TRAITS::cmp_mem); si fn devuelve false el recorrido termina ahí
+                    template<class FN>
+                    void range_scan(const Key& a_in, const Key& b_in, FN fn) const {
+                        uint8_t a[KBYTES], b[KBYTES];
+                        TRAITS::put(a, a_in); TRAITS::put(b, b_in);
+                        if (TRAITS::cmp_mem(a, b) > 0) std::swap(a, b);
                         if (header.root_off==0) return;
-                        remove_rec(header.root_off, k);
-                        NodeDisk root = read_node(header.root_off);
-                        if (root.n==0) {
-                            header.root_off = root.isLeaf ? 0 : root.children[0];
+                        range_rec_scan(header.root_off, a, b, fn);
+                    }
+
+                    // Borrado exacto de la entrada (key,value). Devuelve false si no existe.
+                    // Las claves iguales no quedan ordenadas por value: se recorre el tramo de la clave.
+                    bool remove(const Key& k, int value) {
+                        if (header.root_off==0) return false;
+                        uint8_t kb[KBYTES]; TRAITS::put(kb, k);
+                        if (!remove_rec(header.root_off, kb, value)) return false;
+                        Node root = read_node(header.root_off);
+                        if (root.n()==0) {
+                            header.root_off = root.isLeaf() ? 0 : root.child(0);
                             sync_header();
                         }
+                        return true;
+                    }
+
+                    // Borrado de una ocurrencia de la clave
+                    void remove_key(const Key& k) {
+                        int v = search_get_value(k);
+                        if (v != -1) remove(k, v);
                     }
 
                     // Debug
@@ -249,99 +741,89 @@
                     uint64_t root_offset() const { return header.root_off; }
 
                 private:
-                    Pager pager;
+                    NodeFile store;
                     FileHeader header{};
-                    uint64_t node_size = 0;
+                    NodeLayout layout;
 
-                    // Helpers de clave
-                    static int cmp_key(const Key& a, const Key& b) {
-                        uint8_t A[KBYTES], B[KBYTES];
-                        TRAITS::put(A,a); TRAITS::put(B,b);
-                        return TRAITS::cmp_mem(A,B);
+                    // Búsqueda en el nodo con la clave ya codificada (kb = bytes de TRAITS::put)
+                    template<class VIEW>
+                    static int lower_bound(const VIEW& x, const uint8_t* kb) {
+                        return NodeSearch<TRAITS>::lower_bound(x.key(0), x.n(), kb);
                     }
-                    static const void* key_as_bytes(const Key& a) {
-                        // solo para comparaciones puntuales (temporal)
-                        static thread_local uint8_t buf[KBYTES];
-                        TRAITS::put(buf, a); return buf;
+                    template<class VIEW>
+                    static int upper_bound(const VIEW& x, const uint8_t* kb) {
+                        return NodeSearch<TRAITS>::upper_bound(x.key(0), x.n(), kb);
                     }
 
                     // IO nodos
-                    uint64_t header_size() const { return sizeof(FileHeader); }
-                    void sync_header(){ pager.write_bytes(0, &header, sizeof(header)); }
-                    uint64_t alloc_node() {
-                        uint64_t off = pager.size();
-                        if (off < header_size()) off = header_size();
-                        NodeDisk blank{}; std::memset(&blank,0,sizeof(blank));
-                        pager.write_bytes(off, &blank, sizeof(blank));
-                        return off;
+                    void sync_header(){ store.write_header(&header, sizeof(header)); }
+                    Node new_node() const { return Node(layout); }
+                    uint64_t alloc_node() { return store.alloc(); }
+                    PageGuard pin_node(uint64_t off) const { return store.pin(off); }
+                    NodeView view(const PageGuard& g) const { return NodeView(g.data(), layout); }
+                    Node read_node(uint64_t off) const {
+                        Node n = new_node(); store.read(off, n.bytes()); return n;
                     }
-                    NodeDisk read_node(uint64_t off) const {
-                        NodeDisk n{}; const_cast<Pager&>(pager).read_bytes(off, &n, sizeof(n)); return n;
-                    }
-                    void write_node(uint64_t off, const NodeDisk& n){ pager.write_bytes(off, &n, sizeof(n)); }
+                    void write_node(uint64_t off, const Node& n){ store.write(off, n.bytes()); }
 
                     // ---------- SEARCH ----------
-                    int search_rec(uint64_t x_off, const Key& k) const {
-                        NodeDisk x = read_node(x_off);
-                        int i=0;
-                        while (i<x.n && TRAITS::cmp_mem(x.keys[i], key_as_bytes(k)) < 0) ++i;
-                        if (i<x.n && TRAITS::cmp_mem(x.keys[i], key_as_bytes(k)) == 0) return x.pages[i];
-                        if (x.isLeaf) return -1;
-                        return search_rec(x.children[i], k);
+                    int search_rec(uint64_t x_off, const uint8_t* kb) const {
+                        PageGuard g = pin_node(x_off);
+                        NodeView x = view(g);
+                        int i = lower_bound(x, kb);
+                        if (i<x.n() && TRAITS::cmp_mem(x.key(i), kb) == 0) return x.page(i);
+                        if (x.isLeaf()) return -1;
+                        return search_rec(x.child(i), kb);
                     }
 
                     // ---------- INSERT ----------
-                    void insert_non_full(uint64_t x_off, const Key& k, int value) {
-                        NodeDisk x = read_node(x_off);
-                        int i = x.n - 1;
-                        if (x.isLeaf) {
-                            while (i>=0 && TRAITS::cmp_mem(x.keys[i], key_as_bytes(k)) > 0) {
-                                std::memcpy(x.keys[i+1], x.keys[i], KBYTES);
-                                x.pages[i+1] = x.pages[i];
-                                --i;
-                            }
-                            TRAITS::put(x.keys[i+1], k);
-                            x.pages[i+1] = value;
-                            x.n++; write_node(x_off, x);
+                    void insert_non_full(uint64_t x_off, const uint8_t* kb, int value) {
+                        Node x = read_node(x_off);
+                        int i = upper_bound(x, kb);
+                        if (x.isLeaf()) {
+                            int n = x.n();
+                            std::memmove(x.key(i+1), x.key(i), (size_t)(n - i) * KBYTES);
+                            std::memmove(&x.page(i+1), &x.page(i), (size_t)(n - i) * sizeof(int32_t));
+                            std::memcpy(x.key(i), kb, KBYTES);
+                            x.page(i) = value;
+                            x.n()++; write_node(x_off, x);
                         } else {
-                            while (i>=0 && TRAITS::cmp_mem(x.keys[i], key_as_bytes(k)) > 0) --i;
-                            ++i;
-                            NodeDisk child = read_node(x.children[i]);
-                            if (child.n == 2*T()-1) {
-                                split_child(x_off, i, x.children[i]);
+                            Node child = read_node(x.child(i));
+                            if (child.n() == 2*T()-1) {
+                                split_child(x_off, i, x.child(i));
                                 x = read_node(x_off);
-                                if (TRAITS::cmp_mem(x.keys[i], key_as_bytes(k)) < 0) ++i;
+                                if (TRAITS::cmp_mem(x.key(i), kb) < 0) ++i;
                             }
-                            insert_non_full(x.children[i], k, value);
+                            insert_non_full(x.child(i), kb, value);
                         }
                     }
 
                     void split_child(uint64_t x_off, int i, uint64_t y_off) {
-                        NodeDisk x = read_node(x_off);
-                        NodeDisk y = read_node(y_off);
+                        Node x = read_node(x_off);
+                        Node y = read_node(y_off);
 
                         uint64_t z_off = alloc_node();
-                        NodeDisk z{}; z.isLeaf = y.isLeaf; z.n = T()-1;
+                        Node z = new_node(); z.isLeaf() = y.isLeaf(); z.n() = T()-1;
 
                         for (int j=0;j<T()-1;++j) {
-                            std::memcpy(z.keys[j], y.keys[j+T()], KBYTES);
-                            z.pages[j] = y.pages[j+T()];
+                            std::memcpy(z.key(j), y.key(j+T()), KBYTES);
+                            z.page(j) = y.page(j+T());
                         }
-                        if (!y.isLeaf) {
-                            for (int j=0;j<T();++j) z.children[j] = y.children[j+T()];
+                        if (!y.isLeaf()) {
+                            for (int j=0;j<T();++j) z.child(j) = y.child(j+T());
                         }
-                        y.n = T()-1;
+                        y.n() = T()-1;
 
-                        for (int j=x.n;j>=i+1;--j) x.children[j+1] = x.children[j];
-                        x.children[i+1] = z_off;
+                        for (int j=x.n();j>=i+1;--j) x.child(j+1) = x.child(j);
+                        x.child(i+1) = z_off;
 
-                        for (int j=x.n-1;j>=i;--j) {
-                            std::memcpy(x.keys[j+1], x.keys[j], KBYTES);
-                            x.pages[j+1] = x.pages[j];
+                        for (int j=x.n()-1;j>=i;--j) {
+                            std::memcpy(x.key(j+1), x.key(j), KBYTES);
+                            x.page(j+1) = x.page(j);
                         }
-                        std::memcpy(x.keys[i], y.keys[T()-1], KBYTES);
-                        x.pages[i] = y.pages[T()-1];
-                        x.n++;
+                        std::memcpy(x.key(i), y.key(T()-1), KBYTES);
+                        x.page(i) = y.page(T()-1);
+                        x.n()++;
 
                         write_node(y_off, y);
                         write_node(z_off, z);
@@ -349,211 +831,229 @@
                     }
 
                     // ---------- RANGE: KEYS ----------
-                    void range_rec_keys(uint64_t x_off, const Key& a, const Key& b, std::vector<Key>& out) const {
-                        NodeDisk x = read_node(x_off);
-                        if (x.isLeaf) {
-                            for (int i=0;i<x.n;++i) {
-                                if (TRAITS::cmp_mem(x.keys[i], key_as_bytes(a)) < 0) continue;
-                                if (TRAITS::cmp_mem(x.keys[i], key_as_bytes(b)) > 0) break;
-                                Key k{}; TRAITS::get(x.keys[i], k); out.emplace_back(k);
+                    // Los hijos a la izquierda de lower_bound(a) solo tienen claves < a: no se visitan.
+                    void range_rec_keys(uint64_t x_off, const uint8_t* a, const uint8_t* b, std::vector<Key>& out) const {
+                        PageGuard g = pin_node(x_off);
+                        NodeView x = view(g);
+                        int i = lower_bound(x, a);
+                        if (x.isLeaf()) {
+                            for (; i<x.n() && TRAITS::cmp_mem(x.key(i), b) <= 0; ++i) {
+                                Key k{}; TRAITS::get(x.key(i), k); out.emplace_back(k);
                             }
                             return;
                         }
-                        int i=0;
-                        while (i<x.n && TRAITS::cmp_mem(x.keys[i], key_as_bytes(a)) < 0) {
-                            range_rec_keys(x.children[i], a, b, out); ++i;
-                        }
-                        if (i<x.n) range_rec_keys(x.children[i], a, b, out);
-                        while (i<x.n && TRAITS::cmp_mem(x.keys[i], key_as_bytes(b)) <= 0) {
-                            Key k{}; TRAITS::get(x.keys[i], k); out.emplace_back(k);
-                            range_rec_keys(x.children[i+1], a, b, out); ++i;
+                        range_rec_keys(x.child(i), a, b, out);
+                        while (i<x.n() && TRAITS::cmp_mem(x.key(i), b) <= 0) {
+                            Key k{}; TRAITS::get(x.key(i), k); out.emplace_back(k);
+                            range_rec_keys(x.child(i+1), a, b, out); ++i;
                         }
                     }
 
-                    // ---------- RANGE: VALUES ----------
-                    void range_rec_values(uint64_t x_off, const Key& a, const Key& b, std::vector<int>& out) const {
-                        NodeDisk x = read_node(x_off);
-                        if (x.isLeaf) {
-                            for (int i=0;i<x.n;++i) {
-                                if (TRAITS::cmp_mem(x.keys[i], key_as_bytes(a)) < 0) continue;
-                                if (TRAITS::cmp_mem(x.keys[i], key_as_bytes(b)) > 0) break;
-                                out.emplace_back(x.pages[i]);
+                    // ---------- RANGE: ENTRADAS ----------
+                    // Los hijos a la izquierda de lower_bound(a) solo tienen claves < a: no se visitan.
+                    // Devuelve false si fn cortó el recorrido.
+                    template<class FN>
+                    bool range_rec_scan(uint64_t x_off, const uint8_t* a, const uint8_t* b, FN& fn) const {
+                        PageGuard g = pin_node(x_off);
+                        NodeView x = view(g);
+                        int i = lower_bound(x, a);
+                        if (x.isLeaf()) {
+                            for (; i<x.n() && TRAITS::cmp_mem(x.key(i), b) <= 0; ++i) {
+                                if (!fn(x.key(i), (int)x.page(i))) return false;
                             }
-                            return;
-                        }
-                        int i=0;
-                        while (i<x.n && TRAITS::cmp_mem(x.keys[i], key_as_bytes(a)) < 0) {
-                            range_rec_values(x.children[i], a, b, out); ++i;
+                            return true;
                         }
-                        if (i<x.n) range_rec_values(x.children[i], a, b, out);
-                        while (i<x.n && TRAITS::cmp_mem(x.keys[i], key_as_bytes(b)) <= 0) {
-                            out.emplace_back(x.pages[i]);
-                            range_rec_values(x.children[i+1], a, b, out); ++i;
+                        if (!range_rec_scan(x.child(i), a, b, fn)) return false;
+                        while (i<x.n() && TRAITS::cmp_mem(x.key(i), b) <= 0) {
+                            if (!fn(x.key(i), (int)x.page(i))) return false;
+                            if (!range_rec_scan(x.child(i+1), a, b, fn)) return false;
+                            ++i;
                         }
+                        return true;
                     }
 
                     // ---------- DELETE ----------
-                    void remove_rec(uint64_t x_off, const Key& k) {
-                        NodeDisk x = read_node(x_off);
-                        int idx=0;
-                        while (idx<x.n && TRAITS::cmp_mem(x.keys[idx], key_as_bytes(k)) < 0) ++idx;
-
-                        if (idx<x.n && TRAITS::cmp_mem(x.keys[idx], key_as_bytes(k)) == 0) {
-                            if (x.isLeaf) { remove_from_leaf(x_off, x, idx); }
-                            else          { remove_from_non_leaf(x_off, x, idx); }
-                        } else {
-                            if (x.isLeaf) return;
-                            bool flag = (idx == x.n);
-                            NodeDisk child = read_node(x.children[idx]);
-                            if (child.n < T()) { fill(x_off, x, idx); x = read_node(x_off); }
-                            if (flag && idx > x.n) { uint64_t ch = read_node(x_off).children[idx-1]; remove_rec(ch, k); }
-                            else { uint64_t ch = read_node(x_off).children[idx]; remove_rec(ch, k); }
-                        }
-                    }
-
-                    void remove_from_leaf(uint64_t x_off, NodeDisk x, int idx) {
-                        for (int i=idx+1;i<x.n;++i) {
-                            std::memcpy(x.keys[i-1], x.keys[i], KBYTES);
-                            x.pages[i-1] = x.pages[i];
-                        }
-                        x.n--; write_node(x_off, x);
-                    }
-
-                    std::pair<Key,int> get_predecessor(uint64_t child_off) {
-                        NodeDisk cur = read_node(child_off);
-                        while (!cur.isLeaf) { child_off = cur.children[cur.n]; cur = read_node(child_off); }
-                        Key k{}; TRAITS::get(cur.keys[cur.n-1], k); return {k, cur.pages[cur.n-1]};
-                    }
-                    std::pair<Key,int> get_successor(uint64_t child_off) {
-                        NodeDisk cur = read_node(child_off);
-                        while (!cur.isLeaf) { child_off = cur.children[0]; cur = read_node(child_off); }
-                        Key k{}; TRAITS::get(cur.keys[0], k); return {k, cur.pages[0]};
-                    }
-
-                    void remove_from_non_leaf(uint64_t x_off, NodeDisk x, int idx) {
-                        uint64_t y_off = x.children[idx];
-                        uint64_t z_off = x.children[idx+1];
-                        NodeDisk y = read_node(y_off);
-                        NodeDisk z = read_node(z_off);
-
-                        if (y.n >= T()) {
-                            auto pred = get_predecessor(y_off);
-                            TRAITS::put(x.keys[idx], pred.first);
-                            x.pages[idx] = pred.second; write_node(x_off, x);
-                            remove_rec(y_off, pred.first);
-                        } else if (z.n >= T()) {
-                            auto succ = get_successor(z_off);
-                            TRAITS::put(x.keys[idx], succ.first);
-                            x.pages[idx] = succ.second; write_node(x_off, x);
-                            remove_rec(z_off, succ.first);
+                    // Baja por el hijo que contiene (kb,value), rellenándolo antes si tiene < T() claves.
+                    // Con duplicados la entrada puede estar en cualquier hijo entre lower_bound y
+                    // upper_bound; tras fill se vuelve a buscar porque el nodo puede haber cambiado.
+                    bool remove_rec(uint64_t x_off, const uint8_t* kb, int value) {
+                        for (;;) {
+                            Node x = read_node(x_off);
+                            const int lo = lower_bound(x, kb), hi = upper_bound(x, kb);
+                            for (int i = lo; i < hi; ++i) {
+                                if (x.page(i) != value) continue;
+                                if (x.isLeaf()) remove_from_leaf(x_off, x, i);
+                                else            remove_from_non_leaf(x_off, x, i);
+                                return true;
+                            }
+                            if (x.isLeaf()) return false;
+                            int c = lo;
+                            while (c <= hi && !contains(x.child(c), kb, value)) ++c;
+                            if (c > hi) return false;
+                            if (read_node(x.child(c)).n() >= T()) { x_off = x.child(c); continue; }
+                            fill(x_off, x, c);
+                        }
+                    }
+
+                    // ¿Está (kb,value) en el subárbol? Solo visita el tramo de claves iguales a kb.
+                    bool contains(uint64_t x_off, const uint8_t* kb, int value) const {
+                        PageGuard g = pin_node(x_off);
+                        NodeView x = view(g);
+                        const int lo = lower_bound(x, kb), hi = upper_bound(x, kb);
+                        for (int i = lo; i < hi; ++i) if ((int)x.page(i) == value) return true;
+                        if (x.isLeaf()) return false;
+                        for (int c = lo; c <= hi; ++c) if (contains(x.child(c), kb, value)) return true;
+                        return false;
+                    }
+
+                    void remove_from_leaf(uint64_t x_off, Node x, int idx) {
+                        int n = x.n();
+                        std::memmove(x.key(idx), x.key(idx+1), (size_t)(n - idx - 1) * KBYTES);
+                        std::memmove(&x.page(idx), &x.page(idx+1), (size_t)(n - idx - 1) * sizeof(int32_t));
+                        x.n()--; write_node(x_off, x);
+                    }
+
+                    // Copian la clave (ya codificada) en kb_out y devuelven su value
+                    int get_predecessor(uint64_t child_off, uint8_t* kb_out) {
+                        Node cur = read_node(child_off);
+                        while (!cur.isLeaf()) { child_off = cur.child(cur.n()); cur = read_node(child_off); }
+                        std::memcpy(kb_out, cur.key(cur.n()-1), KBYTES); return cur.page(cur.n()-1);
+                    }
+                    int get_successor(uint64_t child_off, uint8_t* kb_out) {
+                        Node cur = read_node(child_off);
+                        while (!cur.isLeaf()) { child_off = cur.child(0); cur = read_node(child_off); }
+                        std::memcpy(kb_out, cur.key(0), KBYTES); return cur.page(0);
+                    }
+
+                    // El predecesor/sucesor sube a x y se borra exactamente esa entrada del subárbol
+                    // (no otra con la misma clave, que dejaría un value duplicado y otro perdido)
+                    void remove_from_non_leaf(uint64_t x_off, Node x, int idx) {
+                        uint64_t y_off = x.child(idx);
+                        uint64_t z_off = x.child(idx+1);
+                        Node y = read_node(y_off);
+                        Node z = read_node(z_off);
+
+                        uint8_t kb[KBYTES];
+                        if (y.n() >= T()) {
+                            int pred = get_predecessor(y_off, kb);
+                            std::memcpy(x.key(idx), kb, KBYTES);
+                            x.page(idx) = pred; write_node(x_off, x);
+                            remove_rec(y_off, kb, pred);
+                        } else if (z.n() >= T()) {
+                            int succ = get_successor(z_off, kb);
+                            std::memcpy(x.key(idx), kb, KBYTES);
+                            x.page(idx) = succ; write_node(x_off, x);
+                            remove_rec(z_off, kb, succ);
                         } else {
+                            std::memcpy(kb, x.key(idx), KBYTES);
+                            const int value = x.page(idx);
                             merge(x_off, x, idx);
-                            uint64_t merged_off = read_node(x_off).children[idx];
-                            Key k{}; TRAITS::get(x.keys[idx], k);
-                            remove_rec(merged_off, k);
+                            uint64_t merged_off = read_node(x_off).child(idx);
+                            remove_rec(merged_off, kb, value);
                         }
                     }
 
-                    void fill(uint64_t x_off, NodeDisk x, int idx) {
+                    void fill(uint64_t x_off, Node x, int idx) {
                         if (idx != 0) {
-                            NodeDisk left = read_node(x.children[idx-1]);
-                            if (left.n >= T()) { borrow_from_prev(x_off, x, idx); return; }
+                            Node left = read_node(x.child(idx-1));
+                            if (left.n() >= T()) { borrow_from_prev(x_off, x, idx); return; }
                         }
-                        if (idx != x.n) {
-                            NodeDisk right = read_node(x.children[idx+1]);
-                            if (right.n >= T()) { borrow_from_next(x_off, x, idx); return; }
+                        if (idx != x.n()) {
+                            Node right = read_node(x.child(idx+1));
+                            if (right.n() >= T()) { borrow_from_next(x_off, x, idx); return; }
                         }
-                        if (idx != x.n) merge(x_off, x, idx);
+                        if (idx != x.n()) merge(x_off, x, idx);
                         else merge(x_off, x, idx-1);
                     }
 
-                    void borrow_from_prev(uint64_t x_off, NodeDisk x, int idx) {
-                        uint64_t child_off = x.children[idx];
-                        uint64_t sib_off   = x.children[idx-1];
-                        NodeDisk child = read_node(child_off);
-                        NodeDisk sib   = read_node(sib_off);
+                    void borrow_from_prev(uint64_t x_off, Node x, int idx) {
+                        uint64_t child_off = x.child(idx);
+                        uint64_t sib_off   = x.child(idx-1);
+                        Node child = read_node(child_off);
+                        Node sib   = read_node(sib_off);
 
-                        for (int i=child.n-1;i>=0;--i) {
-                            std::memcpy(child.keys[i+1], child.keys[i], KBYTES);
-                            child.pages[i+1] = child.pages[i];
+                        for (int i=child.n()-1;i>=0;--i) {
+                            std::memcpy(child.key(i+1), child.key(i), KBYTES);
+                            child.page(i+1) = child.page(i);
                         }
-                        if (!child.isLeaf) {
-                            for (int i=child.n;i>=0;--i) child.children[i+1] = child.children[i];
+                        if (!child.isLeaf()) {
+                            for (int i=child.n();i>=0;--i) child.child(i+1) = child.child(i);
                         }
-                        std::memcpy(child.keys[0], x.keys[idx-1], KBYTES);
-                        child.pages[0] = x.pages[idx-1];
-                        if (!child.isLeaf) child.children[0] = sib.children[sib.n];
+                        std::memcpy(child.key(0), x.key(idx-1), KBYTES);
+                        child.page(0) = x.page(idx-1);
+                        if (!child.isLeaf()) child.child(0) = sib.child(sib.n());
 
-                        std::memcpy(x.keys[idx-1], sib.keys[sib.n-1], KBYTES);
-                        x.pages[idx-1] = sib.pages[sib.n-1];
+                        std::memcpy(x.key(idx-1), sib.key(sib.n()-1), KBYTES);
+                        x.page(idx-1) = sib.page(sib.n()-1);
 
-                        child.n += 1; sib.n -= 1;
+                        child.n() += 1; sib.n() -= 1;
                         write_node(child_off, child); write_node(sib_off, sib); write_node(x_off, x);
                     }
 
-                    void borrow_from_next(uint64_t x_off, NodeDisk x, int idx) {
-                        uint64_t child_off = x.children[idx];
-                        uint64_t sib_off   = x.children[idx+1];
-                        NodeDisk child = read_node(child_off);
-                        NodeDisk sib   = read_node(sib_off);
+                    void borrow_from_next(uint64_t x_off, Node x, int idx) {
+                        uint64_t child_off = x.child(idx);
+                        uint64_t sib_off   = x.child(idx+1);
+                        Node child = read_node(child_off);
+                        Node sib   = read_node(sib_off);
 
-                        std::memcpy(child.keys[child.n], x.keys[idx], KBYTES);
-                        child.pages[child.n] = x.pages[idx];
-                        if (!child.isLeaf) child.children[child.n+1] = sib.children[0];
+                        std::memcpy(child.key(child.n()), x.key(idx), KBYTES);
+                        child.page(child.n()) = x.page(idx);
+                        if (!child.isLeaf()) child.child(child.n()+1) = sib.child(0);
 
-                        std::memcpy(x.keys[idx], sib.keys[0], KBYTES);
-                        x.pages[idx] = sib.pages[0];
+                        std::memcpy(x.key(idx), sib.key(0), KBYTES);
+                        x.page(idx) = sib.page(0);
 
-                        for (int i=1;i<sib.n;++i) {
-                            std::memcpy(sib.keys[i-1], sib.keys[i], KBYTES);
-                            sib.pages[i-1] = sib.pages[i];
+                        for (int i=1;i<sib.n();++i) {
+                            std::memcpy(sib.key(i-1), sib.key(i), KBYTES);
+                            sib.page(i-1) = sib.page(i);
                         }
-                        if (!sib.isLeaf) {
-                            for (int i=1;i<=sib.n;++i) sib.children[i-1] = sib.children[i];
+                        if (!sib.isLeaf()) {
+                            for (int i=1;i<=sib.n();++i) sib.child(i-1) = sib.child(i);
                         }
-                        child.n += 1; sib.n -= 1;
+                        child.n() += 1; sib.n() -= 1;
 
                         write_node(child_off, child); write_node(sib_off, sib); write_node(x_off, x);
                     }
 
-                    void merge(uint64_t x_off, NodeDisk x, int idx) {
-                        uint64_t c_off = x.children[idx];
-                        uint64_t s_off = x.children[idx+1];
-                        NodeDisk c = read_node(c_off);
-                        NodeDisk s = read_node(s_off);
+                    void merge(uint64_t x_off, Node x, int idx) {
+                        uint64_t c_off = x.child(idx);
+                        uint64_t s_off = x.child(idx+1);
+                        Node c = read_node(c_off);
+                        Node s = read_node(s_off);
 
-                        std::memcpy(c.keys[T()-1], x.keys[idx], KBYTES);
-                        c.pages[T()-1] = x.pages[idx];
+                        std::memcpy(c.key(T()-1), x.key(idx), KBYTES);
+                        c.page(T()-1) = x.page(idx);
 
-                        for (int i=0;i<s.n;++i) {
-                            std::memcpy(c.keys[i+T()], s.keys[i], KBYTES);
-                            c.pages[i+T()] = s.pages[i];
+                        for (int i=0;i<s.n();++i) {
+                            std::memcpy(c.key(i+T()), s.key(i), KBYTES);
+                            c.page(i+T()) = s.page(i);
                         }
-                        if (!c.isLeaf) {
-                            for (int i=0;i<=s.n;++i) c.children[i+T()] = s.children[i];
+                        if (!c.isLeaf()) {
+                            for (int i=0;i<=s.n();++i) c.child(i+T()) = s.child(i);
                         }
-                        c.n += s.n + 1;
+                        c.n() += s.n() + 1;
 
-                        for (int i=idx+1;i<x.n;++i) {
-                            std::memcpy(x.keys[i-1], x.keys[i], KBYTES);
-                            x.pages[i-1] = x.pages[i];
+                        for (int i=idx+1;i<x.n();++i) {
+                            std::memcpy(x.key(i-1), x.key(i), KBYTES);
+                            x.page(i-1) = x.page(i);
                         }
-                        for (int i=idx+2;i<=x.n;++i) x.children[i-1] = x.children[i];
-                        x.n--;
+                        for (int i=idx+2;i<=x.n();++i) x.child(i-1) = x.child(i);
+                        x.n()--;
 
                         write_node(c_off, c);
                         write_node(x_off, x);
                     }
 
                     void traverse_rec(uint64_t x_off, int level, int index) const {
-                        NodeDisk x = read_node(x_off);
+                        PageGuard g = pin_node(x_off);
+                        NodeView x = view(g);
                         std::cout << std::string(level*2,' ') << "Nivel " << level
-                                  << " (n="<<x.n<<", leaf="<<int(x.isLeaf)<<") keys: ";
-                        for (int i=0;i<x.n;++i) {
-                            std::cout << TRAITS::to_string(x.keys[i]) << "(" << x.pages[i] << ") ";
+                                  << " (n="<<x.n()<<", leaf="<<int(x.isLeaf())<<") keys: ";
+                        for (int i=0;i<x.n();++i) {
+                            std::cout << TRAITS::to_string(x.key(i)) << "(" << x.page(i) << ") ";
                         }
                         std::cout << "\n";
-                        if (!x.isLeaf) for (int i=0;i<=x.n;++i) traverse_rec(x.children[i], level+1, i);
+                        if (!x.isLeaf()) for (int i=0;i<=x.n();++i) traverse_rec(x.child(i), level+1, i);
                     }
                 };
 
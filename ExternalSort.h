@@ -0,0 +1,187 @@
+// ExternalSort.h
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <queue>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+// =================== CONFIG ===================
+#define EXTSORT_MEM_MB 64     // memoria por defecto del ordenamiento antes de volcar corridas a disco
+#define EXTSORT_MAX_FANIN 64  // máximo de corridas abiertas a la vez al mezclar
+// ==============================================
+
+namespace extsort {
+
+// Ordenamiento externo de registros de tamaño fijo (tamaño decidido en tiempo de ejecución).
+// Los registros se acumulan en un buffer de memoria acotado; al llenarse se ordenan y se
+// vuelcan como una corrida a un archivo temporal. Al terminar se mezclan las corridas (k-way,
+// en varias pasadas si superan EXTSORT_MAX_FANIN) y se entregan en orden con next().
+// Si todo cabe en memoria no se toca el disco.
+//
+// Uso:  ExternalSorter<LESS> s(rec_size, less, "/tmp/dir/prefijo");
+//       s.add(rec) ...;  s.finish();  while (auto* r = s.next()) { ... }
+template<class LESS>
+class ExternalSorter {
+public:
+    // less(a,b): orden estricto sobre punteros a registros de rec_size bytes.
+    // tmp_prefix: ruta + prefijo de los archivos de corrida (se borran al destruir).
+    ExternalSorter(size_t rec_size, LESS less, std::string tmp_prefix,
+                   size_t mem_bytes = (size_t)EXTSORT_MEM_MB << 20)
+        : rec(rec_size), lt(less), prefix(std::move(tmp_prefix)) {
+        if (rec == 0) throw std::invalid_argument("rec_size debe ser > 0");
+        // cada registro en memoria ocupa rec bytes + 4 del índice de orden
+        cap = std::max<size_t>(mem_bytes / (rec + sizeof(uint32_t)), 1024);
+        cap = std::min<size_t>(cap, UINT32_MAX);
+    }
+    ~ExternalSorter() {
+        for (auto& r : readers) if (r.f) std::fclose(r.f);
+        for (auto& f : runs) std::remove(f.c_str());
+    }
+    ExternalSorter(const ExternalSorter&) = delete;
+    ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+    void add(const void* r) {
+        if (finished) throw std::logic_error("ExternalSorter: add() después de finish()");
+        if (nbuf == cap) spill();
+        if (buf.size() < (nbuf + 1) * rec) buf.resize(std::min(cap, std::max<size_t>(nbuf * 2, 1024)) * rec);
+        std::memcpy(buf.data() + nbuf * rec, r, rec);
+        ++nbuf; ++total;
+    }
+
+    uint64_t size() const { return total; }
+    size_t runs_spilled() const { return nspilled; }
+
+    // Cierra la entrada y prepara la lectura ordenada
+    void finish() {
+        if (finished) return;
+        finished = true;
+        if (runs.empty()) { sort_buffer(); pos = 0; return; }
+        if (nbuf) spill();
+        std::vector<uint8_t>().swap(buf);
+        std::vector<uint32_t>().swap(order);
+        // pasadas intermedias hasta que las corridas quepan en una sola mezcla
+        while (runs.size() > EXTSORT_MAX_FANIN) {
+            std::vector<std::string> next_runs;
+            for (size_t i = 0; i < runs.size(); i += EXTSORT_MAX_FANIN) {
+                size_t j = std::min(runs.size(), i + EXTSORT_MAX_FANIN);
+                std::vector<std::string> group(runs.begin() + i, runs.begin() + j);
+                if (group.size() == 1) { next_runs.push_back(group[0]); continue; }
+                std::string out = new_run_name();
+                std::FILE* f = open_run(out, "wb");
+                open_readers(group);
+                while (const uint8_t* r = merge_next()) write_rec(f, r);
+                close_readers();
+                std::fclose(f);
+                for (auto& g : group) std::remove(g.c_str());
+                next_runs.push_back(out);
+            }
+            runs.swap(next_runs);
+        }
+        open_readers(runs);
+    }
+
+    // Siguiente registro en orden; nullptr al terminar. El puntero vale hasta la próxima llamada.
+    const uint8_t* next() {
+        if (!finished) finish();
+        if (readers.empty()) {
+            if (pos >= nbuf) return nullptr;
+            return buf.data() + (size_t)order[pos++] * rec;
+        }
+        return merge_next();
+    }
+
+private:
+    struct Reader {
+        std::FILE* f = nullptr;
+        std::vector<uint8_t> cur;   // registro actual
+    };
+
+    size_t rec;
+    LESS lt;
+    std::string prefix;
+    size_t cap = 0;                 // registros que caben en memoria
+    std::vector<uint8_t> buf;
+    std::vector<uint32_t> order;
+    size_t nbuf = 0, pos = 0;
+    uint64_t total = 0;
+    size_t nspilled = 0, run_seq = 0;
+    bool finished = false;
+    std::vector<std::string> runs;
+    std::vector<Reader> readers;
+    std::vector<size_t> heap;       // índices de readers (montículo de mínimos)
+    std::vector<uint8_t> last;      // último registro entregado por la mezcla
+
+    void sort_buffer() {
+        order.resize(nbuf);
+        std::iota(order.begin(), order.end(), 0u);
+        const uint8_t* base = buf.data();
+        const size_t r = rec;
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return lt(base + (size_t)a * r, base + (size_t)b * r);
+        });
+    }
+
+    std::string new_run_name() { return prefix + ".run" + std::to_string(run_seq++) + ".tmp"; }
+
+    std::FILE* open_run(const std::string& path, const char* mode) {
+        std::FILE* f = std::fopen(path.c_str(), mode);
+        if (!f) throw std::runtime_error("No se pudo abrir archivo temporal: " + path);
+        std::setvbuf(f, nullptr, _IOFBF, 1<<20);
+        return f;
+    }
+    void write_rec(std::FILE* f, const uint8_t* r) {
+        if (std::fwrite(r, 1, rec, f) != rec) throw std::runtime_error("Error al escribir corrida temporal");
+    }
+
+    // Ordena el buffer y lo vuelca como una corrida nueva
+    void spill() {
+        sort_buffer();
+        std::string path = new_run_name();
+        runs.push_back(path);
+        std::FILE* f = open_run(path, "wb");
+        for (size_t i = 0; i < nbuf; ++i) write_rec(f, buf.data() + (size_t)order[i] * rec);
+        std::fclose(f);
+        nbuf = 0; ++nspilled;
+    }
+
+    // ---------- mezcla k-way ----------
+    bool heap_less(size_t a, size_t b) const {   // "a sale después que b" para std::*_heap
+        return lt(readers[b].cur.data(), readers[a].cur.data());
+    }
+    bool advance(Reader& r) {
+        return std::fread(r.cur.data(), 1, rec, r.f) == rec;
+    }
+    void open_readers(const std::vector<std::string>& files) {
+        readers.clear(); heap.clear();
+        readers.resize(files.size());
+        for (size_t i = 0; i < files.size(); ++i) {
+            readers[i].f = open_run(files[i], "rb");
+            readers[i].cur.resize(rec);
+            if (advance(readers[i])) heap.push_back(i);
+        }
+        auto cmp = [this](size_t a, size_t b) { return heap_less(a, b); };
+        std::make_heap(heap.begin(), heap.end(), cmp);
+        last.resize(rec);
+    }
+    void close_readers() {
+        for (auto& r : readers) if (r.f) { std::fclose(r.f); r.f = nullptr; }
+        readers.clear(); heap.clear();
+    }
+    const uint8_t* merge_next() {
+        if (heap.empty()) return nullptr;
+        auto cmp = [this](size_t a, size_t b) { return heap_less(a, b); };
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        size_t i = heap.back();
+        std::memcpy(last.data(), readers[i].cur.data(), rec);
+        if (advance(readers[i])) std::push_heap(heap.begin(), heap.end(), cmp);
+        else heap.pop_back();
+        return last.data();
+    }
+};
+
+} // namespace extsort
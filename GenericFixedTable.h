@@ -1,6 +1,7 @@
 // GenericFixedTable.h
 #pragma once
 #include <cstdint>
+#include <cstddef>
 #include <fstream>
 #include <vector>
 #include <string>
@@ -9,11 +10,56 @@
 #include <iostream>
 #include <algorithm>
 #include <filesystem>
+#include <string_view>
+#include <chrono>
+
+// =================== CONFIG ===================
+#ifndef GFT_MMAP
+#define GFT_MMAP 1  // 1: lecturas de filas vía archivo mapeado en memoria (EnableMmap(false) lo desactiva)
+#endif
+#define GFT_DEL_PAGE 4096  // flags de tombstone (bytes del .del) por página escrita de vuelta
+#define GFT_FETCH_GAP_KB 64  // lectura por pageIDs: huecos menores que esto se leen junto con el tramo
+// ==============================================
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace gft {
 
 namespace fs = std::filesystem;
 
+namespace detail {
+inline int popcount64(uint64_t x) {
+#if defined(_MSC_VER)
+    return (int)__popcnt64(x);
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+inline int ctz64(uint64_t x) {  // x != 0
+#if defined(_MSC_VER)
+    unsigned long i; _BitScanForward64(&i, x); return (int)i;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+} // namespace detail
+
 // Tipos de columna
 enum class ColType : int32_t { INT32=1, FLOAT32=2, CHAR=3 };
 
@@ -41,7 +87,7 @@ struct FileHeader {
     char     table_name[32];
     int32_t  ncols;
     int32_t  row_size;      // bytes por registro
-    int32_t  reserved;
+    int32_t  nrows;         // filas al último Checkpoint, se valida al abrir (antes 'reserved'; 0 en archivos viejos)
 };
 #pragma pack(pop)
 
@@ -54,6 +100,48 @@ struct ColMetaDisk {
 };
 #pragma pack(pop)
 
+// Vista sin copia sobre los bytes de una fila empaquetada (no posee memoria).
+// Los accesores leen solo los bytes de la columna pedida y no reservan memoria;
+// la vista vale mientras vivan los bytes subyacentes (ver RowPtr/ScanRows/ViewRowByPageID).
+class RowView {
+public:
+    RowView() = default;
+    RowView(const char* data, const ColMetaDisk* cols, int ncols) : p(data), c(cols), n(ncols) {}
+
+    bool        valid() const { return p != nullptr; }
+    const char* data()  const { return p; }
+    int         ncols() const { return n; }
+    ColType     type(int col) const { return (ColType)c[col].type; }
+
+    int32_t get_int(int col) const   { int32_t x; std::memcpy(&x, p + c[col].offset, 4); return x; }
+    float   get_float(int col) const { float x;   std::memcpy(&x, p + c[col].offset, 4); return x; }
+    // CHAR hasta el primer '\0' (o el ancho completo)
+    std::string_view get_char_view(int col) const {
+        const char* q = p + c[col].offset;
+        const void* z = std::memchr(q, '\0', (size_t)c[col].width);
+        return std::string_view(q, z ? (size_t)(static_cast<const char*>(z) - q) : (size_t)c[col].width);
+    }
+
+    // Materializa una columna / la fila completa (para quien necesite Value)
+    Value get(int col) const {
+        switch (type(col)) {
+        case ColType::INT32:   return Value::Int(get_int(col));
+        case ColType::FLOAT32: return Value::Flt(get_float(col));
+        case ColType::CHAR:    return Value::Chr(std::string(get_char_view(col)));
+        default: throw std::runtime_error("Tipo no soportado");
+        }
+    }
+    void to_values(std::vector<Value>& out) const {
+        out.clear(); out.reserve(n);
+        for (int i=0;i<n;++i) out.push_back(get(i));
+    }
+
+private:
+    const char*        p = nullptr;
+    const ColMetaDisk* c = nullptr;
+    int                n = 0;
+};
+
 class GenericFixedTable {
 public:
     // Crear tabla NUEVA con esquema o abrir existente
@@ -88,10 +176,14 @@ public:
         if (!del.is_open()) throw std::runtime_error("No se pudo abrir/crear: " + del_filename);
 
         if (create_new) init_schema(table_name, cols);
-        else            load_schema();
+        else            { load_schema(); load_del(); }
     }
 
     ~GenericFixedTable(){
+        if (file.is_open() && del.is_open()) {
+            try { Checkpoint(); } catch (const std::exception& e) { std::cerr << e.what() << "\n"; }
+        }
+        unmap();
         if (file.is_open()) file.close();
         if (del.is_open())  del.close();
     }
@@ -99,15 +191,46 @@ public:
     // ----------- API estilo UserTable (por pageID) -----------
     long AppendRow(const std::vector<Value>& row) {
         const long pid = Count();
-        WriteRowInDisk(pid, row);        // escribe fila
-        ensure_del_size(pid+1);          // asegura flag
-        set_del_flag(pid, 0);            // nueva fila "viva"
+        if (!batch_on) {
+            WriteRowInDisk(pid, row);    // escribe fila (y la deja "viva" en el bitset)
+            return pid;
+        }
+        // en lote: solo se empaqueta al buffer
+        if ((int)row.size()!=hdr.ncols) throw std::invalid_argument("row.size != ncols");
+        const size_t off = batch_buf.size();
+        batch_buf.resize(off + hdr.row_size, 0);
+        try { pack_row(row, batch_buf.data() + off); }
+        catch (...) { batch_buf.resize(off); throw; }
+        if (nrows == disk_rows) batch_t0 = std::chrono::steady_clock::now();
+        ++nrows;
+        set_del_flag(pid, 0);
+        if ((auto_rows && (size_t)PendingRows() >= auto_rows) || BatchExpired())
+            FlushBatch();
+        return pid;
+    }
+
+    // Agrega n filas ya empaquetadas (n * row_size bytes contiguos) con una sola escritura;
+    // devuelve el pageID de la primera
+    long AppendPacked(const char* rows, long n) {
+        ensure_open();
+        FlushBatch();
+        const long pid = nrows;
+        if (n <= 0) return pid;
+        file.clear();
+        file.seekp(data_offset() + std::streampos(pid) * std::streampos(hdr.row_size), std::ios::beg);
+        file.write(rows, (std::streamsize)n * hdr.row_size);
+        file.flush();
+        if (!file.good()) throw std::runtime_error("Error al escribir " + std::to_string(n) + " filas en " + filename);
+        nrows = disk_rows = pid + n;
+        grew = true;
+        for (long i = pid; i < nrows && i < del_n; ++i) set_del_flag(i, 0);
         return pid;
     }
 
     void WriteRowInDisk(long pageID, const std::vector<Value>& row) {
         ensure_open();
         if ((int)row.size()!=hdr.ncols) throw std::invalid_argument("row.size != ncols");
+        FlushBatch();                    // las filas del lote van antes (y pageID puede ser una de ellas)
         std::vector<char> buf(hdr.row_size, 0);
         pack_row(row, buf.data());
         const auto off = data_offset() + std::streampos(pageID) * std::streampos(hdr.row_size);
@@ -116,18 +239,20 @@ public:
         file.write(buf.data(), hdr.row_size);
         file.flush();
         if (!file.good()) std::cerr << "Error al escribir pageID="<<pageID<<"\n";
+        else if (pageID >= nrows) { nrows = disk_rows = pageID + 1; grew = true; }
 
-        // Mantener .del en coherencia
-        ensure_del_size(pageID+1);
+        // Mantener tombstones en coherencia
         set_del_flag(pageID, 0);
     }
 
     // Lee fila completa a vector<Value>; retorna false si no existe o está borrada
     bool ReadRowByPageID(const long& pageID, std::vector<Value>& out) {
         ensure_open();
-        if (pageID < 0 || pageID >= Count()) return false;
+        if (pageID < 0 || pageID >= nrows) return false;
         if (IsDeleted(pageID)) return false;
+        need_row(pageID);
 
+        if (const char* p = RowPtr(pageID)) { unpack_row(p, out); return true; }
         std::vector<char> buf(hdr.row_size, 0);
         const auto off = data_offset() + std::streampos(pageID) * std::streampos(hdr.row_size);
         file.clear();
@@ -138,17 +263,60 @@ public:
         return true;
     }
 
-    // Cantidad de registros físicos (incluye borrados)
+    // Cantidad de registros físicos (incluye borrados). Se mantiene en memoria: se valida contra
+    // el tamaño del archivo al abrir y crece con las escrituras de este handle (un solo escritor).
     long Count() {
         ensure_open();
+        return nrows;
+    }
+
+    // ----------- Lotes de inserción -----------
+    // Entre BeginBatch y CommitBatch, AppendRow solo empaqueta la fila en un buffer y el lote se
+    // escribe al archivo con una sola escritura + un flush. Leer o reescribir una fila pendiente
+    // (o recorrer la tabla) vuelca el lote antes. SetAutoCommit(max_filas, max_ms) vuelca dentro
+    // del lote al llegar a max_filas pendientes o max_ms de antigüedad (0 = sin límite); AppendRow
+    // lo evalúa al agregar y BatchExpired() deja que quien usa la tabla venza un lote inactivo.
+    void BeginBatch() { batch_on = true; }
+    void CommitBatch() { FlushBatch(); batch_on = false; }
+    bool InBatch() const { return batch_on; }
+    long PendingRows() const { return nrows - disk_rows; }
+    void SetAutoCommit(size_t max_filas, unsigned max_ms) { auto_rows = max_filas; auto_ms = max_ms; }
+    // Hay filas pendientes desde hace max_ms o más
+    bool BatchExpired() const {
+        return auto_ms && nrows != disk_rows &&
+               std::chrono::steady_clock::now() - batch_t0 >= std::chrono::milliseconds(auto_ms);
+    }
+
+    // Escribe las filas pendientes del lote (el lote sigue abierto)
+    void FlushBatch() {
+        if (nrows == disk_rows) return;
+        ensure_open();
+        const auto off = data_offset() + std::streampos(disk_rows) * std::streampos(hdr.row_size);
         file.clear();
-        auto posg = file.tellg();
-        file.seekg(0, std::ios::end);
-        auto end = file.tellg();
-        file.seekg(posg, std::ios::beg);
-        if (end < data_offset()) return 0;
-        auto used = end - data_offset();
-        return static_cast<long>(used / std::streampos(hdr.row_size));
+        file.seekp(off, std::ios::beg);
+        file.write(batch_buf.data(), (std::streamsize)batch_buf.size());
+        file.flush();
+        batch_buf.clear();
+        if (!file.good()) {
+            const long lost = nrows - disk_rows;
+            nrows = disk_rows;
+            throw std::runtime_error("Error al escribir lote de " + std::to_string(lost) + " filas en " + filename);
+        }
+        disk_rows = nrows;
+        grew = true;
+    }
+
+    // Persiste el estado en memoria: filas del lote, páginas sucias del .del y filas en la cabecera
+    void Checkpoint() {
+        FlushBatch();
+        FlushDeleted();
+        if (!grew || hdr.nrows == (int32_t)nrows) return;   // handles de solo lectura no tocan la cabecera
+        hdr.nrows = (int32_t)nrows;
+        file.clear();
+        file.seekp(offsetof(FileHeader, nrows), std::ios::beg);
+        file.write(reinterpret_cast<const char*>(&hdr.nrows), sizeof(hdr.nrows));
+        file.flush();
+        if (!file.good()) std::cerr << "Error al escribir cabecera de " << filename << "\n";
     }
 
     // ----------- Helpers por nombre de columna -----------
@@ -178,23 +346,259 @@ public:
         return row[idx].s;
     }
 
+    // ----------- Acceso mapeado en memoria -----------
+    // Con mmap activo, la región de datos se lee directamente del archivo mapeado; el mapeo se
+    // rehace cuando se pide una fila más allá del final mapeado (el archivo creció).
+    void EnableMmap(bool on) { use_mmap = on; if (!on) unmap(); }
+    bool MmapEnabled() const { return use_mmap; }
+
+    // Puntero a la fila empaquetada (sin copia) o nullptr si no hay mmap o el pageID no existe.
+    // No filtra tombstones. Vale hasta la próxima escritura que haga crecer el archivo.
+    const char* RowPtr(long pageID) {
+        if (!use_mmap || pageID < 0) return nullptr;
+        need_row(pageID);
+        if (pageID >= map_rows) remap();
+        if (pageID >= map_rows) return nullptr;
+        return map_base + data_offset_bytes() + (size_t)pageID * (size_t)hdr.row_size;
+    }
+
+    // Desempaqueta una fila obtenida con RowPtr()/ScanRows()
+    void UnpackRow(const char* src, std::vector<Value>& out) const { unpack_row(src, out); }
+
+    // Vista tipada sobre una fila empaquetada obtenida con RowPtr()/ScanRows()
+    RowView View(const char* src) const { return RowView(src, cols.data(), hdr.ncols); }
+
+    // Como ReadRowByPageID pero sin materializar: con mmap apunta al mapeo, si no a un
+    // buffer interno (válido hasta la próxima llamada). false si no existe o está borrada.
+    bool ViewRowByPageID(long pageID, RowView& out) {
+        ensure_open();
+        if (pageID < 0 || pageID >= nrows) return false;
+        if (IsDeleted(pageID)) return false;
+        need_row(pageID);
+        const char* p = RowPtr(pageID);
+        if (!p) {
+            row_buf.resize(hdr.row_size);
+            const auto off = data_offset() + std::streampos(pageID) * std::streampos(hdr.row_size);
+            file.clear();
+            file.seekg(off, std::ios::beg);
+            file.read(row_buf.data(), hdr.row_size);
+            if (!file.good()) { std::cerr << "Error al leer pageID="<<pageID<<"\n"; return false; }
+            p = row_buf.data();
+        }
+        out = View(p);
+        return true;
+    }
+
+    // ----------- Recorrido secuencial -----------
+    // Filas contiguas [start, start+cnt) empaquetadas: puntero al mapeo si está disponible; si no,
+    // se leen de una sola vez en buf. Vale hasta la próxima escritura en la tabla o en buf.
+    const char* ReadBlock(long start, long cnt, std::vector<char>& buf) {
+        ensure_open();
+        if (start < 0 || cnt <= 0 || start + cnt > nrows) throw std::out_of_range("ReadBlock fuera de rango");
+        if (RowPtr(start + cnt - 1)) return RowPtr(start);
+        need_row(start + cnt - 1);
+        buf.resize((size_t)cnt * hdr.row_size);
+        file.clear();
+        file.seekg(data_offset() + std::streampos(start) * std::streampos(hdr.row_size), std::ios::beg);
+        file.read(buf.data(), (std::streamsize)cnt * hdr.row_size);
+        if (!file.good()) throw std::runtime_error("Error al leer bloque de filas");
+        return buf.data();
+    }
+
+    // Llama fn(pageID, const char* fila) por cada fila no marcada en .del; la fila viene
+    // empaquetada (usar col_meta() para los offsets) y el puntero solo es válido durante la
+    // llamada. Con mmap recorre el mapeo; sin él lee el archivo en bloques contiguos.
+    // Evita el seek + read por fila de ReadRowByPageID.
+    template<class FN>
+    void ScanRows(FN fn, size_t block_bytes = 1<<20) {
+        ensure_open();
+        FlushBatch();
+        ScanRange(0, Count(), fn, block_bytes);
+    }
+
+    // Como ScanRows pero solo sobre las filas [first, last); las del lote pendiente se vuelcan al leerlas
+    template<class FN>
+    void ScanRange(long first, long last, FN fn, size_t block_bytes = 1<<20) {
+        ensure_open();
+        first = std::max<long>(first, 0);
+        last = std::min<long>(last, nrows);
+        if (first >= last) return;
+        const long rows_per_block = std::max<long>(1, (long)(block_bytes / hdr.row_size));
+        std::vector<char> buf;
+        for (long start = first; start < last; start += rows_per_block) {
+            const long cnt = std::min(rows_per_block, last - start);
+            const char* base = ReadBlock(start, cnt, buf);
+            for (long i = 0; i < cnt; ++i) {
+                if (IsDeleted(start + i)) continue;
+                fn(start + i, base + (size_t)i * hdr.row_size);
+            }
+        }
+    }
+
+    // ----------- Lectura concurrente -----------
+    // Lector de bloques de filas para un hilo de trabajo (ver Reader()). Con mmap lee del mapeo; sin
+    // él usa su propio handle del archivo. Read(start, cnt, buf) es como ReadBlock.
+    class BlockReader {
+    public:
+        const char* Read(long start, long cnt, std::vector<char>& buf) {
+            if (start < 0 || cnt <= 0 || start + cnt > nrows) throw std::out_of_range("BlockReader fuera de rango");
+            if (map) return map + (size_t)start * (size_t)row_size;
+            buf.resize((size_t)cnt * row_size);
+            in.clear();
+            in.seekg(data_off + std::streampos(start) * std::streampos(row_size), std::ios::beg);
+            in.read(buf.data(), (std::streamsize)cnt * row_size);
+            if (!in.good()) throw std::runtime_error("Error al leer bloque de filas");
+            return buf.data();
+        }
+    private:
+        friend class GenericFixedTable;
+        const char*    map = nullptr;  // fila 0 en el mapeo
+        std::ifstream  in;
+        std::streampos data_off = 0;
+        int            row_size = 0;
+        long           nrows = 0;
+    };
+
+    // Lector para leer las filas [0, Count()) desde otro hilo. Se crea desde el hilo dueño de la
+    // tabla (vuelca el lote y extiende el mapeo); varios lectores pueden leer a la vez mientras la
+    // tabla no se escriba.
+    BlockReader Reader() {
+        ensure_open();
+        FlushBatch();
+        file.flush();
+        BlockReader r;
+        r.row_size = hdr.row_size;
+        r.nrows = nrows;
+        r.data_off = data_offset();
+        if (nrows > 0 && RowPtr(nrows - 1)) {
+            r.map = RowPtr(0);
+        } else {
+            r.in.open(filename, std::ios::binary);
+            if (!r.in) throw std::runtime_error("No se pudo abrir para lectura: " + filename);
+        }
+        return r;
+    }
+
+    // ----------- Lectura por lista de pageIDs -----------
+    // Filas del tramo que empieza en pids[i] (pids ordenados ascendente y sin repetidos): se juntan
+    // los candidatos siguientes mientras el hueco sea menor que GFT_FETCH_GAP_KB y el tramo no pase
+    // de block_bytes. Leer el tramo con ReadBlock cambia un seek + read por fila por lecturas
+    // secuenciales. 0 si pids[i] no es una fila existente.
+    long FetchRun(const std::vector<int>& pids, size_t i, size_t block_bytes = 1<<20) {
+        const long n = Count();
+        const long start = pids[i];
+        if (start < 0 || start >= n) return 0;
+        const long gap = std::max<long>(1, (long)((GFT_FETCH_GAP_KB << 10) / hdr.row_size));
+        const long max_rows = std::max<long>(1, (long)(block_bytes / hdr.row_size));
+        long end = start + 1;
+        for (size_t j = i + 1; j < pids.size(); ++j) {
+            const long p = pids[j];
+            if (p >= n || p - end >= gap || p + 1 - start > max_rows) break;
+            end = p + 1;
+        }
+        return end - start;
+    }
+
+    // Llama fn(pageID, const char* fila) por cada pageID de pids (ordenados ascendente y sin
+    // repetidos) que sea una fila viva, leyendo por tramos (FetchRun). Como en ScanRows, el puntero
+    // solo es válido durante la llamada.
+    template<class FN>
+    void FetchRows(const std::vector<int>& pids, FN fn, size_t block_bytes = 1<<20) {
+        ensure_open();
+        std::vector<char> buf;
+        size_t i = 0;
+        while (i < pids.size()) {
+            const long cnt = FetchRun(pids, i, block_bytes);
+            if (cnt == 0) { ++i; continue; }
+            const long start = pids[i];
+            const char* base = ReadBlock(start, cnt, buf);
+            for (; i < pids.size() && pids[i] < start + cnt; ++i) {
+                if (IsDeleted(pids[i])) continue;
+                fn((long)pids[i], base + (size_t)(pids[i] - start) * hdr.row_size);
+            }
+        }
+    }
+
     // ----------- Tombstones (borrado lógico) -----------
-    bool IsDeleted(long pageID) {
-        ensure_del_size(pageID+1);
-        del.clear();
-        del.seekg(std::streampos(pageID), std::ios::beg);
-        char b=0; del.read(&b, 1);
-        if (!del.good()) return false;
-        return b!=0;
+    // El .del (1 byte por fila) se carga al abrir en un bitset en memoria; los cambios marcan
+    // páginas de GFT_DEL_PAGE flags como sucias y se escriben con FlushDeleted() o al cerrar.
+    // Filas sin flag en el archivo (más allá de su final) se consideran vivas.
+    bool IsDeleted(long pageID) const {
+        return pageID >= 0 && pageID < del_n &&
+               ((del_bits[(size_t)pageID >> 6] >> (pageID & 63)) & 1u);
     }
-    void MarkDeleted(long pageID) {
-        ensure_del_size(pageID+1);
-        set_del_flag(pageID, 1);
+    void MarkDeleted(long pageID) { set_del_flag(pageID, 1); }
+    // Hay flags cambiados en memoria que FlushDeleted() todavía no escribió
+    bool DeletedPending() const { return !del_dirty.empty(); }
+
+    // Filas no marcadas en .del (no mira el id == -1 del borrado lógico de la capa SQL)
+    long CountLive() {
+        const long n = Count();
+        if (del_n <= n) return n - del_ones;
+        long dead = 0;
+        for (long w = 0; w < (n >> 6); ++w) dead += detail::popcount64(del_bits[(size_t)w]);
+        if (n & 63) dead += detail::popcount64(del_bits[(size_t)(n >> 6)] & ((uint64_t(1) << (n & 63)) - 1));
+        return n - dead;
+    }
+
+    // Primer pageID >= from no marcado en .del; -1 si no hay
+    long NextLive(long from) {
+        const long n = Count();
+        if (from < 0) from = 0;
+        while (from < n) {
+            if (from >= del_n) return from;
+            const uint64_t live = ~del_bits[(size_t)from >> 6] >> (from & 63);
+            if (live) { const long p = from + detail::ctz64(live); return p < n ? p : -1; }
+            from = ((from >> 6) + 1) << 6;
+        }
+        return -1;
+    }
+
+    // Agrega a out (pageID - base) por cada pageID de [from, to) no marcado en .del, recorriendo
+    // el bitset por palabras (vectores de selección de un bloque de filas)
+    void AppendLive(long from, long to, long base, std::vector<uint32_t>& out) const {
+        for (long p = from; p < to; ) {
+            const long wbeg = p & ~63L, wend = std::min(to, wbeg + 64);
+            uint64_t live = ~uint64_t(0);
+            if (p < del_n) {
+                live = ~del_bits[(size_t)p >> 6];
+                if (del_n < wbeg + 64) live |= ~uint64_t(0) << (del_n - wbeg);   // sin flag: viva
+            }
+            live &= ~uint64_t(0) << (p - wbeg);
+            if (wend - wbeg < 64) live &= (uint64_t(1) << (wend - wbeg)) - 1;
+            while (live) {
+                out.push_back((uint32_t)(wbeg + detail::ctz64(live) - base));
+                live &= live - 1;
+            }
+            p = wend;
+        }
+    }
+
+    // Checkpoint: escribe las páginas sucias del bitset al .del
+    void FlushDeleted() {
+        if (del_dirty.empty()) return;
+        std::vector<char> page;
+        for (size_t pg = 0; pg < del_dirty.size(); ++pg) {
+            if (!del_dirty[pg]) continue;
+            const long from = (long)pg * GFT_DEL_PAGE;
+            const long to   = std::min<long>(del_n, from + GFT_DEL_PAGE);
+            if (to <= from) continue;
+            ensure_del_size(from);
+            page.resize((size_t)(to - from));
+            for (long i = from; i < to; ++i) page[(size_t)(i - from)] = IsDeleted(i) ? 1 : 0;
+            del.clear();
+            del.seekp(std::streampos(from), std::ios::beg);
+            del.write(page.data(), (std::streamsize)page.size());
+        }
+        del.flush();
+        if (!del.good()) std::cerr << "Error al escribir " << del_filename << "\n";
+        del_dirty.clear();
     }
 
     // Metadatos
     int ncols() const { return hdr.ncols; }
     int row_size() const { return hdr.row_size; }
+    const ColMetaDisk& col_meta(int idx) const { return cols.at(idx); }
     std::string table_name() const { return std::string(hdr.table_name, strnlen(hdr.table_name,32)); }
 
 private:
@@ -207,6 +611,37 @@ private:
     FileHeader   hdr{};
     std::vector<ColMetaDisk> cols; // tamaño = ncols
 
+    long         nrows = 0;        // filas físicas (caché de Count), incluye las del lote pendiente
+    long         disk_rows = 0;    // filas ya escritas en el archivo
+    bool         grew  = false;    // agregó filas o la cabecera no coincidía al abrir: Checkpoint la reescribe
+
+    // lote de inserciones
+    bool              batch_on  = false;
+    std::vector<char> batch_buf;   // filas empaquetadas [disk_rows, nrows)
+    size_t            auto_rows = 0;
+    unsigned          auto_ms   = 0;
+    std::chrono::steady_clock::time_point batch_t0{};
+
+    std::vector<char> row_buf;     // respaldo de ViewRowByPageID sin mmap
+
+    // tombstones en memoria (1 bit por fila) + páginas del .del pendientes de escribir
+    std::vector<uint64_t> del_bits;
+    long                  del_n    = 0;  // filas cubiertas por el bitset
+    long                  del_ones = 0;  // filas marcadas
+    std::vector<uint8_t>  del_dirty;     // por página de GFT_DEL_PAGE flags
+
+    // mapeo de solo lectura del archivo completo (desde el offset 0)
+    bool         use_mmap = GFT_MMAP;
+    const char*  map_base = nullptr;
+    size_t       map_len  = 0;
+    long         map_rows = 0;     // filas completas cubiertas por el mapeo
+#if defined(_WIN32)
+    HANDLE       map_file = INVALID_HANDLE_VALUE;
+    HANDLE       map_view = nullptr;
+#else
+    int          map_fd   = -1;
+#endif
+
     // ---------- schema ----------
     void init_schema(const std::string& tname, const std::vector<ColumnDef>& def) {
         if (def.empty()) throw std::invalid_argument("Se requiere al menos 1 columna");
@@ -238,7 +673,7 @@ private:
         std::strncpy(hdr.table_name, tname.c_str(), 31);
         hdr.ncols    = (int32_t)def.size();
         hdr.row_size = offset;
-        hdr.reserved = 0;
+        hdr.nrows    = 0;
 
         // persistir schema
         file.seekp(0, std::ios::beg);
@@ -262,11 +697,99 @@ private:
             file.read(reinterpret_cast<char*>(&cols[i]), sizeof(ColMetaDisk));
         }
         if (!file.good()) throw std::runtime_error("Error al leer columnas");
+
+        // Conteo de filas: el tamaño del archivo manda, validado contra el de la cabecera (filas al
+        // último Checkpoint; 0 en archivos viejos). Menos filas que las registradas es un archivo
+        // truncado; más, filas escritas sin Checkpoint (se aceptan). En ambos casos se avisa y la
+        // cabecera se corrige en el próximo Checkpoint.
+        file.seekg(0, std::ios::end);
+        const auto end = file.tellg();
+        nrows = (end < data_offset()) ? 0 : static_cast<long>((end - data_offset()) / std::streampos(hdr.row_size));
+        disk_rows = nrows;
+        if (hdr.nrows > 0 && nrows != (long)hdr.nrows) {
+            if (nrows < (long)hdr.nrows)
+                std::cerr << "Aviso: " << filename << " truncado: " << nrows << " filas de "
+                          << hdr.nrows << " registradas en la cabecera\n";
+            else
+                std::cerr << "Aviso: " << filename << " tiene " << (nrows - (long)hdr.nrows)
+                          << " filas escritas después del último Checkpoint (se aceptan)\n";
+            grew = true;
+        }
     }
 
     std::streampos data_offset() const {
         return std::streampos(sizeof(FileHeader) + sizeof(ColMetaDisk)*hdr.ncols);
     }
+    size_t data_offset_bytes() const { return sizeof(FileHeader) + sizeof(ColMetaDisk)*hdr.ncols; }
+
+    // ---------- mmap ----------
+    // Vuelve a mapear el archivo con su tamaño actual; false si no se pudo (se sigue con fstream)
+    bool remap() {
+        file.flush();
+        uint64_t size = 0;
+#if defined(_WIN32)
+        if (map_file == INVALID_HANDLE_VALUE) {
+            map_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (map_file == INVALID_HANDLE_VALUE) { use_mmap = false; return false; }
+        }
+        LARGE_INTEGER li;
+        if (!GetFileSizeEx(map_file, &li)) return false;
+        size = (uint64_t)li.QuadPart;
+#else
+        if (map_fd < 0) {
+            map_fd = ::open(filename.c_str(), O_RDONLY);
+            if (map_fd < 0) { use_mmap = false; return false; }
+        }
+        struct stat st{};
+        if (::fstat(map_fd, &st) != 0) return false;
+        size = (uint64_t)st.st_size;
+#endif
+        if (size <= data_offset_bytes()) return map_rows > 0;
+        const long rows = (long)((size - data_offset_bytes()) / (size_t)hdr.row_size);
+        // el archivo creció dentro del tramo ya reservado: basta con extender map_rows
+        if (map_base && size <= map_len) { map_rows = rows; return true; }
+        unmap_view();
+        size_t len = (size_t)size;
+#if defined(_WIN32)
+        map_view = CreateFileMappingA(map_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!map_view) return false;
+        void* p = MapViewOfFile(map_view, FILE_MAP_READ, 0, 0, (SIZE_T)size);
+        if (!p) { CloseHandle(map_view); map_view = nullptr; return false; }
+#else
+        // se reserva holgura tras el final (x1.5, mín. 1 MiB) para que los appends no obliguen a
+        // remapear; solo se accede a filas completas dentro del archivo (map_rows)
+        len = std::max<size_t>(len + len / 2, (size_t)1 << 20);
+        void* p = ::mmap(nullptr, len, PROT_READ, MAP_SHARED, map_fd, 0);
+        if (p == MAP_FAILED) return false;
+#endif
+        map_base = static_cast<const char*>(p);
+        map_len  = len;
+        map_rows = rows;
+        return true;
+    }
+    void unmap_view() {
+        if (map_base) {
+#if defined(_WIN32)
+            UnmapViewOfFile(map_base);
+            if (map_view) { CloseHandle(map_view); map_view = nullptr; }
+#else
+            ::munmap(const_cast<char*>(map_base), map_len);
+#endif
+        }
+        map_base = nullptr; map_len = 0; map_rows = 0;
+    }
+    void unmap() {
+        unmap_view();
+#if defined(_WIN32)
+        if (map_file != INVALID_HANDLE_VALUE) { CloseHandle(map_file); map_file = INVALID_HANDLE_VALUE; }
+#else
+        if (map_fd >= 0) { ::close(map_fd); map_fd = -1; }
+#endif
+    }
+
+    // Una fila todavía en el buffer del lote se vuelca antes de leerla
+    void need_row(long pageID) { if (pageID >= disk_rows && pageID < nrows) FlushBatch(); }
 
     void ensure_open(){ if (!file.is_open()) throw std::runtime_error("Archivo no abierto"); }
 
@@ -300,26 +823,7 @@ private:
     }
 
     void unpack_row(const char* src, std::vector<Value>& out) const {
-        out.clear(); out.resize(hdr.ncols);
-        for (int i=0;i<hdr.ncols;++i) {
-            const auto& c = cols[i];
-            const char* p = src + c.offset;
-            switch ((ColType)c.type) {
-            case ColType::INT32: {
-                int32_t x; std::memcpy(&x, p, 4);
-                out[i] = Value::Int(x);
-            } break;
-            case ColType::FLOAT32: {
-                float x; std::memcpy(&x, p, 4);
-                out[i] = Value::Flt(x);
-            } break;
-            case ColType::CHAR: {
-                int len=0; while (len<c.width && p[len]!='\0') ++len;
-                out[i] = Value::Chr(std::string(p, p+len));
-            } break;
-            default: throw std::runtime_error("Tipo no soportado");
-            }
-        }
+        View(src).to_values(out);
     }
 
     // ---------- tombstones helpers ----------
@@ -341,12 +845,45 @@ private:
         del.flush();
     }
 
+    // Cambia el flag en memoria; solo marca sucia la página si el valor cambia
     void set_del_flag(long pid, uint8_t flag) {
+        if (pid < 0) return;
+        if (pid >= del_n) {
+            if (!flag) return;                 // fuera del bitset ya cuenta como viva
+            del_n = pid + 1;
+            del_bits.resize(((size_t)del_n + 63) >> 6, 0);
+        }
+        uint64_t& w = del_bits[(size_t)pid >> 6];
+        const uint64_t m = uint64_t(1) << (pid & 63);
+        if (((w & m) != 0) == (flag != 0)) return;
+        w ^= m;
+        del_ones += flag ? 1 : -1;
+        const size_t pg = (size_t)(pid / GFT_DEL_PAGE);
+        if (del_dirty.size() <= pg) del_dirty.resize(pg + 1, 0);
+        del_dirty[pg] = 1;
+    }
+
+    // Carga el .del completo al bitset
+    void load_del() {
         del.clear();
-        del.seekp(std::streampos(pid), std::ios::beg);
-        char b = (char)flag;
-        del.write(&b, 1);
-        del.flush();
+        del.seekg(0, std::ios::end);
+        const auto end = del.tellg();
+        const long n = (end < 0 ? 0 : (long)end);
+        del_n = n; del_ones = 0;
+        del_bits.assign(((size_t)n + 63) >> 6, 0);
+        del_dirty.clear();
+        std::vector<char> buf(std::min<long>(std::max<long>(n, 1), 1<<20));
+        del.seekg(0, std::ios::beg);
+        for (long start = 0; start < n; start += (long)buf.size()) {
+            const long cnt = std::min<long>((long)buf.size(), n - start);
+            del.read(buf.data(), cnt);
+            if (!del.good()) { del.clear(); break; }
+            for (long i = 0; i < cnt; ++i) {
+                if (!buf[(size_t)i]) continue;
+                del_bits[(size_t)(start + i) >> 6] |= uint64_t(1) << ((start + i) & 63);
+                ++del_ones;
+            }
+        }
     }
 };
 
@@ -0,0 +1,247 @@
+// HashAgg.h
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+// =================== CONFIG ===================
+#define HASHAGG_PARTS 16       // particiones por nivel al volcar grupos a disco (potencia de 2)
+#define HASHAGG_MAX_NIVEL 8    // niveles de re-partición; más allá se acepta pasarse de memoria
+// ==============================================
+
+namespace hashagg {
+
+// Finalizador de murmur3: dispersa todos los bits de x
+inline uint64_t mezclar(uint64_t x) {
+    x ^= x >> 33; x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+// Hash de 64 bits de una clave de n bytes, de a 8 bytes
+inline uint64_t hash_bytes(const uint8_t* p, size_t n) {
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ n;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t x; std::memcpy(&x, p, 8);
+        h = (h ^ mezclar(x)) * 0x9E3779B97F4A7C15ull;
+    }
+    if (n) {
+        uint64_t x = 0; std::memcpy(&x, p, n);
+        h = (h ^ mezclar(x)) * 0x9E3779B97F4A7C15ull;
+    }
+    return mezclar(h);
+}
+
+// Tabla hash de direccionamiento abierto (sondeo lineal) de grupos de ancho fijo. Cada entrada es
+// [hash: 8][clave: key_bytes][estado: state_bytes] en un arreglo contiguo; los slots guardan la
+// posición de la entrada + 1 (0: libre) y se duplican al pasar la mitad de ocupación, rehasheando
+// con el hash guardado. Las claves se comparan por bytes: el llamador las normaliza.
+class TablaGrupos {
+public:
+    TablaGrupos(size_t key_bytes, size_t state_bytes)
+        : kb(key_bytes), ent(8 + key_bytes + state_bytes), slots(64, 0) {}
+
+    // Estado del grupo de key (hash h); nuevo = true si se acaba de crear (estado sin inicializar).
+    // El puntero vale hasta la próxima inserción.
+    uint8_t* buscar(const uint8_t* key, uint64_t h, bool& nuevo) {
+        if ((n + 1) * 2 > slots.size()) crecer();
+        const size_t mask = slots.size() - 1;
+        for (size_t i = (size_t)h & mask;; i = (i + 1) & mask) {
+            const uint32_t s = slots[i];
+            if (s == 0) {
+                datos.resize((n + 1) * ent);
+                uint8_t* e = datos.data() + n * ent;
+                std::memcpy(e, &h, 8);
+                std::memcpy(e + 8, key, kb);
+                slots[i] = (uint32_t)++n;
+                nuevo = true;
+                return e + 8 + kb;
+            }
+            uint8_t* e = datos.data() + (size_t)(s - 1) * ent;
+            if (std::memcmp(e, &h, 8) == 0 && std::memcmp(e + 8, key, kb) == 0) { nuevo = false; return e + 8 + kb; }
+        }
+    }
+
+    size_t size() const { return n; }
+    size_t ancho() const { return ent; }
+    // Memoria de las entradas y los slots (no cuenta la holgura del vector de entradas)
+    size_t bytes() const { return n * ent + slots.size() * sizeof(uint32_t); }
+    // Entrada i en [0, size()): hash, clave en +8 y estado en +8+key_bytes
+    const uint8_t* entrada(size_t i) const { return datos.data() + i * ent; }
+    // Vacía la tabla; las entradas conservan su memoria, los slots vuelven al tamaño inicial
+    void clear() { n = 0; datos.clear(); slots.assign(64, 0); }
+
+private:
+    size_t kb, ent;
+    size_t n = 0;
+    std::vector<uint8_t> datos;
+    std::vector<uint32_t> slots;
+
+    void crecer() {
+        std::vector<uint32_t> s(slots.size() * 2, 0);
+        const size_t mask = s.size() - 1;
+        for (size_t k = 0; k < n; ++k) {
+            uint64_t h; std::memcpy(&h, datos.data() + k * ent, 8);
+            size_t i = (size_t)h & mask;
+            while (s[i]) i = (i + 1) & mask;
+            s[i] = (uint32_t)(k + 1);
+        }
+        slots.swap(s);
+    }
+};
+
+// Agregación por hash con memoria acotada. grupo(key) devuelve el estado del grupo (creándolo);
+// cuando la tabla pasa de mem_bytes sus entradas (estados parciales) se vuelcan a HASHAGG_PARTS
+// archivos según los bits altos del hash y la tabla se vacía. Al leer (siguiente()) cada partición
+// se vuelve a agregar sola, combinando estados con merge(dst, src); una partición que todavía no
+// entra se re-parte con los bits siguientes. Los agregadores parciales de varios hilos se juntan
+// con absorber() antes de leer. Si nunca se volcó, se lee directo de la tabla.
+//
+// Uso:  Agregador<MERGE> a(key_bytes, state_bytes, merge, "/tmp/dir/prefijo", mem);
+//       st = a.grupo(key, nuevo) ...;  a.absorber(otro);  while (a.siguiente(k, st)) { ... }
+template<class MERGE>
+class Agregador {
+public:
+    // tmp_prefix: ruta + prefijo de los archivos de partición (se borran al leerlos o al destruir)
+    Agregador(size_t key_bytes, size_t state_bytes, MERGE merge, std::string tmp_prefix, size_t mem_bytes)
+        : kb(key_bytes), sb(state_bytes), combinar(merge), prefix(std::move(tmp_prefix)),
+          mem(mem_bytes), tabla(key_bytes, state_bytes), salida(HASHAGG_PARTS, nullptr) {}
+    ~Agregador() {
+        cerrar_salida();
+        for (auto& p : pendientes) for (auto& f : p.archivos) std::remove(f.c_str());
+        for (auto& p : nuevas) for (auto& f : p.archivos) std::remove(f.c_str());
+    }
+    Agregador(const Agregador&) = delete;
+    Agregador& operator=(const Agregador&) = delete;
+
+    uint8_t* grupo(const uint8_t* key, bool& nuevo) {
+        if (lleno()) derramar();
+        return tabla.buscar(key, hash_bytes(key, kb), nuevo);
+    }
+
+    // Suma los grupos de otro agregador (del mismo formato), que queda vacío: su tabla se combina
+    // en esta y sus particiones en disco pasan a ser de esta
+    void absorber(Agregador& o) {
+        if (leyendo || o.leyendo) throw std::logic_error("Agregador: absorber() después de siguiente()");
+        o.cerrar_salida();
+        for (size_t i = 0; i < o.tabla.size(); ++i) sumar(o.tabla.entrada(i));
+        o.tabla.clear();
+        if (!o.nuevas.empty()) {
+            if (nuevas.empty()) nuevas.resize(HASHAGG_PARTS);
+            for (size_t p = 0; p < HASHAGG_PARTS; ++p)
+                for (auto& f : o.nuevas[p].archivos) nuevas[p].archivos.push_back(std::move(f));
+            o.nuevas.clear();
+        }
+    }
+
+    // Veces que se volcó la tabla a disco
+    size_t derrames() const { return nderrames; }
+    // Cambia el presupuesto de memoria (p. ej. al juntar parciales que tenían una parte cada uno)
+    void memoria(size_t mem_bytes) { mem = mem_bytes; }
+
+    // Siguiente grupo final (clave, estado); false al terminar. Los punteros valen hasta la
+    // próxima llamada.
+    bool siguiente(const uint8_t*& key, const uint8_t*& st) {
+        if (!leyendo) {
+            leyendo = true;
+            if (!nuevas.empty()) { derramar(); cerrar_salida(); encolar(); }
+        }
+        while (pos >= tabla.size()) {
+            if (pendientes.empty()) return false;
+            Particion p = std::move(pendientes.back());
+            pendientes.pop_back();
+            cargar(p);
+        }
+        const uint8_t* e = tabla.entrada(pos++);
+        key = e + 8; st = e + 8 + kb;
+        return true;
+    }
+
+private:
+    struct Particion {
+        std::vector<std::string> archivos;
+        int nivel = 0;
+    };
+
+    size_t kb, sb;
+    MERGE combinar;
+    std::string prefix;
+    size_t mem;
+    TablaGrupos tabla;
+    bool leyendo = false;
+    size_t pos = 0;
+    size_t nderrames = 0, seq = 0;
+    int nivel = 0;                    // nivel de las particiones que se escriben ahora
+    std::vector<std::FILE*> salida;   // archivo abierto de cada partición de 'nuevas'
+    std::vector<Particion> nuevas;    // particiones en escritura (vacío: nunca se volcó)
+    std::vector<Particion> pendientes;
+
+    bool lleno() const { return tabla.size() && tabla.bytes() > mem && nivel < HASHAGG_MAX_NIVEL; }
+
+    // Entrada [hash][clave][estado] (de otra tabla o de un archivo) combinada en la tabla
+    void sumar(const uint8_t* e) {
+        if (lleno()) derramar();
+        uint64_t h; std::memcpy(&h, e, 8);
+        bool nuevo;
+        uint8_t* st = tabla.buscar(e + 8, h, nuevo);
+        if (nuevo) std::memcpy(st, e + 8 + kb, sb);
+        else combinar(st, e + 8 + kb);
+    }
+
+    // Vuelca la tabla a las particiones del nivel actual (bits altos del hash, 4 por nivel)
+    void derramar() {
+        if (nuevas.empty()) nuevas.resize(HASHAGG_PARTS);
+        const int shift = 64 - 4 * (nivel + 1);
+        for (size_t i = 0; i < tabla.size(); ++i) {
+            const uint8_t* e = tabla.entrada(i);
+            uint64_t h; std::memcpy(&h, e, 8);
+            const size_t p = (size_t)(h >> shift) & (HASHAGG_PARTS - 1);
+            if (!salida[p]) {
+                std::string path = prefix + ".p" + std::to_string(seq++) + ".tmp";
+                salida[p] = std::fopen(path.c_str(), "wb");
+                if (!salida[p]) throw std::runtime_error("No se pudo abrir archivo temporal: " + path);
+                std::setvbuf(salida[p], nullptr, _IOFBF, 1<<16);
+                nuevas[p].archivos.push_back(std::move(path));
+                nuevas[p].nivel = nivel;
+            }
+            if (std::fwrite(e, 1, tabla.ancho(), salida[p]) != tabla.ancho())
+                throw std::runtime_error("Error al escribir partición temporal");
+        }
+        tabla.clear();
+        ++nderrames;
+    }
+
+    void cerrar_salida() {
+        for (auto& f : salida) if (f) { std::fclose(f); f = nullptr; }
+    }
+
+    void encolar() {
+        for (auto& p : nuevas) if (!p.archivos.empty()) pendientes.push_back(std::move(p));
+        nuevas.clear();
+    }
+
+    // Agrega una partición en la tabla; si no entra, lo que sobra se re-parte un nivel más abajo
+    void cargar(Particion& p) {
+        tabla.clear(); pos = 0;
+        nivel = p.nivel + 1;
+        std::vector<uint8_t> buf(tabla.ancho() * 4096);
+        for (auto& path : p.archivos) {
+            std::FILE* f = std::fopen(path.c_str(), "rb");
+            if (!f) throw std::runtime_error("No se pudo abrir archivo temporal: " + path);
+            size_t k;
+            while ((k = std::fread(buf.data(), tabla.ancho(), 4096, f)) > 0)
+                for (size_t i = 0; i < k; ++i) sumar(buf.data() + i * tabla.ancho());
+            std::fclose(f);
+            std::remove(path.c_str());
+        }
+        p.archivos.clear();
+        if (!nuevas.empty()) { derramar(); cerrar_salida(); encolar(); }
+    }
+};
+
+} // namespace hashagg
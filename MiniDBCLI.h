@@ -61,17 +61,34 @@ private:
             "  SHOW TABLES\n"
             "  CREATE TABLE table_name (col1 TYPE, col2 TYPE, ...)\n"
             "      * Se agrega automaticamente la columna 'id INT' al crear una tabla.\n"
-            "  INSERT INTO table_name (col1,col2,...) VALUES (v1,v2,...)\n"
+            "      * Palabras reservadas (no valen como nombre de tabla o columna): SELECT FROM WHERE AND OR\n"
+            "        NOT SET UPDATE DELETE. GROUP ORDER BY ASC DESC LIMIT OFFSET solo son palabra clave\n"
+            "        donde empieza una clausula; como columna o tabla se pueden usar.\n"
+            "  INSERT INTO table_name (col1,col2,...) VALUES (v1,v2,...)[, (v1,v2,...) ...]\n"
+            "  COPY table_name FROM 'archivo.csv' [HEADER] [DELIMITER 'c']\n"
             "  SELECT * FROM table_name\n"
             "  SELECT col1,col2 FROM table_name\n"
             "  SELECT * FROM table_name WHERE id == 1\n"
             "  SELECT * FROM table_name WHERE id >= 2 AND id <= 6\n"
             "  SELECT * FROM table_name WHERE id == 3 OR id == 8\n"
+            "  SELECT * FROM table_name WHERE (a == 1 OR b > 2) AND NOT c == 'x'\n"
+            "  SELECT * FROM table_name WHERE a > 5 ORDER BY b DESC, c LIMIT 10\n"
+            "  SELECT * FROM table_name WHERE a > 5 LIMIT 10 OFFSET 20\n"
+            "  SELECT COUNT(*) FROM table_name\n"
+            "  SELECT b, COUNT(*), SUM(a), AVG(a) FROM table_name WHERE a > 5 GROUP BY b ORDER BY SUM(a) DESC\n"
+            "      * Agregados: COUNT(*), COUNT(col), SUM, AVG, MIN, MAX.\n"
             "  CREATE INDEX idx_name ON table_name (columna)\n"
+            "  CREATE INDEX idx_name ON table_name (columna) USING BPLUS\n"
+            "      * USING BPLUS crea un B+Tree con hojas enlazadas (rangos mas rapidos); por defecto B-Tree.\n"
+            "  PREPARE nombre AS SELECT * FROM table_name WHERE id == ?\n"
+            "  EXECUTE nombre (v1,v2,...)\n"
+            "  DEALLOCATE [PREPARE] nombre\n"
+            "      * Sentencias SELECT/UPDATE/DELETE con parametros '?': el plan se guarda y se reutiliza.\n"
             "\n"
             "Notas:\n"
             "  • En el primer SELECT * de una tabla se crea un indice B-Tree 'default' sobre la columna 'id'.\n"
-            "  • SELECT con WHERE usará un indice existente para esa columna; si no hay, hara escaneo secuencial.\n"
+            "  • WHERE usa el indice de la condicion mas selectiva de un AND, o une los indices de las ramas de un OR;\n"
+            "    si no hay indice utilizable, hace escaneo secuencial.\n"
             "  • Tipos soportados en CREATE TABLE: INT, FLOAT, CHAR(n)\n"
             "\n"
             "Ejemplos:\n"
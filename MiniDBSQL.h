@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <string_view>
 #include <sstream>
 #include <iostream>
 #include <filesystem>
@@ -11,10 +12,40 @@
 #include <unordered_map>
 #include <algorithm>
 #include <limits>
+#include <memory>
+#include <iomanip>
+#include <charconv>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
 
 #include "MiniDatabase.h"
 #include "GenericFixedTable.h"
 #include "DiskBTreeMulti.h"
+#include "SqlParser.h"
+#include "PidSet.h"
+#include "BatchFilter.h"
+#include "ExternalSort.h"
+#include "HashAgg.h"
+
+// =================== CONFIG ===================
+#define SQL_PLAN_CACHE 256   // planes de sentencias preparadas por texto normalizado (se vacía al llenarse)
+#define SQL_BATCH 1024       // filas por lote entre operadores del pipeline de ejecución
+#ifndef SQL_SCAN_THREADS
+#define SQL_SCAN_THREADS 0   // hilos del recorrido paralelo (0 = hardware_concurrency, 1 = sin paralelismo)
+#endif
+#ifndef SQL_PAR_MIN_ROWS
+#define SQL_PAR_MIN_ROWS 200000  // tablas más chicas se recorren en un solo hilo
+#endif
+#ifndef SQL_SORT_MEM_MB
+#define SQL_SORT_MEM_MB 64   // memoria de ORDER BY antes de volcar corridas a disco (configurar_orden)
+#endif
+#ifndef SQL_AGG_MEM_MB
+#define SQL_AGG_MEM_MB 64    // memoria de los grupos de GROUP BY antes de volcar particiones a disco (configurar_agrupacion)
+#endif
+// ==============================================
 
 namespace sqlmini {
 
@@ -24,6 +55,7 @@ using gft::GenericFixedTable;
 using gft::ColumnDef;
 using gft::ColType;
 using gft::Value;
+using gft::RowView;
 
 // ---------- util ----------
 inline std::string trim(const std::string& s){
@@ -33,6 +65,10 @@ inline std::string trim(const std::string& s){
     return s.substr(a,b-a);
 }
 inline std::string to_upper(std::string s){ for(char& c:s) c=std::toupper((unsigned char)c); return s; }
+// prefijo sin distinguir mayúsculas (p.ej. "SELECT", "DELETE FROM")
+inline bool starts_kw(std::string_view s, std::string_view kw){
+    return s.size()>=kw.size() && iequals(s.substr(0, kw.size()), kw);
+}
 
 inline bool parse_type(const std::string& t, ColType& out_type, int& out_len){
     auto T = to_upper(trim(t));
@@ -55,7 +91,7 @@ struct _GFT_FileHeader {
     char     table_name[32];
     int32_t  ncols;
     int32_t  row_size;
-    int32_t  reserved;
+    int32_t  nrows;
 };
 struct _GFT_ColMetaDisk {
     char     name[32];
@@ -89,16 +125,29 @@ inline bool load_schema_from_tbl(const fs::path& tbl_path, TableSchema& out){
     return in.good();
 }
 
-inline bool index_exists(const fs::path& dbdir, const std::string& table, const std::string& col, ColType t){
-    fs::path tdir = dbdir / table;
-    std::string base = table + "_" + col;
-    fs::path f;
-    if (t==ColType::INT32)   f = tdir / (base + ".bti");
-    else if (t==ColType::FLOAT32) f = tdir / (base + ".btf");
-    else f = tdir / (base + ".bts");
-    return fs::exists(f);
+// Esquema de una tabla ya abierta (mismos datos que load_schema_from_tbl, sin releer el archivo)
+inline void schema_from_table(const GenericFixedTable& t, TableSchema& out){
+    out.table_name = t.table_name();
+    out.ncols = t.ncols(); out.row_size = t.row_size();
+    out.cols.clear(); out.cols.reserve(out.ncols);
+    for (int i=0;i<out.ncols;++i){
+        const auto& c = t.col_meta(i);
+        out.cols.push_back({std::string(c.name, strnlen(c.name,32)), (ColType)c.type, c.width, c.offset});
+    }
 }
 
+// Entrada del catálogo de la sesión: esquema parseado, columna->índice y la tabla abierta
+// (handle de MiniDatabase). Vale mientras dure el USE; se invalida en DDL.
+struct CatalogEntry {
+    TableSchema sc;
+    std::unordered_map<std::string,int> cix;
+    GenericFixedTable* tbl = nullptr;
+    int col(const std::string& name) const {
+        auto it = cix.find(name);
+        return it==cix.end() ? -1 : it->second;
+    }
+};
+
 inline std::vector<std::string> split_csv(const std::string& s){
     std::vector<std::string> out; std::string cur; bool inq=false;
     for(char c : s){
@@ -118,85 +167,1473 @@ inline Value parse_value_literal(const std::string& lit, ColType t){
     return Value::Chr(L);
 }
 
-enum class Cmp { EQ, GE, LE, GT, LT, NE };
+// Tuplas "(...), (...), ..." desde 'from': contenido de cada paréntesis (respeta comillas)
+inline bool split_tuples(const std::string& s, size_t from, std::vector<std::string>& out){
+    size_t i = from;
+    while (true){
+        while (i<s.size() && std::isspace((unsigned char)s[i])) ++i;
+        if (i>=s.size() || s[i]!='(') return false;
+        size_t j = i+1; bool inq=false;
+        while (j<s.size() && (inq || s[j]!=')')){ if (s[j]=='\'') inq=!inq; ++j; }
+        if (j>=s.size()) return false;
+        out.push_back(s.substr(i+1, j-i-1));
+        i = j+1;
+        while (i<s.size() && std::isspace((unsigned char)s[i])) ++i;
+        if (i>=s.size()) return true;
+        if (s[i]!=',') return false;
+        ++i;
+    }
+}
+
+// WHERE que ejecuta el intérprete: el árbol del parser guardado en un vector (hijos por posición),
+// copiable y cacheable en planes. Los NOT ya están empujados hasta los predicados (De Morgan) y
+// los AND/OR anidados del mismo tipo, aplanados; un NOT solo queda sobre un PRED.
+struct Where {
+    struct Node { Expr::Kind kind = Expr::Kind::PRED; Pred pred; std::vector<int> args; };
+    std::vector<Node> nodes;   // nodes[0] es la raíz; vacío = sin WHERE
+    bool empty() const { return nodes.empty(); }
+};
+
+inline int where_node(Where& w, const Expr& e, bool neg);
+
+// Agrega e (negado si neg) como hijo de w.nodes[id], absorbiendo los hijos si es del mismo tipo
+inline void where_child(Where& w, int id, const Expr& e, bool neg){
+    const Expr* x = &e;
+    while (x->kind==Expr::Kind::NOT){ x = x->args[0].get(); neg = !neg; }
+    Expr::Kind k = x->kind;
+    if (neg && k==Expr::Kind::AND) k = Expr::Kind::OR;
+    else if (neg && k==Expr::Kind::OR) k = Expr::Kind::AND;
+    if (k!=Expr::Kind::PRED && k==w.nodes[(size_t)id].kind){
+        for (auto& c : x->args) where_child(w, id, *c, neg);
+        return;
+    }
+    const int c = where_node(w, *x, neg);
+    w.nodes[(size_t)id].args.push_back(c);
+}
+
+inline int where_node(Where& w, const Expr& e, bool neg){
+    if (e.kind==Expr::Kind::NOT) return where_node(w, *e.args[0], !neg);
+    const int id = (int)w.nodes.size();
+    w.nodes.emplace_back();
+    if (e.kind==Expr::Kind::PRED){
+        if (!neg){ w.nodes[(size_t)id].pred = e.pred; return id; }
+        w.nodes[(size_t)id].kind = Expr::Kind::NOT;
+        w.nodes.emplace_back();
+        w.nodes[(size_t)id+1].pred = e.pred;
+        w.nodes[(size_t)id].args.push_back(id+1);
+        return id;
+    }
+    const bool is_and = (e.kind==Expr::Kind::AND) != neg;
+    w.nodes[(size_t)id].kind = is_and ? Expr::Kind::AND : Expr::Kind::OR;
+    for (auto& c : e.args) where_child(w, id, *c, neg);
+    return id;
+}
 
-struct Pred { std::string col; Cmp cmp; std::string lit; };
-struct Where { std::optional<Pred> p1; std::optional<Pred> p2; std::string op; };
+// Cualquier condición del parser tiene forma ejecutable (se conserva el bool por compatibilidad)
+inline bool to_where(const Expr& e, Where& w){
+    w = Where{};
+    where_node(w, e, false);
+    return true;
+}
 
 inline bool parse_where(const std::string& expr, Where& w){
-    auto up = to_upper(expr);
-    size_t pos_and = up.find(" AND ");
-    size_t pos_or  = up.find(" OR ");
-
-    auto parse_pred = [&](std::string s)->std::optional<Pred>{
-        s = trim(s); size_t p;
-        if ((p=s.find("!="))!=std::string::npos) return Pred{ trim(s.substr(0,p)), Cmp::NE, trim(s.substr(p+2)) };
-        if ((p=s.find(">="))!=std::string::npos) return Pred{ trim(s.substr(0,p)), Cmp::GE, trim(s.substr(p+2)) };
-        if ((p=s.find("<="))!=std::string::npos) return Pred{ trim(s.substr(0,p)), Cmp::LE, trim(s.substr(p+2)) };
-        if ((p=s.find("=="))!=std::string::npos) return Pred{ trim(s.substr(0,p)), Cmp::EQ, trim(s.substr(p+2)) };
-        // aceptar '=' simple como EQ
-        if ((p=s.find('=')) !=std::string::npos) return Pred{ trim(s.substr(0,p)), Cmp::EQ, trim(s.substr(p+1)) };
-        if ((p=s.find('>')) !=std::string::npos) return Pred{ trim(s.substr(0,p)), Cmp::GT, trim(s.substr(p+1)) };
-        if ((p=s.find('<')) !=std::string::npos) return Pred{ trim(s.substr(0,p)), Cmp::LT, trim(s.substr(p+1)) };
-        return std::nullopt;
+    ExprPtr e; std::string err;
+    return parse_condition(expr, e, err) && to_where(*e, w);
+}
+
+// Predicado ligado al esquema: columna resuelta y literal convertido una sola vez,
+// para evaluar sobre RowView sin buscar nombres ni reservar memoria por fila.
+// Con un parámetro '?' el valor queda pendiente hasta bind_param (param = posición del '?').
+struct BoundPred {
+    int idx=-1; ColType t{}; Cmp cmp{};
+    int32_t i{}; float f{}; std::string s;
+    int param=-1;
+};
+
+inline BoundPred bind_pred(const Pred& p, const TableSchema& sc){
+    BoundPred b; b.cmp = p.cmp; b.param = p.param;
+    for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name==p.col){ b.idx=i; b.t=sc.cols[i].type; break; }
+    if (b.idx==-1 || b.param>=0) return b;
+    if (b.t==ColType::INT32) b.i = std::stoi(p.lit);
+    else if (b.t==ColType::FLOAT32) b.f = std::stof(p.lit);
+    else {
+        b.s = p.lit;
+        if (b.s.size()>=2 && b.s.front()=='\'' && b.s.back()=='\'') b.s = b.s.substr(1,b.s.size()-2);
+    }
+    return b;
+}
+
+template<class T>
+inline bool cmp_apply(Cmp c, const T& a, const T& b){
+    switch(c){
+    case Cmp::EQ: return a==b;
+    case Cmp::GE: return a>=b;
+    case Cmp::LE: return a<=b;
+    case Cmp::GT: return a> b;
+    case Cmp::LT: return a< b;
+    case Cmp::NE: return a!=b;
+    }
+    return false;
+}
+
+inline bool eval_pred_view(const BoundPred& p, const RowView& row){
+    if (p.idx==-1) return false;
+    if (p.t==ColType::INT32)   return cmp_apply(p.cmp, row.get_int(p.idx), p.i);
+    if (p.t==ColType::FLOAT32) return cmp_apply(p.cmp, row.get_float(p.idx), p.f);
+    return cmp_apply(p.cmp, row.get_char_view(p.idx), std::string_view(p.s));
+}
+
+// Where ligado al esquema: mismos nodos (mismas posiciones) con predicados tipados
+struct BoundWhere {
+    struct Node { Expr::Kind kind = Expr::Kind::PRED; BoundPred pred; std::vector<int> args; };
+    std::vector<Node> nodes;
+
+    bool eval(const RowView& row) const { return nodes.empty() || eval_node(0, row); }
+    bool eval_node(int i, const RowView& row) const {
+        const Node& n = nodes[(size_t)i];
+        switch (n.kind){
+        case Expr::Kind::PRED: return eval_pred_view(n.pred, row);
+        case Expr::Kind::NOT:  return !eval_node(n.args[0], row);
+        case Expr::Kind::AND:
+            for (int c : n.args) if (!eval_node(c, row)) return false;
+            return true;
+        case Expr::Kind::OR:
+            for (int c : n.args) if (eval_node(c, row)) return true;
+            return false;
+        }
+        return false;
+    }
+};
+
+inline Cmp negate_cmp(Cmp c){
+    switch (c){
+    case Cmp::EQ: return Cmp::NE;
+    case Cmp::NE: return Cmp::EQ;
+    case Cmp::GE: return Cmp::LT;
+    case Cmp::LT: return Cmp::GE;
+    case Cmp::LE: return Cmp::GT;
+    case Cmp::GT: return Cmp::LE;
+    }
+    return c;
+}
+
+// NOT sobre un predicado INT/CHAR se vuelve el predicado opuesto (así también puede usar índice);
+// en FLOAT se conserva el NOT porque con NaN "no (a < k)" no equivale a "a >= k"
+inline BoundWhere bind_where(const Where& w, const TableSchema& sc){
+    BoundWhere b; b.nodes.resize(w.nodes.size());
+    for (size_t i=0;i<w.nodes.size();++i){
+        b.nodes[i].kind = w.nodes[i].kind;
+        b.nodes[i].args = w.nodes[i].args;
+        if (w.nodes[i].kind==Expr::Kind::PRED) b.nodes[i].pred = bind_pred(w.nodes[i].pred, sc);
+    }
+    for (auto& n : b.nodes){
+        if (n.kind!=Expr::Kind::NOT) continue;
+        const BoundPred& c = b.nodes[(size_t)n.args[0]].pred;
+        if (c.idx==-1 || c.t==ColType::FLOAT32) continue;
+        n.kind = Expr::Kind::PRED;
+        n.pred = c; n.pred.cmp = negate_cmp(c.cmp);
+        n.args.clear();
+    }
+    return b;
+}
+
+// Texto de un valor como literal SQL ('texto' entre comillas)
+inline std::string value_literal(const Value& v){
+    if (v.t==ColType::INT32) return std::to_string(v.i);
+    if (v.t==ColType::FLOAT32){ std::ostringstream o; o << std::setprecision(9) << v.f; return o.str(); }
+    return "'" + v.s + "'";
+}
+
+// Valor de un literal suelto (argumentos de EXECUTE): 'texto' -> CHAR, entero -> INT,
+// otro número -> FLOAT, palabra sin comillas -> CHAR
+inline Value literal_value(const std::string& lit){
+    std::string L = trim(lit);
+    if (L.size()>=2 && L.front()=='\'' && L.back()=='\'') return Value::Chr(L.substr(1, L.size()-2));
+    const char* b = L.data() + ((!L.empty() && L[0]=='+') ? 1 : 0);
+    const char* e = L.data() + L.size();
+    int32_t i{};
+    auto ri = std::from_chars(b, e, i);
+    if (ri.ec==std::errc() && ri.ptr==e && b!=e) return Value::Int(i);
+    float f{};
+    auto rf = std::from_chars(b, e, f);
+    if (rf.ec==std::errc() && rf.ptr==e && b!=e) return Value::Flt(f);
+    return Value::Chr(L);
+}
+
+// Valor de un parámetro convertido al tipo t de la columna
+inline Value value_as(const Value& v, ColType t){
+    if (t==ColType::INT32)
+        return Value::Int(v.t==ColType::INT32 ? v.i : v.t==ColType::FLOAT32 ? (int32_t)v.f : std::stoi(v.s));
+    if (t==ColType::FLOAT32)
+        return Value::Flt(v.t==ColType::FLOAT32 ? v.f : v.t==ColType::INT32 ? (float)v.i : std::stof(v.s));
+    return Value::Chr(v.t==ColType::CHAR ? v.s : value_literal(v));
+}
+
+// Completa un predicado con el valor de su parámetro, convertido al tipo de la columna
+inline void bind_param(BoundPred& b, const Value& v){
+    Value c = value_as(v, b.t);
+    if (b.t==ColType::INT32) b.i = c.i;
+    else if (b.t==ColType::FLOAT32) b.f = c.f;
+    else b.s = std::move(c.s);
+}
+
+// ---------- Sondeo de índice ----------
+// Extremos de la clave de cada índice: rango sin cota de un lado
+template<class TRAITS> struct LimitesClave;
+template<> struct LimitesClave<diskbtree::KeyInt> {
+    static int32_t min(){ return std::numeric_limits<int32_t>::min(); }
+    static int32_t max(){ return std::numeric_limits<int32_t>::max(); }
+};
+template<> struct LimitesClave<diskbtree::KeyFloat> {
+    static float min(){ return -std::numeric_limits<float>::infinity(); }
+    static float max(){ return std::numeric_limits<float>::infinity(); }
+};
+template<> struct LimitesClave<diskbtree::KeyChar32> {
+    static std::string min(){ return std::string(); }
+    static std::string max(){ return std::string(31, '\xff'); }   // claves de 31 bytes, comparadas con memcmp
+};
+
+// Rango sobre la clave de un índice con cotas abiertas o cerradas; una cota ausente no limita.
+// desde/hasta agregan una cota y se quedan con la más estricta, así un AND de predicados sobre la
+// misma columna (total >= 100 AND total < 1000) es un solo recorrido.
+template<class K>
+struct IndexRangeScan {
+    struct Cota { bool hay = false; bool cerrada = true; K k{}; };
+    Cota lo, hi;
+
+    void desde(const K& k, bool cerrada){
+        if (!lo.hay || lo.k < k || (!(k < lo.k) && !cerrada)) lo = Cota{true, cerrada, k};
+    }
+    void hasta(const K& k, bool cerrada){
+        if (!hi.hay || k < hi.k || (!(hi.k < k) && !cerrada)) hi = Cota{true, cerrada, k};
+    }
+    bool vacio() const {
+        if (!lo.hay || !hi.hay) return false;
+        if (hi.k < lo.k) return true;
+        return !(lo.k < hi.k) && !(lo.cerrada && hi.cerrada);
+    }
+};
+
+// Recorre el rango en un árbol (DiskBTree o DiskBPlusTree) llamando fn(clave, pageID) en orden de clave;
+// si fn devuelve false el recorrido del árbol se corta ahí y scan_range devuelve false. El árbol
+// solo sabe de rangos cerrados: una cota abierta se recorre cerrada y se saltan las entradas con
+// clave igual.
+template<template<class> class TREE, class TRAITS, class FN>
+inline bool scan_range(const TREE<TRAITS>& t, const IndexRangeScan<typename TRAITS::Key>& r, FN fn){
+    if (r.vacio()) return true;
+    uint8_t a[TRAITS::KEY_BYTES], b[TRAITS::KEY_BYTES];
+    const auto ka = r.lo.hay ? r.lo.k : LimitesClave<TRAITS>::min();
+    const auto kb = r.hi.hay ? r.hi.k : LimitesClave<TRAITS>::max();
+    TRAITS::put(a, ka); TRAITS::put(b, kb);
+    const bool skip_a = r.lo.hay && !r.lo.cerrada, skip_b = r.hi.hay && !r.hi.cerrada;
+    bool sigue = true;
+    t.range_scan(ka, kb, [&](const uint8_t* key, int page){
+        if (skip_a && TRAITS::cmp_mem(key, a)==0) return true;
+        if (skip_b && TRAITS::cmp_mem(key, b)==0) return true;
+        return sigue = fn(key, page);
+    });
+    return sigue;
+}
+
+// Valor de un predicado como clave del índice; false si el índice no sirve para ese valor.
+// exacta = false cuando la clave no representa el valor completo (CHAR de más de 31 bytes, que el
+// índice trunca): la cota queda cerrada y el filtro sobre la fila decide.
+inline bool clave_pred(const BoundPred& p, int32_t& k, bool&){ k = p.i; return true; }
+inline bool clave_pred(const BoundPred& p, float& k, bool&){ k = p.f; return !std::isnan(k); }
+inline bool clave_pred(const BoundPred& p, std::string& k, bool& exacta){
+    exacta = p.s.size() < (size_t)diskbtree::KeyChar32::KEY_BYTES;
+    k = exacta ? p.s : p.s.substr(0, (size_t)diskbtree::KeyChar32::KEY_BYTES - 1);
+    return true;
+}
+
+// Rangos del índice para el AND de preds sobre su columna: uno solo, o dos abiertos y disjuntos
+// (sin pageIDs repetidos) para un != suelto; preds vacío es el índice completo. false si el índice
+// no sirve para esos valores.
+template<class K>
+inline bool rangos_pred(const BoundWhere& bw, const std::vector<int>& preds, std::vector<IndexRangeScan<K>>& out){
+    IndexRangeScan<K> r;
+    for (int i : preds){
+        const BoundPred& p = bw.nodes[(size_t)i].pred;
+        K k{}; bool exacta = true;
+        if (!clave_pred(p, k, exacta)) return false;
+        switch (p.cmp){
+        case Cmp::EQ: r.desde(k, true); r.hasta(k, true); break;
+        case Cmp::GE: r.desde(k, true); break;
+        case Cmp::GT: r.desde(k, !exacta); break;
+        case Cmp::LE: r.hasta(k, true); break;
+        case Cmp::LT: r.hasta(k, !exacta); break;
+        case Cmp::NE: {
+            if (preds.size()!=1 || !exacta) return false;
+            IndexRangeScan<K> izq, der;
+            izq.hasta(k, false); der.desde(k, false);
+            out = {izq, der};
+            return true;
+        }
+        }
+    }
+    out.assign(1, r);
+    return true;
+}
+
+// Recorrido de un índice en orden de clave que entrega los pageIDs por tramos: el consumidor pide
+// otro tramo solo si lo necesita, así un LIMIT no recorre el rango entero
+class CursorIndice {
+public:
+    virtual ~CursorIndice() = default;
+    // Agrega a out los pageIDs siguientes; false si no quedaba ninguno
+    virtual bool tramo(std::vector<int>& out) = 0;
+};
+
+// Cursor sobre los rangos de un árbol. El árbol recorre con callback y sin estado: cada tramo baja
+// otra vez desde la raíz, saltea las entradas ya entregadas y corta al juntar cap. cap se duplica
+// en cada tramo, así lo salteado en total no pasa de lo entregado.
+template<class TREE>
+class CursorRangos : public CursorIndice {
+public:
+    using K = typename TREE::Traits::Key;
+    CursorRangos(const TREE& t, std::vector<IndexRangeScan<K>> r, size_t primer_tramo)
+        : tree(t), rangos(std::move(r)), cap(std::max<size_t>(primer_tramo, 1)) {}
+    bool tramo(std::vector<int>& out) override {
+        if (fin) return false;
+        const size_t n0 = out.size();
+        size_t saltar = hechas;
+        bool corto = false;
+        for (const auto& r : rangos){
+            corto = !scan_range(tree, r, [&](const uint8_t*, int page){
+                if (saltar){ --saltar; return true; }
+                out.push_back(page);
+                return out.size() - n0 < cap;
+            });
+            if (corto) break;
+        }
+        fin = !corto;
+        hechas += out.size() - n0;
+        cap = cap > SIZE_MAX / 2 ? SIZE_MAX : cap * 2;
+        return out.size() > n0;
+    }
+private:
+    const TREE& tree;
+    std::vector<IndexRangeScan<K>> rangos;
+    size_t cap, hechas = 0;
+    bool fin = false;
+};
+
+// Cursor en orden de clave descendente (ORDER BY ... DESC), de un solo tramo. Los árboles solo
+// recorren hacia adelante: se leen los rangos enteros, se cortan en grupos de igual clave y se
+// invierte el orden de los grupos. Dentro de un grupo las filas quedan por pageID ascendente, igual
+// que en SortOp/TopNOp, así el resultado (y un LIMIT/OFFSET encima) no depende de la ruta.
+template<class TREE>
+class CursorDesc : public CursorIndice {
+public:
+    using TR = typename TREE::Traits;
+    CursorDesc(const TREE& t, std::vector<IndexRangeScan<typename TR::Key>> r) : tree(t), rangos(std::move(r)) {}
+    bool tramo(std::vector<int>& out) override {
+        if (fin) return false;
+        fin = true;
+        std::vector<int> pids;
+        std::vector<size_t> grupos;   // inicio en pids de cada grupo de igual clave
+        uint8_t prev[TR::KEY_BYTES];
+        for (const auto& r : rangos){
+            scan_range(tree, r, [&](const uint8_t* key, int page){
+                if (grupos.empty() || TR::cmp_mem(key, prev)!=0){
+                    grupos.push_back(pids.size());
+                    std::memcpy(prev, key, TR::KEY_BYTES);
+                }
+                pids.push_back(page);
+                return true;
+            });
+        }
+        const size_t n0 = out.size();
+        out.reserve(n0 + pids.size());
+        for (size_t g = grupos.size(); g-- > 0;){
+            auto b = pids.begin() + (std::ptrdiff_t)grupos[g];
+            auto e = g + 1 < grupos.size() ? pids.begin() + (std::ptrdiff_t)grupos[g + 1] : pids.end();
+            std::sort(b, e);
+            out.insert(out.end(), b, e);
+        }
+        return out.size() > n0;
+    }
+private:
+    const TREE& tree;
+    std::vector<IndexRangeScan<typename TR::Key>> rangos;
+    bool fin = false;
+};
+
+template<class TRAITS, class BT, class BP>
+inline std::unique_ptr<CursorIndice> cursor_tipado(const BT* bt, const BP* bp, const BoundWhere& bw,
+                                                   const std::vector<int>& preds, size_t primer_tramo, bool desc){
+    std::vector<IndexRangeScan<typename TRAITS::Key>> rs;
+    if ((!bt && !bp) || !rangos_pred(bw, preds, rs)) return nullptr;
+    if (desc){
+        if (bp) return std::make_unique<CursorDesc<BP>>(*bp, std::move(rs));
+        return std::make_unique<CursorDesc<BT>>(*bt, std::move(rs));
+    }
+    if (bp) return std::make_unique<CursorRangos<BP>>(*bp, std::move(rs), primer_tramo);
+    return std::make_unique<CursorRangos<BT>>(*bt, std::move(rs), primer_tramo);
+}
+
+// Cursor en orden de clave sobre el índice ix (columna de tipo t) acotado por el AND de preds
+// (todo el índice si preds está vacío); nullptr si el índice no sirve para esos predicados.
+// primer_tramo: pageIDs del primer tramo (SIZE_MAX: todo de una vez); desc: orden de clave
+// descendente (un solo tramo, ver CursorDesc)
+inline std::unique_ptr<CursorIndice> cursor_indice(const minidb::IndiceRef& ix, ColType t, const BoundWhere& bw,
+                                                   const std::vector<int>& preds, size_t primer_tramo,
+                                                   bool desc = false){
+    switch (t){
+    case ColType::INT32:   return cursor_tipado<diskbtree::KeyInt>(ix.bt_int, ix.bp_int, bw, preds, primer_tramo, desc);
+    case ColType::FLOAT32: return cursor_tipado<diskbtree::KeyFloat>(ix.bt_float, ix.bp_float, bw, preds, primer_tramo, desc);
+    case ColType::CHAR:    return cursor_tipado<diskbtree::KeyChar32>(ix.bt_char, ix.bp_char, bw, preds, primer_tramo, desc);
+    }
+    return nullptr;
+}
+
+// pageIDs en orden de clave del índice ix (columna de tipo t) acotados por el AND de preds (todo el
+// índice si preds está vacío); false si el índice no sirve para esos predicados
+inline bool recorrer_indice(const minidb::IndiceRef& ix, ColType t, const BoundWhere& bw, const std::vector<int>& preds,
+                            std::vector<int>& out){
+    auto c = cursor_indice(ix, t, bw, preds, SIZE_MAX);
+    if (!c) return false;
+    c->tramo(out);
+    return true;
+}
+
+// Candidatos (pageIDs) del AND de predicados ya ligados (posiciones en bw) sobre la columna del
+// índice ix, en orden de clave. Devuelve false si el índice no sirve para esos predicados (hay que
+// recorrer la tabla); != solo va suelto. Puede entregar de más (el filtro exacto sobre la fila
+// decide), nunca de menos: EQ es el rango [k,k] y trae todos los duplicados de la clave.
+inline bool probe_index(const minidb::IndiceRef& ix, const BoundWhere& bw, const std::vector<int>& preds,
+                        std::vector<int>& out){
+    if (preds.empty()) return false;
+    const BoundPred& p = bw.nodes[(size_t)preds[0]].pred;
+    if (p.idx==-1) return false;
+    return recorrer_indice(ix, p.t, bw, preds, out);
+}
+
+// Ruta de acceso de un WHERE: árbol de sondeos de índice (hojas PROBE: un IndexRangeScan sobre
+// uno o más predicados de BoundWhere de la misma columna, por posición) combinados con intersección (AND) y unión (OR); el conjunto resultante
+// contiene todas las filas que cumplen el WHERE. Sin nodos: recorrido secuencial.
+struct AccessPath {
+    struct Node {
+        enum class Op { PROBE, AND, OR };
+        Op op = Op::PROBE;
+        std::vector<int> preds;       // PROBE: nodos de BoundWhere (AND sobre la columna del índice)
+        minidb::IndiceRef idx;        // PROBE
+        std::vector<int> args;        // AND/OR: hijos (AND: del más selectivo al menos)
+    };
+    std::vector<Node> nodes;
+    int root = -1;
+};
+
+// Conjunto de pageIDs de un nodo de la ruta; false si algún sondeo no sirve
+inline bool access_set(const AccessPath& ap, int i, const BoundWhere& bw, long nrows, pidset::PidSet& out){
+    const AccessPath::Node& n = ap.nodes[(size_t)i];
+    if (n.op==AccessPath::Node::Op::PROBE){
+        std::vector<int> v;
+        if (!probe_index(n.idx, bw, n.preds, v)) return false;
+        out = pidset::PidSet::from_unsorted(std::move(v), nrows);
+        return true;
+    }
+    if (n.args.empty()) return false;
+    bool first = true;
+    for (int c : n.args){
+        pidset::PidSet cs;
+        if (!access_set(ap, c, bw, nrows, cs)) return false;
+        if (first){ out = std::move(cs); first = false; }
+        else if (n.op==AccessPath::Node::Op::AND) out.intersect(cs);
+        else out.unite(cs);
+        if (n.op==AccessPath::Node::Op::AND && out.empty()) break;   // nada que intersecar
+    }
+    return true;
+}
+
+// Candidatos de la ruta; false si no hay ruta o algún sondeo no sirve (hay que recorrer). Quedan
+// ordenados por pageID y sin repetidos (también los de un solo sondeo, que vienen en orden de
+// clave), listos para leer las filas por tramos con GenericFixedTable::FetchRows/FetchRun.
+inline bool access_pids(const AccessPath& ap, const BoundWhere& bw, long nrows, std::vector<int>& out){
+    out.clear();
+    if (ap.root<0) return false;
+    pidset::PidSet s;
+    if (!access_set(ap, ap.root, bw, nrows, s)) return false;
+    s.to_vector(out);
+    return true;
+}
+
+// Selectividad estimada de un predicado con índice. No hay estadísticas: se decide por operador,
+// y la igualdad sobre una columna única (id) gana a cualquier otra.
+constexpr double SEL_UNICA = 0.0001;     // a lo sumo una fila: no vale la pena intersecar
+constexpr double SEL_INTERSECAR = 0.3;   // sondeos más amplios que esto no se intersecan
+inline double est_selectividad(const BoundPred& p, bool unica){
+    switch (p.cmp){
+    case Cmp::EQ: return unica ? SEL_UNICA : 0.01;
+    case Cmp::NE: return 0.9;
+    default:      return 0.3;
+    }
+}
+
+// ---------- Pipeline de ejecución ----------
+// Operadores tipo Volcano que se piden lotes de filas (Scan/IndexFetch -> Filter), sin listas
+// intermedias de pageIDs ni filas materializadas. Un lote son filas de un solo bloque leído
+// (mapeo o buffer del operador fuente) con un vector de selección: la fila i del lote es la fila
+// start + sel[i] de la tabla. Vale hasta el próximo next() de la cadena. Los operadores de ORDER BY
+// y GROUP BY entregan copias de filas en su propio buffer (CopiaOp): ahí pid() no es el pageID, y
+// las filas de GROUP BY tienen su propio formato (fmt) en vez del de la tabla.
+
+// Formato de filas que no son de la tabla (resultado de GROUP BY): columnas empaquetadas una tras
+// otra, descritas como el esquema en disco para verlas con RowView
+struct FormatoFila {
+    std::vector<gft::ColMetaDisk> cols;
+    size_t rs = 0;                    // ancho de fila
+
+    void agregar(const std::string& name, ColType t, int width){
+        gft::ColMetaDisk m{};
+        std::memcpy(m.name, name.data(), std::min(name.size(), sizeof(m.name) - 1));
+        m.type = (int32_t)t; m.width = width; m.offset = (int32_t)rs;
+        cols.push_back(m);
+        rs += (size_t)width;
+    }
+    RowView view(const char* p) const { return RowView(p, cols.data(), (int)cols.size()); }
+};
+
+struct RowBatch {
+    GenericFixedTable* tbl = nullptr;
+    const FormatoFila* fmt = nullptr; // no nulo: filas de ese formato (no de tbl)
+    const char* base = nullptr;       // fila 'start' del bloque
+    long start = 0;
+    std::vector<uint32_t> sel;        // filas del lote (offset desde start, ascendente)
+
+    size_t size() const { return sel.size(); }
+    long pid(size_t i) const { return start + (long)sel[i]; }
+    RowView row(size_t i) const {
+        if (fmt) return fmt->view(base + (size_t)sel[i] * fmt->rs);
+        return tbl->View(base + (size_t)sel[i] * (size_t)tbl->row_size());
+    }
+};
+
+// ---------- Filtro por lote ----------
+// El WHERE ligado se evalúa sobre todo un lote: las columnas INT/FLOAT se leen por offset fijo
+// (stride = ancho de fila) y se comparan con SIMD (BatchFilter.h) dando una máscara de bits; CHAR
+// se compara fila por fila. AND/OR combinan máscaras por palabra y solo evalúan las filas que
+// todavía pueden cambiar el resultado.
+static_assert(SQL_BATCH % 64 == 0, "SQL_BATCH debe ser múltiplo de 64 (máscaras por palabra)");
+constexpr size_t LOTE_WORDS = SQL_BATCH / 64;
+
+// Bits válidos de la palabra w en un lote de n filas
+inline uint64_t bits_lote(size_t n, size_t w){
+    const size_t r = n - w * 64;
+    return r >= 64 ? ~uint64_t(0) : ((uint64_t(1) << r) - 1);
+}
+
+// mask = filas del lote que cumplen p; solo importan las filas marcadas en 'importa' (el resto
+// queda indefinido)
+inline void pred_lote(const BoundPred& p, const RowBatch& b, const uint64_t* importa, uint64_t* mask){
+    const size_t n = b.size();
+    std::fill(mask, mask + LOTE_WORDS, 0);
+    if (p.idx==-1) return;
+    const size_t stride = (size_t)b.tbl->row_size(), off = (size_t)b.tbl->col_meta(p.idx).offset;
+    if (p.t==ColType::INT32){
+        int32_t vals[SQL_BATCH];
+        batchfilter::gather32(b.base, stride, off, b.sel.data(), n, vals);
+        batchfilter::compare(vals, n, p.cmp, p.i, mask);
+    } else if (p.t==ColType::FLOAT32){
+        float vals[SQL_BATCH];
+        batchfilter::gather32(b.base, stride, off, b.sel.data(), n, vals);
+        batchfilter::compare(vals, n, p.cmp, p.f, mask);
+    } else {
+        const std::string_view k(p.s);
+        for (size_t w = 0; w * 64 < n; ++w){
+            uint64_t x = importa[w] & bits_lote(n, w);
+            while (x){
+                const size_t i = w * 64 + (size_t)gft::detail::ctz64(x);
+                x &= x - 1;
+                if (cmp_apply(p.cmp, b.row(i).get_char_view(p.idx), k)) mask[w] |= uint64_t(1) << (i & 63);
+            }
+        }
+    }
+}
+
+inline void eval_lote(const BoundWhere& bw, int i, const RowBatch& b, const uint64_t* importa, uint64_t* mask){
+    const BoundWhere::Node& nd = bw.nodes[(size_t)i];
+    const size_t nw = (b.size() + 63) / 64;
+    switch (nd.kind){
+    case Expr::Kind::PRED: pred_lote(nd.pred, b, importa, mask); return;
+    case Expr::Kind::NOT:
+        eval_lote(bw, nd.args[0], b, importa, mask);
+        for (size_t w = 0; w < nw; ++w) mask[w] = ~mask[w];
+        return;
+    case Expr::Kind::AND:
+    case Expr::Kind::OR: {
+        const bool y = nd.kind==Expr::Kind::AND;
+        eval_lote(bw, nd.args[0], b, importa, mask);
+        uint64_t falta[LOTE_WORDS], tmp[LOTE_WORDS];
+        for (size_t k = 1; k < nd.args.size(); ++k){
+            // AND: solo las filas todavía verdaderas; OR: solo las todavía falsas
+            bool alguna = false;
+            for (size_t w = 0; w < nw; ++w){
+                falta[w] = importa[w] & (y ? mask[w] : ~mask[w]) & bits_lote(b.size(), w);
+                alguna |= falta[w] != 0;
+            }
+            if (!alguna) break;
+            eval_lote(bw, nd.args[k], b, falta, tmp);
+            for (size_t w = 0; w < nw; ++w) mask[w] = y ? (mask[w] & tmp[w]) : (mask[w] | tmp[w]);
+        }
+        return;
+    }
+    }
+}
+
+// Deja en el lote solo las filas vivas (id != -1) que cumplen bw
+inline void filtrar_lote(const BoundWhere& bw, int id_idx, RowBatch& b){
+    const size_t n = b.size();
+    if (n == 0) return;
+    uint64_t mask[LOTE_WORDS], tmp[LOTE_WORDS];
+    const size_t nw = (n + 63) / 64;
+    for (size_t w = 0; w < nw; ++w) mask[w] = bits_lote(n, w);
+    if (id_idx >= 0){
+        BoundPred vivo; vivo.idx = id_idx; vivo.t = ColType::INT32; vivo.cmp = Cmp::NE; vivo.i = -1;
+        pred_lote(vivo, b, mask, tmp);
+        for (size_t w = 0; w < nw; ++w) mask[w] &= tmp[w];
+    }
+    if (!bw.nodes.empty()){
+        eval_lote(bw, 0, b, mask, tmp);
+        for (size_t w = 0; w < nw; ++w) mask[w] &= tmp[w];
+    }
+    size_t k = 0;
+    for (size_t w = 0; w < nw; ++w){
+        uint64_t x = mask[w] & bits_lote(n, w);
+        while (x){
+            b.sel[k++] = b.sel[w * 64 + (size_t)gft::detail::ctz64(x)];
+            x &= x - 1;
+        }
+    }
+    b.sel.resize(k);
+}
+
+class Operator {
+public:
+    virtual ~Operator() = default;
+    // Siguiente lote (al menos una fila, a lo sumo SQL_BATCH); false al terminar
+    virtual bool next(RowBatch& out) = 0;
+};
+
+// Recorrido secuencial por bloques contiguos de 1 MiB (ReadBlock), salteando tombstones (.del)
+class ScanOp : public Operator {
+public:
+    explicit ScanOp(GenericFixedTable& t) : tbl(t) {
+        tbl.FlushBatch();
+        n = tbl.Count();
+        per_block = std::max<long>(1, (long)((1<<20) / tbl.row_size()));
+    }
+    bool next(RowBatch& out) override {
+        out.sel.clear();
+        while (out.sel.empty()){
+            if (next_pid >= blk_start + blk_cnt){
+                if (next_pid >= n) return false;
+                blk_start = next_pid;
+                blk_cnt = std::min(per_block, n - next_pid);
+                blk = tbl.ReadBlock(blk_start, blk_cnt, buf);
+            }
+            // un lote no cruza bloques
+            const long end = std::min(blk_start + blk_cnt, next_pid + (long)SQL_BATCH);
+            out.tbl = &tbl; out.fmt = nullptr; out.base = blk; out.start = blk_start;
+            tbl.AppendLive(next_pid, end, blk_start, out.sel);
+            next_pid = end;
+        }
+        return true;
+    }
+private:
+    GenericFixedTable& tbl;
+    long n = 0, per_block = 1, next_pid = 0, blk_start = 0, blk_cnt = 0;
+    const char* blk = nullptr;
+    std::vector<char> buf;
+};
+
+// Lectura de los candidatos de una ruta de acceso (pageIDs ordenados, ver access_pids) por tramos
+// contiguos (FetchRun), salteando tombstones
+class IndexFetchOp : public Operator {
+public:
+    IndexFetchOp(GenericFixedTable& t, std::vector<int>&& p) : tbl(t), pids(std::move(p)) {}
+    bool next(RowBatch& out) override {
+        out.sel.clear();
+        while (out.sel.size() < SQL_BATCH && pos < pids.size()){
+            const long pid = pids[pos];
+            if (pid >= blk_start + blk_cnt || pid < blk_start){
+                if (!out.sel.empty()) break;
+                blk_cnt = tbl.FetchRun(pids, pos);
+                if (blk_cnt == 0){ ++pos; continue; }
+                blk_start = pid;
+                blk = tbl.ReadBlock(blk_start, blk_cnt, buf);
+                out.tbl = &tbl; out.fmt = nullptr; out.base = blk; out.start = blk_start;
+            }
+            ++pos;
+            if (!tbl.IsDeleted(pid)) out.sel.push_back((uint32_t)(pid - blk_start));
+        }
+        return !out.sel.empty();
+    }
+private:
+    GenericFixedTable& tbl;
+    std::vector<int> pids; size_t pos = 0;
+    long blk_start = 0, blk_cnt = 0;
+    const char* blk = nullptr;
+    std::vector<char> buf;
+};
+
+// Base de los operadores que entregan filas en un orden propio o armadas por ellos: copian cada
+// fila a un buffer del operador y el lote apunta ahí (start = 0, sel = 0..k-1). Las filas son de
+// la tabla t o, con f no nulo, del formato f.
+class CopiaOp : public Operator {
+protected:
+    CopiaOp(GenericFixedTable* t, const FormatoFila* f)
+        : tabla(t), fmt(f), rs(f ? f->rs : (size_t)t->row_size()), buf(rs * SQL_BATCH) {}
+    GenericFixedTable* tabla;
+    const FormatoFila* fmt;
+    size_t rs;
+    std::vector<char> buf;
+
+    void empezar(RowBatch& out){ out.tbl = tabla; out.fmt = fmt; out.base = buf.data(); out.start = 0; out.sel.clear(); }
+    // Lugar de una fila más en el lote (ya agregada a sel)
+    char* reservar(RowBatch& out){
+        char* p = buf.data() + out.sel.size() * rs;
+        out.sel.push_back((uint32_t)out.sel.size());
+        return p;
+    }
+    void copiar(RowBatch& out, const void* row){ std::memcpy(reservar(out), row, rs); }
+};
+
+// Filas en el orden de un cursor de índice (orden de clave: ORDER BY sin ordenar, o un LIMIT que
+// no quiere leer todos los candidatos), salteando tombstones. Los pageIDs se piden al cursor por
+// tramos y cada fila se lee suelta, recién cuando se pide.
+class IndexOrderOp : public CopiaOp {
+public:
+    IndexOrderOp(GenericFixedTable& t, std::unique_ptr<CursorIndice> c) : CopiaOp(&t, nullptr), tbl(t), cursor(std::move(c)) {
+        tbl.FlushBatch();
+        n = tbl.Count();
+    }
+    bool next(RowBatch& out) override {
+        empezar(out);
+        while (out.sel.size() < SQL_BATCH){
+            if (pos >= pids.size()){
+                pids.clear(); pos = 0;
+                if (!cursor->tramo(pids)) break;
+            }
+            const long pid = pids[pos++];
+            if (pid < 0 || pid >= n || tbl.IsDeleted(pid)) continue;
+            copiar(out, tbl.ReadBlock(pid, 1, tmp));
+        }
+        return !out.sel.empty();
+    }
+private:
+    GenericFixedTable& tbl;
+    std::unique_ptr<CursorIndice> cursor;
+    std::vector<int> pids; size_t pos = 0;
+    long n = 0;
+    std::vector<char> tmp;
+};
+
+// Filtro: borrado lógico (id == -1) y WHERE ligado, por lote (filtrar_lote); compacta el vector de selección
+class FilterOp : public Operator {
+public:
+    FilterOp(std::unique_ptr<Operator> c, BoundWhere w, int id_col)
+        : child(std::move(c)), bw(std::move(w)), id_idx(id_col) {}
+    bool next(RowBatch& out) override {
+        while (child->next(out)){
+            filtrar_lote(bw, id_idx, out);
+            if (out.size()) return true;
+        }
+        return false;
+    }
+private:
+    std::unique_ptr<Operator> child;
+    BoundWhere bw;
+    int id_idx;
+};
+
+// Reparto de una tabla en morsels de 1 MiB para los recorridos paralelos (ParallelScanOp, AggOp):
+// tamaño y cantidad de morsels, hilos útiles, un BlockReader por hilo y el trabajo sobre un morsel.
+class MorselScan {
+public:
+    MorselScan(GenericFixedTable& t, unsigned threads) : tbl(t) {
+        tbl.FlushBatch();
+        n = tbl.Count();
+        per_morsel = std::max<long>(1, (long)((1<<20) / tbl.row_size()));
+        nmorsels = (n + per_morsel - 1) / per_morsel;
+        hilos = (unsigned)std::max<long>(1, std::min<long>((long)threads, nmorsels));
+    }
+    long morsels() const { return nmorsels; }
+    unsigned threads() const { return hilos; }
+    std::vector<GenericFixedTable::BlockReader> readers() const {
+        std::vector<GenericFixedTable::BlockReader> rs;
+        for (unsigned i = 0; i < hilos; ++i) rs.push_back(tbl.Reader());
+        return rs;
+    }
+
+    // Lee el morsel m con rd (en buf si no hay mapeo) y llama fn(lote) por cada tramo de hasta
+    // SQL_BATCH filas, con la selección ya reducida a las filas vivas que cumplen bw (puede quedar
+    // vacía). lote.base y lote.start son los del morsel entero.
+    template<class FN>
+    void morsel(GenericFixedTable::BlockReader& rd, long m, const BoundWhere& bw, int id_idx,
+                std::vector<char>& buf, FN&& fn) const {
+        const long start = m * per_morsel, cnt = std::min(per_morsel, n - start);
+        RowBatch lote;
+        lote.tbl = &tbl; lote.base = rd.Read(start, cnt, buf); lote.start = start;
+        for (long c = 0; c < cnt; c += SQL_BATCH){
+            lote.sel.clear();
+            tbl.AppendLive(start + c, start + std::min(cnt, c + (long)SQL_BATCH), start, lote.sel);
+            filtrar_lote(bw, id_idx, lote);
+            fn(lote);
+        }
+    }
+
+private:
+    GenericFixedTable& tbl;
+    long n = 0, per_morsel = 1, nmorsels = 0;
+    unsigned hilos = 1;
+};
+
+// Recorrido paralelo por morsels (Scan + Filter): [0, Count()) en tramos de 1 MiB (MorselScan) que
+// toman los hilos de trabajo, cada uno con su BlockReader, filtrando por lotes en el hilo. Los
+// lotes salen en orden de pageID: el consumidor toma los morsels en orden y los hilos trabajan a lo
+// sumo 2 * hilos morsels por delante (memoria acotada). gradual (LIMIT): la ventana por delante
+// empieza en un morsel y se duplica con cada morsel consumido, así un consumidor que corta pronto
+// no hace leer la tabla de más. La tabla no debe escribirse mientras el operador viva.
+class ParallelScanOp : public Operator {
+public:
+    ParallelScanOp(GenericFixedTable& t, BoundWhere w, int id_col, unsigned threads, bool gradual = false)
+        : tbl(t), bw(std::move(w)), id_idx(id_col), ms(t, threads), nmorsels(ms.morsels()) {
+        slots.resize((size_t)ms.threads() * 2);
+        ventana = gradual ? 1 : (long)slots.size();
+        auto readers = ms.readers();
+        for (auto& rd : readers)
+            workers.emplace_back([this, r = std::move(rd)]() mutable { work(r); });
+    }
+    ~ParallelScanOp() override {
+        { std::lock_guard<std::mutex> lk(mu); stop = true; }
+        cv.notify_all();
+        for (auto& th : workers) th.join();
+    }
+
+    bool next(RowBatch& out) override {
+        out.sel.clear();
+        while (cur < nmorsels){
+            Slot& s = slots[(size_t)(cur % (long)slots.size())];
+            if (!taken){
+                std::unique_lock<std::mutex> lk(mu);
+                cv.wait(lk, [&]{ return s.ready || error; });
+                if (error) std::rethrow_exception(error);
+                taken = true; off = 0;
+            }
+            if (off < s.sel.size()){
+                const size_t k = std::min(s.sel.size() - off, (size_t)SQL_BATCH);
+                out.tbl = &tbl; out.fmt = nullptr; out.base = s.base; out.start = s.start;
+                out.sel.assign(s.sel.begin() + (long)off, s.sel.begin() + (long)(off + k));
+                off += k;
+                return true;
+            }
+            // morsel consumido (el lote anterior ya no se usa): el slot queda libre
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                s.ready = false; ++cur;
+                ventana = std::min<long>((long)slots.size(), ventana * 2);
+            }
+            taken = false;
+            cv.notify_all();
+        }
+        return false;
+    }
+
+private:
+    struct Slot {
+        bool ready = false;
+        const char* base = nullptr;
+        long start = 0;
+        std::vector<uint32_t> sel;
+        std::vector<char> buf;        // filas del morsel sin mmap
     };
+    GenericFixedTable& tbl;
+    BoundWhere bw;
+    int id_idx;
+    MorselScan ms;
+    long nmorsels;
+    std::vector<Slot> slots;
+    std::vector<std::thread> workers;
+    std::mutex mu;
+    std::condition_variable cv;
+    long next_m = 0;                  // próximo morsel a repartir
+    long cur = 0;                     // morsel que consume next()
+    long ventana = 0;                 // morsels que los hilos pueden tener por delante de cur
+    bool stop = false;
+    std::exception_ptr error;
+    bool taken = false; size_t off = 0;
+
+    void work(GenericFixedTable::BlockReader& rd){
+        try {
+            while (true){
+                long m;
+                {
+                    std::unique_lock<std::mutex> lk(mu);
+                    if (stop || error || next_m >= nmorsels) return;
+                    m = next_m++;
+                    cv.wait(lk, [&]{ return stop || m < cur + ventana; });
+                    if (stop) return;
+                }
+                Slot& s = slots[(size_t)(m % (long)slots.size())];
+                s.sel.clear();
+                ms.morsel(rd, m, bw, id_idx, s.buf, [&](const RowBatch& lote){
+                    s.base = lote.base; s.start = lote.start;
+                    s.sel.insert(s.sel.end(), lote.sel.begin(), lote.sel.end());
+                });
+                { std::lock_guard<std::mutex> lk(mu); s.ready = true; }
+                cv.notify_all();
+            }
+        } catch (...) {
+            { std::lock_guard<std::mutex> lk(mu); if (!error) error = std::current_exception(); }
+            cv.notify_all();
+        }
+    }
+};
+
+inline unsigned scan_threads(){
+    const unsigned t = SQL_SCAN_THREADS;
+    return t ? t : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Filas vivas de tbl que cumplen bw: por la ruta de acceso si sirve, si no recorrido secuencial
+// (en paralelo si la tabla tiene al menos SQL_PAR_MIN_ROWS filas). con_limite: el consumidor puede
+// cortar pronto (LIMIT), así que nada se lee por adelantado: un sondeo suelto recorre el índice por
+// tramos en orden de clave (IndexOrderOp) en vez de juntar y ordenar todos los candidatos, y el
+// recorrido paralelo abre su ventana de a poco. Un AND/OR de sondeos necesita los conjuntos
+// completos para combinarlos.
+inline std::unique_ptr<Operator> armar_pipeline(GenericFixedTable& tbl, const AccessPath& ap, BoundWhere bw, int id_idx,
+                                                bool con_limite = false){
+    if (con_limite && ap.root>=0 && ap.nodes[(size_t)ap.root].op==AccessPath::Node::Op::PROBE){
+        const AccessPath::Node& pn = ap.nodes[(size_t)ap.root];
+        if (auto c = cursor_indice(pn.idx, bw.nodes[(size_t)pn.preds[0]].pred.t, bw, pn.preds, SQL_BATCH))
+            return std::make_unique<FilterOp>(std::make_unique<IndexOrderOp>(tbl, std::move(c)), std::move(bw), id_idx);
+    }
+    std::vector<int> pids;
+    std::unique_ptr<Operator> src;
+    if (access_pids(ap, bw, tbl.Count(), pids)) src = std::make_unique<IndexFetchOp>(tbl, std::move(pids));
+    else if (scan_threads() > 1 && tbl.Count() >= SQL_PAR_MIN_ROWS)
+        return std::make_unique<ParallelScanOp>(tbl, std::move(bw), id_idx, scan_threads(), con_limite);
+    else src = std::make_unique<ScanOp>(tbl);
+    return std::make_unique<FilterOp>(std::move(src), std::move(bw), id_idx);
+}
+
+// ---------- ORDER BY ----------
+// Clave de orden resuelta contra el esquema: tipo, offset y ancho del campo en la fila
+struct ClaveOrden { int idx = -1; ColType t{}; int off = 0; int width = 0; bool desc = false; };
+
+// Comparación de un campo de dos filas empaquetadas (<0, 0, >0). Orden total: FLOAT deja los NaN
+// al final; CHAR es binario hasta el primer '\0' (como las claves del índice).
+inline int cmp_campo(const ClaveOrden& k, const char* a, const char* b){
+    const char* pa = a + k.off;
+    const char* pb = b + k.off;
+    int c;
+    if (k.t==ColType::INT32){
+        int32_t x, y; std::memcpy(&x, pa, 4); std::memcpy(&y, pb, 4);
+        c = (x > y) - (x < y);
+    } else if (k.t==ColType::FLOAT32){
+        float x, y; std::memcpy(&x, pa, 4); std::memcpy(&y, pb, 4);
+        const bool nx = std::isnan(x), ny = std::isnan(y);
+        c = (nx || ny) ? (int)nx - (int)ny : (x > y) - (x < y);
+    } else {
+        c = std::string_view(pa, strnlen(pa, (size_t)k.width)).compare(std::string_view(pb, strnlen(pb, (size_t)k.width)));
+        c = (c > 0) - (c < 0);
+    }
+    return k.desc ? -c : c;
+}
 
-    if (pos_and!=std::string::npos){
-        auto a = expr.substr(0,pos_and), b = expr.substr(pos_and+5);
-        w.p1 = parse_pred(a); w.p2 = parse_pred(b); w.op="AND";
-        return w.p1.has_value() && w.p2.has_value();
-    }
-    if (pos_or!=std::string::npos){
-        auto a = expr.substr(0,pos_or), b = expr.substr(pos_or+4);
-        w.p1 = parse_pred(a); w.p2 = parse_pred(b); w.op="OR";
-        return w.p1.has_value() && w.p2.has_value();
-    }
-    w.p1 = parse_pred(expr); w.op="";
-    return w.p1.has_value();
-}
-
-// eval secuencial (usa tipos del schema)
-inline bool eval_pred_row(const Pred& p, const TableSchema& sc, const std::vector<Value>& row){
-    int idx=-1; ColType t{};
-    for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name==p.col){ idx=i; t=sc.cols[i].type; break; }
-    if (idx==-1) return false;
-    const auto& v = row[idx];
-
-    if (t==ColType::INT32){
-        int rhs = std::stoi(p.lit);
-        switch(p.cmp){
-        case Cmp::EQ: return v.i==rhs;
-        case Cmp::GE: return v.i>=rhs;
-        case Cmp::LE: return v.i<=rhs;
-        case Cmp::GT: return v.i> rhs;
-        case Cmp::LT: return v.i< rhs;
-        case Cmp::NE: return v.i!=rhs;
-        }
-    } else if (t==ColType::FLOAT32){
-        float rhs = std::stof(p.lit);
-        switch(p.cmp){
-        case Cmp::EQ: return v.f==rhs;
-        case Cmp::GE: return v.f>=rhs;
-        case Cmp::LE: return v.f<=rhs;
-        case Cmp::GT: return v.f> rhs;
-        case Cmp::LT: return v.f< rhs;
-        case Cmp::NE: return v.f!=rhs;
-        }
-    } else { // CHAR
-        std::string rhs = p.lit;
-        if (rhs.size()>=2 && rhs.front()=='\'' && rhs.back()=='\'') rhs = rhs.substr(1,rhs.size()-2);
-        switch(p.cmp){
-        case Cmp::EQ: return v.s==rhs;
-        case Cmp::GE: return v.s>=rhs;
-        case Cmp::LE: return v.s<=rhs;
-        case Cmp::GT: return v.s> rhs;
-        case Cmp::LT: return v.s< rhs;
-        case Cmp::NE: return v.s!=rhs;
+// Orden estricto de registros "fila + pageID (int32)" por las claves; a igual clave, por pageID
+// (el resultado no depende de cómo se leyeron las filas)
+struct OrdenFilas {
+    std::vector<ClaveOrden> claves;
+    size_t rs = 0;                    // ancho de fila (el pageID va después)
+    bool operator()(const uint8_t* a, const uint8_t* b) const {
+        for (const ClaveOrden& k : claves){
+            const int c = cmp_campo(k, reinterpret_cast<const char*>(a), reinterpret_cast<const char*>(b));
+            if (c) return c < 0;
         }
+        int32_t pa, pb; std::memcpy(&pa, a + rs, 4); std::memcpy(&pb, b + rs, 4);
+        return pa < pb;
     }
-    return false;
+};
+
+// Registro "fila + pageID" de la fila i de un lote de la fuente
+inline void registro_orden(const RowBatch& b, size_t i, size_t rs, uint8_t* rec){
+    std::memcpy(rec, b.base + (size_t)b.sel[i] * rs, rs);
+    const int32_t pid = (int32_t)b.pid(i);
+    std::memcpy(rec + rs, &pid, 4);
+}
+
+// ORDER BY: en el primer next() consume la entrada y la ordena con extsort::ExternalSorter. La
+// memoria queda acotada a mem_bytes; lo que no entra se vuelca en corridas ordenadas bajo tmp_prefix
+// (se borran al destruir el operador) que se mezclan al entregar. Filas de t o del formato f.
+class SortOp : public CopiaOp {
+public:
+    SortOp(std::unique_ptr<Operator> c, GenericFixedTable* t, const FormatoFila* f, std::vector<ClaveOrden> claves,
+           const std::string& tmp_prefix, size_t mem_bytes)
+        : CopiaOp(t, f), child(std::move(c)), sorter(rs + 4, OrdenFilas{std::move(claves), rs}, tmp_prefix, mem_bytes) {}
+    bool next(RowBatch& out) override {
+        if (child){ cargar(); child.reset(); }
+        empezar(out);
+        while (out.sel.size() < SQL_BATCH){
+            const uint8_t* r = sorter.next();
+            if (!r) break;
+            copiar(out, r);
+        }
+        return !out.sel.empty();
+    }
+private:
+    std::unique_ptr<Operator> child;
+    extsort::ExternalSorter<OrdenFilas> sorter;
+
+    void cargar(){
+        RowBatch b;
+        std::vector<uint8_t> rec(rs + 4);
+        while (child->next(b))
+            for (size_t i = 0; i < b.size(); ++i){ registro_orden(b, i, rs, rec.data()); sorter.add(rec.data()); }
+        sorter.finish();
+    }
+};
+
+// ORDER BY ... LIMIT n con n chico: montículo de a lo sumo n registros con el peor arriba; una fila
+// entra solo si es mejor que ese peor. Memoria n * (fila + 4), sin disco ni orden completo.
+class TopNOp : public CopiaOp {
+public:
+    TopNOp(std::unique_ptr<Operator> c, GenericFixedTable* t, const FormatoFila* f, std::vector<ClaveOrden> claves, size_t n)
+        : CopiaOp(t, f), child(std::move(c)), lt{std::move(claves), rs}, limite(n), rec(rs + 4) {}
+    bool next(RowBatch& out) override {
+        if (child){ cargar(); child.reset(); }
+        empezar(out);
+        while (out.sel.size() < SQL_BATCH && pos < heap.size()) copiar(out, reg(heap[pos++]));
+        return !out.sel.empty();
+    }
+private:
+    std::unique_ptr<Operator> child;
+    OrdenFilas lt;
+    size_t limite, rec;
+    std::vector<uint8_t> datos;       // registros (a lo sumo limite)
+    std::vector<uint32_t> heap;       // posiciones en datos; al final, en orden
+    size_t pos = 0;
+
+    const uint8_t* reg(uint32_t i) const { return datos.data() + (size_t)i * rec; }
+    void cargar(){
+        if (limite == 0) return;
+        auto peor = [this](uint32_t a, uint32_t b){ return lt(reg(a), reg(b)); };
+        std::vector<uint8_t> r(rec);
+        RowBatch b;
+        while (child->next(b)){
+            for (size_t i = 0; i < b.size(); ++i){
+                registro_orden(b, i, rs, r.data());
+                if (heap.size() < limite){
+                    datos.insert(datos.end(), r.begin(), r.end());
+                    heap.push_back((uint32_t)heap.size());
+                    std::push_heap(heap.begin(), heap.end(), peor);
+                } else if (lt(r.data(), reg(heap.front()))){
+                    std::pop_heap(heap.begin(), heap.end(), peor);
+                    std::memcpy(datos.data() + (size_t)heap.back() * rec, r.data(), rec);
+                    std::push_heap(heap.begin(), heap.end(), peor);
+                }
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end(), peor);
+    }
+};
+
+// ---------- GROUP BY / agregados ----------
+// Columna de GROUP BY: campo de la fila de entrada y su lugar (pos) en la clave del grupo
+struct CampoGrupo { int idx = -1; ColType t{}; int off = 0; int width = 0; size_t pos = 0; };
+
+// Agregado sobre el campo idx de la entrada (COUNT(*): idx = -1) con su estado en est dentro del
+// estado del grupo: SUM/AVG de INT en int64, de FLOAT en double, MIN/MAX una copia del campo.
+// COUNT usa la cuenta de filas del grupo (no hay NULL).
+struct Agregado { AggFn fn = AggFn::NONE; int idx = -1; ColType t{}; int off = 0; int width = 0; size_t est = 0; };
+
+// Valor de un agregado de INT acumulado en 64 bits para la columna de salida m; error si no entra
+// en INT
+inline int32_t a_int(int64_t v, const gft::ColMetaDisk& m){
+    if (v < std::numeric_limits<int32_t>::min() || v > std::numeric_limits<int32_t>::max())
+        throw std::overflow_error(std::string(m.name, strnlen(m.name, sizeof m.name)) + " no entra en INT");
+    return (int32_t)v;
 }
 
+// Agregación planificada: clave del grupo (columnas de GROUP BY normalizadas, se compara por
+// bytes), estado por grupo ([cuenta: int64][estado de cada agregado]) y fila de salida con una
+// columna por elemento del SELECT (columna del grupo o agregado), en el formato fmt.
+struct Agregacion {
+    struct Salida { int grupo = -1; int agg = -1; };
+    std::vector<CampoGrupo> grupo;
+    std::vector<Agregado> aggs;
+    std::vector<Salida> salida;
+    size_t key_bytes = 0;
+    size_t state_bytes = 8;
+    FormatoFila fmt;
+
+    static int64_t cuenta(const uint8_t* st){ int64_t c; std::memcpy(&c, st, 8); return c; }
+
+    // Clave de la fila: CHAR con ceros después del primer '\0' y FLOAT con -0 como 0 y un único
+    // NaN, así valores iguales dan los mismos bytes
+    void clave(const char* row, uint8_t* key) const {
+        for (const CampoGrupo& g : grupo){
+            const char* p = row + g.off;
+            uint8_t* k = key + g.pos;
+            if (g.t==ColType::CHAR){
+                const size_t n = strnlen(p, (size_t)g.width);
+                std::memcpy(k, p, n);
+                std::memset(k + n, 0, (size_t)g.width - n);
+            } else if (g.t==ColType::FLOAT32){
+                float f; std::memcpy(&f, p, 4);
+                if (f == 0.0f) f = 0.0f;
+                else if (std::isnan(f)) f = std::numeric_limits<float>::quiet_NaN();
+                std::memcpy(k, &f, 4);
+            } else std::memcpy(k, p, 4);
+        }
+    }
+
+    // Estado de un grupo con su primera fila
+    void iniciar(uint8_t* st, const char* row) const {
+        const int64_t uno = 1;
+        std::memcpy(st, &uno, 8);
+        for (const Agregado& a : aggs){
+            uint8_t* e = st + a.est;
+            const char* v = row + a.off;
+            if (a.fn==AggFn::SUM || a.fn==AggFn::AVG){
+                if (a.t==ColType::INT32){ int32_t x; std::memcpy(&x, v, 4); const int64_t s = x; std::memcpy(e, &s, 8); }
+                else { float x; std::memcpy(&x, v, 4); const double s = x; std::memcpy(e, &s, 8); }
+            } else if (a.fn==AggFn::MIN || a.fn==AggFn::MAX) std::memcpy(e, v, (size_t)a.width);
+        }
+    }
+
+    void acumular(uint8_t* st, const char* row) const {
+        const int64_t c = cuenta(st) + 1;
+        std::memcpy(st, &c, 8);
+        for (const Agregado& a : aggs){
+            uint8_t* e = st + a.est;
+            const char* v = row + a.off;
+            if (a.fn==AggFn::SUM || a.fn==AggFn::AVG){
+                if (a.t==ColType::INT32){ int64_t s; int32_t x; std::memcpy(&s, e, 8); std::memcpy(&x, v, 4); s += x; std::memcpy(e, &s, 8); }
+                else { double s; float x; std::memcpy(&s, e, 8); std::memcpy(&x, v, 4); s += x; std::memcpy(e, &s, 8); }
+            } else if (a.fn==AggFn::MIN || a.fn==AggFn::MAX) mejor(a, e, v);
+        }
+    }
+
+    // Junta dos estados parciales del mismo grupo (de otro hilo o de una partición volcada)
+    void combinar(uint8_t* dst, const uint8_t* src) const {
+        if (cuenta(src)==0) return;
+        if (cuenta(dst)==0){ std::memcpy(dst, src, state_bytes); return; }
+        const int64_t c = cuenta(dst) + cuenta(src);
+        std::memcpy(dst, &c, 8);
+        for (const Agregado& a : aggs){
+            uint8_t* e = dst + a.est;
+            const uint8_t* o = src + a.est;
+            if (a.fn==AggFn::SUM || a.fn==AggFn::AVG){
+                if (a.t==ColType::INT32){ int64_t s, x; std::memcpy(&s, e, 8); std::memcpy(&x, o, 8); s += x; std::memcpy(e, &s, 8); }
+                else { double s, x; std::memcpy(&s, e, 8); std::memcpy(&x, o, 8); s += x; std::memcpy(e, &s, 8); }
+            } else if (a.fn==AggFn::MIN || a.fn==AggFn::MAX) mejor(a, e, reinterpret_cast<const char*>(o));
+        }
+    }
+
+    // Fila de salida del grupo (key, st). Un estado sin filas (sin GROUP BY y sin entrada) da
+    // COUNT y SUM 0, AVG y MIN/MAX de FLOAT NaN, MIN/MAX de INT 0 y de CHAR ''. COUNT o SUM de INT
+    // que no entra en INT es un error.
+    void emitir(const uint8_t* key, const uint8_t* st, char* out) const {
+        const int64_t n = cuenta(st);
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        for (size_t j = 0; j < salida.size(); ++j){
+            const gft::ColMetaDisk& m = fmt.cols[j];
+            char* o = out + m.offset;
+            if (salida[j].grupo >= 0){
+                const CampoGrupo& g = grupo[(size_t)salida[j].grupo];
+                std::memcpy(o, key + g.pos, (size_t)g.width);
+                continue;
+            }
+            const Agregado& a = aggs[(size_t)salida[j].agg];
+            const uint8_t* e = st + a.est;
+            switch (a.fn){
+            case AggFn::COUNT: { const int32_t c = a_int(n, m); std::memcpy(o, &c, 4); break; }
+            case AggFn::SUM:
+                if (a.t==ColType::INT32){
+                    int64_t s; std::memcpy(&s, e, 8);
+                    const int32_t v = a_int(s, m); std::memcpy(o, &v, 4);
+                } else { double s; std::memcpy(&s, e, 8); const float v = (float)s; std::memcpy(o, &v, 4); }
+                break;
+            case AggFn::AVG: {
+                float v = nan;
+                if (n && a.t==ColType::INT32){ int64_t s; std::memcpy(&s, e, 8); v = (float)((double)s / (double)n); }
+                else if (n){ double s; std::memcpy(&s, e, 8); v = (float)(s / (double)n); }
+                std::memcpy(o, &v, 4);
+                break;
+            }
+            default:   // MIN / MAX
+                if (n) std::memcpy(o, e, (size_t)a.width);
+                else if (a.t==ColType::FLOAT32) std::memcpy(o, &nan, 4);
+                else std::memset(o, 0, (size_t)a.width);
+            }
+        }
+    }
+
+private:
+    // MIN/MAX: e queda con el menor/mayor entre e y v, con el orden de ORDER BY (NaN al final)
+    static void mejor(const Agregado& a, uint8_t* e, const char* v){
+        const int c = cmp_campo(ClaveOrden{a.idx, a.t, 0, a.width, false}, v, reinterpret_cast<const char*>(e));
+        if (a.fn==AggFn::MIN ? c < 0 : c > 0) std::memcpy(e, v, (size_t)a.width);
+    }
+};
+
+// GROUP BY / agregados por hash. En el primer next() consume la entrada: cada fila va al estado de
+// su grupo en una tabla de direccionamiento abierto (hashagg::Agregador), que se vuelca a disco
+// por particiones bajo tmp_prefix si pasa de mem_bytes; después entrega una fila por grupo en el
+// formato de la Agregacion (pid() = número de grupo). Sin GROUP BY hay un único estado y siempre
+// una fila, aunque no haya entrada. La versión paralela reparte la tabla en morsels (MorselScan,
+// como ParallelScanOp); cada hilo filtra y agrega en su propio agregador parcial (con una parte de
+// la memoria) y al final los parciales se juntan en el primero.
+class AggOp : public CopiaOp {
+public:
+    // Sobre las filas de t que entrega c
+    AggOp(std::unique_ptr<Operator> c, GenericFixedTable& t, const Agregacion& a,
+          const std::string& tmp_prefix, size_t mem_bytes)
+        : CopiaOp(nullptr, &a.fmt), ag(a), tbl(t), child(std::move(c)), mem(mem_bytes) {
+        parciales.push_back(std::make_unique<Parcial>(ag, tmp_prefix, mem));
+    }
+    // Recorrido paralelo de t (filas vivas que cumplen w) en a lo sumo threads hilos
+    AggOp(GenericFixedTable& t, BoundWhere w, int id_col, unsigned threads, const Agregacion& a,
+          const std::string& tmp_prefix, size_t mem_bytes)
+        : CopiaOp(nullptr, &a.fmt), ag(a), tbl(t), bw(std::move(w)), id_idx(id_col), mem(mem_bytes),
+          ms(std::make_unique<MorselScan>(t, threads)) {
+        const size_t hilos = ms->threads();
+        for (size_t i = 0; i < hilos; ++i)
+            parciales.push_back(std::make_unique<Parcial>(ag, tmp_prefix + "." + std::to_string(i), mem / hilos));
+    }
+
+    bool next(RowBatch& out) override {
+        if (!cargado){ cargar(); cargado = true; }
+        empezar(out);
+        out.start = emitidas;
+        Parcial& p = *parciales[0];
+        if (ag.grupo.empty()){
+            if (emitidas == 0) ag.emitir(nullptr, p.unico.data(), reservar(out));
+        } else {
+            const uint8_t *k, *st;
+            while (out.sel.size() < SQL_BATCH && p.tabla.siguiente(k, st)) ag.emitir(k, st, reservar(out));
+        }
+        emitidas += (long)out.sel.size();
+        return !out.sel.empty();
+    }
+
+private:
+    struct Combinar {
+        const Agregacion* a;
+        void operator()(uint8_t* dst, const uint8_t* src) const { a->combinar(dst, src); }
+    };
+    struct Parcial {
+        hashagg::Agregador<Combinar> tabla;
+        std::vector<uint8_t> unico;   // estado sin GROUP BY
+        std::vector<uint8_t> clave;   // clave de la fila actual
+        Parcial(const Agregacion& a, const std::string& tmp, size_t m)
+            : tabla(a.key_bytes, a.state_bytes, Combinar{&a}, tmp, m), unico(a.state_bytes, 0), clave(a.key_bytes) {}
+    };
+    const Agregacion& ag;
+    GenericFixedTable& tbl;
+    std::unique_ptr<Operator> child;  // nulo: recorrido paralelo
+    BoundWhere bw;
+    int id_idx = -1;
+    size_t mem;
+    std::unique_ptr<MorselScan> ms;   // recorrido paralelo (nulo con child)
+    std::vector<std::unique_ptr<Parcial>> parciales;   // uno por hilo
+    bool cargado = false;
+    long emitidas = 0;
+
+    void sumar(Parcial& p, const char* row){
+        if (ag.grupo.empty()){
+            if (Agregacion::cuenta(p.unico.data())) ag.acumular(p.unico.data(), row);
+            else ag.iniciar(p.unico.data(), row);
+            return;
+        }
+        ag.clave(row, p.clave.data());
+        bool nuevo;
+        uint8_t* st = p.tabla.grupo(p.clave.data(), nuevo);
+        if (nuevo) ag.iniciar(st, row);
+        else ag.acumular(st, row);
+    }
+
+    void cargar(){
+        const size_t in_rs = (size_t)tbl.row_size();
+        if (child){
+            RowBatch b;
+            while (child->next(b))
+                for (size_t i = 0; i < b.size(); ++i) sumar(*parciales[0], b.base + (size_t)b.sel[i] * in_rs);
+            child.reset();
+            return;
+        }
+        const long nmorsels = ms->morsels();
+        std::atomic<long> next_m{0};
+        std::mutex mu;
+        std::exception_ptr error;
+        auto readers = ms->readers();
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < parciales.size(); ++i)
+            workers.emplace_back([&, i]{
+                Parcial& p = *parciales[i];
+                std::vector<char> buf;
+                try {
+                    for (long m; (m = next_m.fetch_add(1)) < nmorsels; ){
+                        ms->morsel(readers[i], m, bw, id_idx, buf, [&](const RowBatch& lote){
+                            for (uint32_t s : lote.sel) sumar(p, lote.base + (size_t)s * in_rs);
+                        });
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lk(mu);
+                    if (!error) error = std::current_exception();
+                    next_m = nmorsels;   // los demás hilos terminan con su morsel actual
+                }
+            });
+        for (auto& th : workers) th.join();
+        if (error) std::rethrow_exception(error);
+        // los parciales se juntan en el primero, que se queda con toda la memoria
+        Parcial& p0 = *parciales[0];
+        p0.tabla.memoria(mem);
+        for (size_t i = 1; i < parciales.size(); ++i){
+            if (ag.grupo.empty()) ag.combinar(p0.unico.data(), parciales[i]->unico.data());
+            else p0.tabla.absorber(parciales[i]->tabla);
+        }
+    }
+};
+
+// SELECT COUNT(*) [, COUNT(col) ...] sin WHERE ni GROUP BY: una fila con la cuenta de filas vivas
+// (MiniDatabase::filas_vivas, sin recorrer la tabla) en cada columna
+class ConteoOp : public CopiaOp {
+public:
+    ConteoOp(const FormatoFila& f, long filas) : CopiaOp(nullptr, &f), cuenta(filas) {}
+    bool next(RowBatch& out) override {
+        empezar(out);
+        if (hecho) return false;
+        hecho = true;
+        char* r = reservar(out);
+        for (const auto& c : fmt->cols){ const int32_t v = a_int(cuenta, c); std::memcpy(r + c.offset, &v, 4); }
+        return true;
+    }
+private:
+    long cuenta;
+    bool hecho = false;
+};
+
+// Destino de un SELECT (Project -> Sink): begin() con los nombres de la proyección, row() por cada
+// fila con las posiciones de las columnas proyectadas (sin copiar la fila; false corta la
+// ejecución) y end() con la cantidad de filas entregadas. La consola y la tabla del Workbench
+// son sinks.
+class RowSink {
+public:
+    virtual ~RowSink() = default;
+    virtual void begin(const std::vector<std::string>& names) { (void)names; }
+    virtual bool row(const RowView& r, const std::vector<int>& proj) = 0;
+    virtual void end(size_t n) { (void)n; }
+};
+
+// Salida de texto del CLI: encabezado, "a | b | c" por fila y "(filas: N)"
+class TextSink : public RowSink {
+public:
+    explicit TextSink(std::ostream& out) : os(out) {}
+    void begin(const std::vector<std::string>& names) override {
+        for (size_t j=0;j<names.size();++j) os << names[j] << (j+1<names.size() ? " | " : "\n");
+    }
+    bool row(const RowView& r, const std::vector<int>& proj) override {
+        for (size_t j=0;j<proj.size();++j){
+            int i = proj[j];
+            if (r.type(i)==ColType::INT32) os << r.get_int(i);
+            else if (r.type(i)==ColType::FLOAT32) os << r.get_float(i);
+            else os << r.get_char_view(i);
+            os << (j+1<proj.size() ? " | " : "\n");
+        }
+        return true;
+    }
+    void end(size_t n) override { os << "(filas: " << n << ")\n"; }
+private:
+    std::ostream& os;
+};
+
+// ---------- Planes y sentencias preparadas ----------
+// Plan reutilizable de una sentencia con parámetros '?': predicados ligados al esquema y la ruta
+// de acceso elegida (se sondea sin buscar por nombre). SELECT guarda además la proyección, el orden
+// y la agregación; UPDATE, los SET ya convertidos al tipo de su columna. Vale mientras
+// MiniDatabase::generacion() no cambie; si cambia, se vuelve a planificar desde sql.
+struct Plan {
+    enum class Kind { SELECT, UPDATE, DELETE };
+    Kind kind = Kind::SELECT;
+    std::string sql;                  // texto normalizado (clave de la caché)
+    uint64_t gen = 0;
+    int nparams = 0;
+    std::string table;
+    GenericFixedTable* tbl = nullptr; // tabla del catálogo
+    bool has_where = false;
+    BoundWhere bw;                    // los '?' quedan pendientes hasta bind_param
+    int id_idx = -1;                  // filas con id == -1 son borradas lógicas
+    AccessPath access;                // sin nodos: recorrido secuencial
+    // UPDATE: columna y valor de cada SET; set_params[k] es el '?' del SET k (-1: literal) y el
+    // valor de un '?' solo trae el tipo de la columna hasta ligarlo (value_as)
+    std::vector<std::pair<std::string, Value>> sets;
+    std::vector<int> set_params;
+    // SELECT
+    std::vector<int> proj_idx;
+    std::vector<std::string> proj_names;
+    std::vector<ClaveOrden> orden;    // ORDER BY (vacía: orden de lectura)
+    long limite = -1;                 // LIMIT (-1: sin límite)
+    long offset = 0;                  // OFFSET: filas a saltear antes de entregar
+    bool orden_indice = false;        // ORDER BY recorriendo idx_orden en orden de clave (plan_orden)
+    minidb::IndiceRef idx_orden;
+    std::vector<int> preds_orden;     // cotas de ese recorrido (nodos de bw; vacía: índice completo)
+    // GROUP BY / agregados: la proyección son las columnas de agg.fmt y ORDER BY ordena esas filas
+    bool agrega = false;
+    Agregacion agg;
+    bool conteo_directo = false;      // solo COUNT, sin WHERE ni GROUP BY: filas vivas sin recorrer
+};
+
+class SQLExecutor;
+
+// Sentencia preparada al estilo SQLite: bind(i, v) liga el '?' número i (desde 1) y step() avanza.
+// SELECT: step() devuelve true mientras haya fila (column()/row()); UPDATE/DELETE: step() ejecuta
+// y devuelve false, changes() da las filas afectadas. reset() vuelve al inicio conservando los
+// parámetros. Los errores dejan step() en false con error() no vacío. No debe sobrevivir al
+// SQLExecutor que la creó, y la tabla no debe escribirse mientras un SELECT esté a medio recorrer
+// (el recorrido paralelo sigue leyendo en segundo plano).
+class Statement {
+public:
+    Statement() = default;
+
+    bool valid() const { return plan != nullptr; }
+    const std::string& error() const { return err; }
+    int param_count() const { return plan ? plan->nparams : 0; }
+
+    void bind(int i, const Value& v){
+        if (!plan || i < 1 || i > plan->nparams) throw std::out_of_range("Parámetro fuera de rango");
+        params[(size_t)i-1] = v;
+        reset();
+    }
+    bool step();
+    void reset(){ started = done = false; pipe.reset(); batch.sel.clear(); bpos = 0; nfilas = nsaltadas = 0; nchanges = 0; err.clear(); }
+
+    int column_count() const { return plan ? (int)plan->proj_idx.size() : 0; }
+    const std::string& column_name(int j) const { return plan->proj_names.at((size_t)j); }
+    Value column(int j) const { return cur.get(plan->proj_idx.at((size_t)j)); }
+    const std::vector<int>& projection() const { return plan->proj_idx; }
+    const RowView& row() const { return cur; }          // fila completa actual (SELECT)
+    long changes() const { return nchanges; }
+
+private:
+    friend class SQLExecutor;
+    SQLExecutor* ex = nullptr;
+    std::shared_ptr<const Plan> plan;
+    std::vector<std::optional<Value>> params;
+    std::string err;
+
+    // cursor: pipeline del SELECT y lote actual
+    bool started = false, done = false;
+    std::unique_ptr<Operator> pipe;
+    RowBatch batch; size_t bpos = 0;
+    RowView cur;
+    long nfilas = 0;                  // filas entregadas (LIMIT)
+    long nsaltadas = 0;               // filas descartadas (OFFSET)
+    long nchanges = 0;
+};
+
 // --- helper: halla el ')' correspondiente a '(' en open_pos (respeta anidamiento) ---
 inline size_t find_matching_rparen(const std::string& s, size_t open_pos) {
     if (open_pos == std::string::npos || s[open_pos] != '(') return std::string::npos;
@@ -219,28 +1656,105 @@ public:
     void execute(const std::string& sql) {
         auto s = trim(sql);
         if (s.empty()) return;
-        std::string up = to_upper(s);
-        if (s.back()==';') { s.pop_back(); up.pop_back(); }
-
-        if      (up.rfind("CREATE DATABASE ",0)==0) cmd_CREATE_DATABASE(trim(s.substr(16)));
-        else if (up.rfind("USE ",0)==0)              cmd_USE(trim(s.substr(4)));
-        else if (up=="CLOSE DATABASE" || up=="CLOSE") cmd_CLOSE();
-        else if (up=="SHOW TABLES")                  cmd_SHOW_TABLES();
-        else if (up.rfind("CREATE TABLE",0)==0)      cmd_CREATE_TABLE(s);
-        else if (up.rfind("INSERT INTO",0)==0)       cmd_INSERT_INTO(s);
-        else if (up.rfind("SELECT",0)==0)            cmd_SELECT(s);
-        else if (up.rfind("DELETE FROM",0)==0)       cmd_DELETE_FROM(s);
-        else if (up.rfind("UPDATE ",0)==0)            cmd_UPDATE(s);
-        else if (up.rfind("CREATE INDEX",0)==0)      cmd_CREATE_INDEX(s);
+        if (s.back()==';') s.pop_back();
+
+        // despacho por las primeras palabras, sin copia en mayúsculas de la sentencia
+        if      (starts_kw(s, "CREATE DATABASE "))  cmd_CREATE_DATABASE(trim(s.substr(16)));
+        else if (starts_kw(s, "USE "))              cmd_USE(trim(s.substr(4)));
+        else if (iequals(s, "CLOSE DATABASE") || iequals(s, "CLOSE")) cmd_CLOSE();
+        else if (iequals(s, "SHOW TABLES"))         cmd_SHOW_TABLES();
+        else if (starts_kw(s, "CREATE TABLE"))      cmd_CREATE_TABLE(s);
+        else if (starts_kw(s, "INSERT INTO"))       cmd_INSERT_INTO(s);
+        else if (starts_kw(s, "SELECT"))            cmd_SELECT(s);
+        else if (starts_kw(s, "DELETE FROM"))       cmd_DELETE_FROM(s);
+        else if (starts_kw(s, "UPDATE "))           cmd_UPDATE(s);
+        else if (starts_kw(s, "CREATE INDEX"))      cmd_CREATE_INDEX(s);
+        else if (starts_kw(s, "COPY "))             cmd_COPY(s);
+        else if (starts_kw(s, "PREPARE "))          cmd_PREPARE(s);
+        else if (starts_kw(s, "EXECUTE "))          cmd_EXECUTE(s);
+        else if (starts_kw(s, "DEALLOCATE "))       cmd_DEALLOCATE(s);
         else os << "Comando no soportado.\n";
     }
 
+    // Prepara un SELECT/UPDATE/DELETE con parámetros '?'. El plan (parseo, columnas resueltas e
+    // índice elegido) se guarda en una caché por texto normalizado: preparar otra vez la misma
+    // forma no vuelve a parsear. Si falla, la sentencia queda !valid() con error().
+    Statement prepare(const std::string& sql){
+        Statement st; st.ex = this;
+        if (!opened){ st.err = "Abra una base con USE."; return st; }
+        std::string key = normalize_sql(sql);
+        auto it = planes.find(key);
+        if (it != planes.end() && it->second->gen == db.generacion()) st.plan = it->second;
+        else if (!(st.plan = planificar(key, st.err))) return st;
+        st.params.assign((size_t)st.plan->nparams, std::nullopt);
+        return st;
+    }
+
+    // Ejecuta un SELECT sin parámetros entregando las filas a sink a medida que se leen (la consola
+    // usa TextSink, el Workbench su modelo de tabla). false con err si no se pudo planificar.
+    bool select(const std::string& full, RowSink& sink, std::string& err){
+        if (!opened){ err = "Abra una base con USE."; return false; }
+        SelectStmt st;
+        if (!parse_select(full, st, err)) return false;
+        if (st.nparams){ err = "Parámetros '?' solo con PREPARE/EXECUTE."; return false; }
+        Where w{};
+        if (st.where) to_where(*st.where, w);
+        if (!catalogo_tabla(st.table)){ err = "Tabla no existe."; return false; }
+        if (st.star) ensure_default_id_index(st.table);
+
+        // plan de un solo uso (los literales no se cachean: cada texto sería una entrada nueva)
+        auto p = std::make_shared<Plan>();
+        if (!plan_select(*p, st, w, err)) return false;
+        Statement s; s.ex = this; s.plan = std::move(p);
+        return emitir(s, sink, err);
+    }
+
+    // Memoria de un ORDER BY antes de volcar corridas ordenadas a disco (también decide hasta qué
+    // LIMIT se usa el montículo de top-N en vez de ordenar todo)
+    void configurar_orden(size_t memoria_mb){ sort_mem = std::max<size_t>(memoria_mb, 1) << 20; }
+
+    // Memoria de los grupos de un GROUP BY antes de volcar particiones a disco (en el recorrido
+    // paralelo se reparte entre los hilos)
+    void configurar_agrupacion(size_t memoria_mb){ agg_mem = std::max<size_t>(memoria_mb, 1) << 20; }
+
+    // Esquema + tabla abierta de la base en uso (nullptr si no hay base o la tabla no existe).
+    // El puntero vale hasta el próximo USE/CLOSE/CREATE TABLE.
+    const CatalogEntry* catalog_entry(const std::string& tname){
+        return opened ? catalogo_tabla(tname) : nullptr;
+    }
+
 private:
     MiniDatabase db;
     bool opened=false;
     fs::path dbdir;
     std::string dbname;
     std::ostream& os;
+    // Catálogo: una entrada por tabla usada desde el USE (evita reabrir .tbl/.del y releer el
+    // esquema en cada sentencia)
+    std::unordered_map<std::string, CatalogEntry> catalogo;
+    // Planes por texto normalizado (prepare) y sentencias con nombre (PREPARE/EXECUTE)
+    std::unordered_map<std::string, std::shared_ptr<const Plan>> planes;
+    std::unordered_map<std::string, Statement> preparadas;
+    size_t sort_mem = (size_t)SQL_SORT_MEM_MB << 20;
+    size_t agg_mem = (size_t)SQL_AGG_MEM_MB << 20;
+    uint64_t nsort = 0;               // sufijo de los temporales de ORDER BY y GROUP BY
+
+    friend class Statement;
+
+    CatalogEntry* catalogo_tabla(const std::string& tname){
+        auto it = catalogo.find(tname);
+        if (it != catalogo.end()) return &it->second;
+        CatalogEntry e;
+        try { e.tbl = &db.tabla(tname); } catch (...) { return nullptr; }
+        schema_from_table(*e.tbl, e.sc);
+        for (int i=0;i<e.sc.ncols;++i) e.cix.emplace(e.sc.cols[i].name, i);
+        return &catalogo.emplace(tname, std::move(e)).first->second;
+    }
+
+    bool has_index(const std::string& tname, const std::string& col){
+        minidb::TipoIndice t;
+        try { return db.tipo_indice(tname, col, t); } catch (...) { return false; }
+    }
 
     // ---- CREATE DATABASE ----
     void cmd_CREATE_DATABASE(const std::string& name){
@@ -261,6 +1775,7 @@ private:
             if (!fs::exists(name) || !fs::is_directory(name)){
                 os << "No existe carpeta DB: " << name << "\n"; return;
             }
+            catalogo.clear(); planes.clear(); preparadas.clear();
             db.abrir_base_de_datos(name);
             opened=true; dbdir = fs::path(name); dbname=name;
             os << "Usando base de datos: " << name << "\n";
@@ -268,6 +1783,7 @@ private:
     }
     void cmd_CLOSE(){
         if (!opened){ os << "No hay base abierta.\n"; return; }
+        catalogo.clear(); planes.clear(); preparadas.clear();
         db.cerrar_base_de_datos();
         opened=false; dbdir.clear(); dbname.clear();
         os << "Base cerrada.\n";
@@ -297,6 +1813,7 @@ private:
 
         auto name = trim(full.substr(13, p2 - 13));
         if (name.empty()){ os << "Nombre de tabla vacío.\n"; return; }
+        if (is_keyword(name)){ os << "Nombre de tabla reservado: " << name << "\n"; return; }
 
         size_t p3 = find_matching_rparen(full, p2);
         if (p3 == std::string::npos){ os << "Sintaxis CREATE TABLE inválida (paréntesis desbalanceados).\n"; return; }
@@ -316,6 +1833,8 @@ private:
             }
             auto cname = trim(def_trim.substr(0, sp));
             auto ctype = trim(def_trim.substr(sp + 1));
+            // una columna con nombre reservado no se podría usar en SELECT/WHERE/SET
+            if (is_keyword(cname)){ os << "Nombre de columna reservado: " << cname << "\n"; return; }
 
             ColType ct; int w;
             if (!parse_type(ctype, ct, w)){
@@ -325,6 +1844,7 @@ private:
         }
 
         try{
+            catalogo.erase(name);
             db.crear_tabla(name, schema);
             os << "Tabla creada: " << name << " (con columna id INT por defecto)\n";
         } catch (const std::exception& e){
@@ -334,6 +1854,8 @@ private:
 
     // ---- INSERT INTO ----
     // ---- INSERT INTO ----
+    // INSERT INTO t (c1,c2,...) VALUES (v1,v2,...)[, (v1,v2,...) ...]
+    // Varias tuplas se insertan en un solo lote (esquema, tabla e índices se resuelven una vez).
     void cmd_INSERT_INTO(const std::string& full){
         if (!opened){ os << "Abra una base con USE.\n"; return; }
         auto up = to_upper(full);
@@ -349,60 +1871,64 @@ private:
         auto cols_s = full.substr(p1+1, p2-p1-1);
         auto cols = split_csv(cols_s);
 
-        // Lista de valores
-        size_t pval = to_upper(full).find("VALUES", p2);
+        // Listas de valores
+        size_t pval = up.find("VALUES", p2);
         if (pval==std::string::npos){ os << "Falta VALUES.\n"; return; }
-        size_t p3 = full.find('(', pval);
-        size_t p4 = full.find(')', p3);
-        if (p3==std::string::npos || p4==std::string::npos){ os << "Valores inválidos.\n"; return; }
-        auto vals = split_csv(full.substr(p3+1, p4-p3-1));
-
-        if (cols.size()!=vals.size()){ os << "Número de columnas/valores no coincide.\n"; return; }
-
-        // Cargar esquema de la tabla
-        fs::path tfile = dbdir / tname / (tname + ".tbl");
-        TableSchema sc;
-        if (!load_schema_from_tbl(tfile, sc)){ os << "Tabla no existe.\n"; return; }
+        std::vector<std::string> tuplas;
+        if (!split_tuples(full, pval+6, tuplas)){ os << "Valores inválidos.\n"; return; }
 
-        // Mapa nombre->índice de columna
-        std::unordered_map<std::string,int> cix;
-        for (int i=0;i<sc.ncols;++i) cix[sc.cols[i].name]=i;
-
-        // Preparar fila por defecto
-        std::vector<Value> row; row.resize(sc.ncols);
-        for (int i=0;i<sc.ncols;++i){
-            if (sc.cols[i].type==ColType::INT32) row[i]=Value::Int(0);
-            else if (sc.cols[i].type==ColType::FLOAT32) row[i]=Value::Flt(0.f);
-            else row[i]=Value::Chr("");
-        }
+        // Esquema de la tabla (catálogo)
+        const CatalogEntry* ce = catalogo_tabla(tname);
+        if (!ce){ os << "Tabla no existe.\n"; return; }
+        const TableSchema& sc = ce->sc;
+        const auto& cix = ce->cix;
 
-        // Asignar valores provistos por el usuario
+        // Posición física de cada columna de la lista
         bool id_provided = false;
         int id_idx = -1;
         auto it_id = cix.find("id");
         if (it_id != cix.end()) id_idx = it_id->second;
 
-        for (size_t k=0;k<cols.size();++k){
-            auto cname = trim(cols[k]);
+        std::vector<int> pos; pos.reserve(cols.size());
+        for (auto& c : cols){
+            auto cname = trim(c);
             auto it = cix.find(cname);
             if (it==cix.end()){ os << "Columna desconocida: " << cname << "\n"; return; }
-            int i = it->second;
-            row[i] = parse_value_literal(vals[k], sc.cols[i].type);
-            if (i == id_idx) id_provided = true;
+            pos.push_back(it->second);
+            if (it->second == id_idx) id_provided = true;
+        }
+
+        // Fila por defecto
+        std::vector<Value> defecto; defecto.resize(sc.ncols);
+        for (int i=0;i<sc.ncols;++i){
+            if (sc.cols[i].type==ColType::INT32) defecto[i]=Value::Int(0);
+            else if (sc.cols[i].type==ColType::FLOAT32) defecto[i]=Value::Flt(0.f);
+            else defecto[i]=Value::Chr("");
         }
 
         try{
-            // Autoincrement id si no se proveyó
-            GenericFixedTable tbl(tfile.string(), tname, std::vector<ColumnDef>{}, /*create_new*/false);
-            if (!id_provided && id_idx >= 0) {
-                long current = tbl.Count();
-                int next_id = (int)current + 1;
-                row[id_idx] = Value::Int(next_id);
+            // Autoincrement id si no se proveyó (mismo valor que insertando una a una)
+            long next_id = (!id_provided && id_idx >= 0) ? db.contar_filas(tname) + 1 : 0;
+
+            std::vector<std::vector<Value>> filas; filas.reserve(tuplas.size());
+            for (auto& t : tuplas){
+                auto vals = split_csv(t);
+                if (vals.size()!=pos.size()){ os << "Número de columnas/valores no coincide.\n"; return; }
+                std::vector<Value> row = defecto;
+                for (size_t k=0;k<pos.size();++k) row[pos[k]] = parse_value_literal(vals[k], sc.cols[pos[k]].type);
+                if (!id_provided && id_idx >= 0) row[id_idx] = Value::Int((int)next_id++);
+                filas.push_back(std::move(row));
             }
 
             // Insertar y ACTUALIZAR índices a través de MiniDatabase
-            long pid = db.insertar_fila(tname, row);
-            os << "Insertado pageID=" << pid << " en " << tname << "\n";
+            if (filas.size()==1){
+                long pid = db.insertar_fila(tname, filas[0]);
+                os << "Insertado pageID=" << pid << " en " << tname << "\n";
+            } else {
+                long pid = db.insertar_filas(tname, filas);
+                os << "Insertadas " << filas.size() << " filas en " << tname
+                   << " (pageID " << pid << ".." << pid + (long)filas.size() - 1 << ")\n";
+            }
         }catch(const std::exception& e){
             os << "Error insertando: " << e.what() << "\n";
         }
@@ -410,14 +1936,11 @@ private:
 
 
     void ensure_default_id_index(const std::string& tname){
-        fs::path tfile = dbdir / tname / (tname + ".tbl");
-        TableSchema sc; if (!load_schema_from_tbl(tfile, sc)) return;
-        int idx=-1;
-        for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name=="id") { idx=i; break; }
-        if (idx==-1) return;
+        const CatalogEntry* ce = catalogo_tabla(tname);
+        if (!ce || ce->col("id")==-1) return;
 
         // si no existe, créalo; si existe, asegúralo en memoria
-        if (!index_exists(dbdir, tname, "id", ColType::INT32)){
+        if (!has_index(tname, "id")){
             try { db.crear_indice(tname, "id"); os << "(Se creó índice default sobre id)\n"; }
             catch(...) {}
         }
@@ -428,567 +1951,593 @@ private:
 
     // ---- SELECT ----
     void cmd_SELECT(const std::string& full){
-        if (!opened){ os << "Abra una base con USE.\n"; return; }
-        auto up = to_upper(full);
-        size_t psel = up.find("SELECT "); if (psel!=0){ os << "Sintaxis SELECT inválida.\n"; return; }
-        size_t pfrom = up.find(" FROM ", 7); if (pfrom==std::string::npos){ os << "Falta FROM.\n"; return; }
-        auto proj = trim(full.substr(7, pfrom-7));
-
-        size_t pwhere = up.find(" WHERE ", pfrom+6);
-        std::string tname, wexpr;
-        if (pwhere==std::string::npos){
-            tname = trim(full.substr(pfrom+6));
-        } else {
-            tname = trim(full.substr(pfrom+6, pwhere-(pfrom+6)));
-            wexpr = trim(full.substr(pwhere+7));
+        TextSink sink(os); std::string err;
+        if (!select(full, sink, err)) os << err << "\n";
+    }
+
+    // Filas de un SELECT ya planificado hacia sink (sin materializar el resultado)
+    bool emitir(Statement& s, RowSink& sink, std::string& err){
+        bool more = s.step();
+        if (!s.error().empty()){ err = s.error(); return false; }
+        const auto& proj = s.projection();
+        sink.begin(s.plan->proj_names);
+        size_t n = 0;
+        for (; more; more = s.step()){
+            ++n;
+            if (!sink.row(s.row(), proj)) break;
         }
+        sink.end(n);
+        if (!s.error().empty()){ err = s.error(); return false; }
+        return true;
+    }
 
-        fs::path tfile = dbdir / tname / (tname + ".tbl");
-        TableSchema sc;
-        if (!load_schema_from_tbl(tfile, sc)){ os << "Tabla no existe.\n"; return; }
+    // ---- DELETE FROM ----
+    void cmd_DELETE_FROM(const std::string& full){
+        if (!opened){ os << "Abra una base con USE.\n"; return; }
 
-        std::vector<int> proj_idx;
-        if (proj=="*"){
-            for (int i=0;i<sc.ncols;++i) proj_idx.push_back(i);
-            ensure_default_id_index(tname);
-        } else {
-            auto cs = split_csv(proj);
-            for (auto& c : cs){
-                int idx=-1;
-                for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name==c){ idx=i; break; }
-                if (idx==-1){ os << "Columna no existe: " << c << "\n"; return; }
-                proj_idx.push_back(idx);
+        // Sintaxis soportada: DELETE FROM table_name [WHERE <expr>]
+        DeleteStmt st; std::string err;
+        if (!parse_delete(full, st, err)){ os << err << "\n"; return; }
+        if (st.nparams){ os << "Parámetros '?' solo con PREPARE/EXECUTE.\n"; return; }
+        Where w{};
+        if (st.where) to_where(*st.where, w);
+
+        // plan de un solo uso, como en select()
+        Plan p;
+        if (!plan_dml(p, Plan::Kind::DELETE, st.table, 0, st.where ? &w : nullptr, err)){ os << err << "\n"; return; }
+        long borradas = run_delete(p, p.bw);
+        os << "(filas borradas: " << borradas << ")\n";
+    }
+
+    // Borrado lógico de las filas del plan p que cumplen bw (su WHERE con los parámetros ya
+    // ligados); devuelve cuántas
+    long run_delete(const Plan& p, BoundWhere bw){
+        const std::string& tname = p.table;
+
+        // filas vivas que cumplen WHERE (por la ruta de acceso del plan)
+        std::vector<int> pids;
+        filas_que_cumplen(p, std::move(bw), pids);
+
+        // ejecutar borrado lógico + actualización de índices
+        long borradas = 0;
+        try {
+            for (int pid : pids) {
+                if (db.borrar_por_pageid(tname, pid)) ++borradas;
             }
+        } catch (...) {
+            db.confirmar_borrados(tname);   // lo ya borrado queda también en el .del
+            throw;
         }
+        db.confirmar_borrados(tname);
+        return borradas;
+    }
 
-        GenericFixedTable tbl(tfile.string(), tname, std::vector<ColumnDef>{}, /*create_new*/false);
-        long n = tbl.Count();
-        std::vector<int> pids;
+    // ---- UPDATE ----
+    void cmd_UPDATE(const std::string& full){
+        if (!opened){ os << "Abra una base con USE.\n"; return; }
 
-        if (wexpr.empty()){
-            pids.resize(n);
-            for (long i=0;i<n;++i) pids[i]=(int)i;
-        } else {
-            // asegurar índices cargados si los vamos a usar
-            try { db.ensure_indices_loaded(tname); } catch (...) {}
+        // UPDATE <tname> SET <asignaciones> [WHERE <expr>]
+        UpdateStmt st; std::string err;
+        if (!parse_update(full, st, err)){ os << err << "\n"; return; }
+        if (st.nparams){ os << "Parámetros '?' solo con PREPARE/EXECUTE.\n"; return; }
+        Where w{};
+        if (st.where) to_where(*st.where, w);
+
+        Plan p;
+        if (!plan_update(p, st, st.where ? &w : nullptr, err)){ os << err << "\n"; return; }
+        long nact = run_update(p, p.bw, p.sets, err);
+        if (!err.empty()){ os << err << "\n"; return; }
+        os << "(filas actualizadas: " << nact << ")\n";
+    }
 
-            Where w{};
-            if (!parse_where(wexpr, w)){ os << "WHERE inválido.\n"; return; }
-            auto use_pred = w.p1.value();
-            int cidx=-1; ColType ct{};
-            for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name==use_pred.col){ cidx=i; ct=sc.cols[i].type; break; }
+    // Aplica sets (los del plan p con los parámetros ya ligados) a las filas que cumplen bw;
+    // devuelve cuántas cambió
+    long run_update(const Plan& p, BoundWhere bw, const std::vector<std::pair<std::string, Value>>& sets, std::string& err){
+        const std::string& tname = p.table;
 
-            bool used_index=false;
-            if (cidx!=-1 && index_exists(dbdir, tname, use_pred.col, ct)){
-                try {
-                    if (ct==ColType::INT32){
-                        int key = std::stoi(use_pred.lit);
-                        if (use_pred.cmp==Cmp::EQ){
-                            int pid = db.buscar_unitaria(tname, use_pred.col, key);
-                            if (pid>=0) pids.push_back(pid);
-                        } else if (use_pred.cmp==Cmp::GE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, key, std::numeric_limits<int>::max());
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, std::numeric_limits<int>::min(), key);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::GT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, key+1, std::numeric_limits<int>::max());
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, std::numeric_limits<int>::min(), key-1);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else { // NE
-                            auto t1 = db.buscar_rango(tname, use_pred.col, std::numeric_limits<int>::min(), key-1);
-                            auto t2 = db.buscar_rango(tname, use_pred.col, key+1, std::numeric_limits<int>::max());
-                            pids.insert(pids.end(), t1.begin(), t1.end());
-                            pids.insert(pids.end(), t2.begin(), t2.end());
-                        }
-                        used_index=true;
-
-                    } else if (ct==ColType::FLOAT32){
-                        float key = std::stof(use_pred.lit);
-                        auto ninf = -std::numeric_limits<float>::infinity();
-                        auto pinf =  std::numeric_limits<float>::infinity();
-
-                        if (use_pred.cmp==Cmp::EQ){
-                            int pid = db.buscar_unitaria(tname, use_pred.col, key);
-                            if (pid>=0) pids.push_back(pid);
-                        } else if (use_pred.cmp==Cmp::GE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, key, pinf);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, ninf, key);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::GT){
-                            float a = std::nextafter(key, pinf);
-                            auto tmp = db.buscar_rango(tname, use_pred.col, a, pinf);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LT){
-                            float b = std::nextafter(key, ninf);
-                            auto tmp = db.buscar_rango(tname, use_pred.col, ninf, b);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else { // NE
-                            float a = std::nextafter(key, ninf);
-                            float b = std::nextafter(key, pinf);
-                            auto t1 = db.buscar_rango(tname, use_pred.col, ninf, a);
-                            auto t2 = db.buscar_rango(tname, use_pred.col, b, pinf);
-                            pids.insert(pids.end(), t1.begin(), t1.end());
-                            pids.insert(pids.end(), t2.begin(), t2.end());
-                        }
-                        used_index=true;
-
-                    } else { // CHAR
-                        std::string L = use_pred.lit;
-                        if (L.size()>=2 && L.front()=='\'' && L.back()=='\'') L = L.substr(1,L.size()-2);
-                        std::string lo = "";
-                        std::string hi = std::string(1, char(127));
-
-                        if (use_pred.cmp==Cmp::EQ){
-                            int pid = db.buscar_unitaria(tname, use_pred.col, L);
-                            if (pid>=0) pids.push_back(pid);
-                            used_index=true;
-                        } else if (use_pred.cmp==Cmp::GE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, L, hi);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                            used_index=true;
-                        } else if (use_pred.cmp==Cmp::LE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, lo, L);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                            used_index=true;
-                        } else if (use_pred.cmp==Cmp::GT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, L, hi);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                            used_index=true;
-                        } else if (use_pred.cmp==Cmp::LT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, lo, L);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                            used_index=true;
-                        } else { // NE
-                            auto t1 = db.buscar_rango(tname, use_pred.col, lo, L);
-                            auto t2 = db.buscar_rango(tname, use_pred.col, L, hi);
-                            pids.insert(pids.end(), t1.begin(), t1.end());
-                            pids.insert(pids.end(), t2.begin(), t2.end());
-                            used_index=true;
-                        }
-                    }
-                } catch(...) { used_index=false; }
+        // filas vivas que cumplen WHERE, como en DELETE
+        std::vector<int> pids;
+        filas_que_cumplen(p, std::move(bw), pids);
+
+        // Ejecutar UPDATE (escritura + refresco de índices)
+        long nact = 0;
+        try{
+            nact = db.update_filas_by_pageIDs(tname, pids, sets);
+        } catch(const std::exception& e){
+            err = std::string("Error en UPDATE: ") + e.what();
+        }
+        db.confirmar_borrados(tname);   // SET id = -1 también marca el .del
+        return nact;
+    }
+
+    // ---- Planes ----
+    // Ruta de acceso para un WHERE ligado. Un AND junta los predicados de rango sobre una misma
+    // columna indexada en un solo sondeo acotado de ambos lados, sondea su hijo indexado más
+    // selectivo y, salvo que sea una igualdad sobre columna única, también los demás hijos indexados
+    // de selectividad razonable (no !=, no la misma columna dos veces) para intersecar pageIDs antes
+    // de leer filas.
+    // Un OR une las rutas de todos sus hijos (si alguno no tiene, recorrido). Un NOT que quedó
+    // sobre FLOAT no usa índice.
+    AccessPath plan_access(const std::string& tname, const TableSchema& sc, const BoundWhere& bw){
+        AccessPath ap; double sel = 1.0; int col = -1;
+        if (!bw.nodes.empty()) ap.root = plan_access_node(tname, sc, bw, 0, ap, sel, col);
+        if (ap.root<0) ap.nodes.clear();
+        return ap;
+    }
+    // Nodo de la ruta para bw.nodes[i] (-1 si no hay); sel: selectividad estimada, col: columna
+    // del sondeo si es uno solo (-1 si combina varios)
+    int plan_access_node(const std::string& tname, const TableSchema& sc, const BoundWhere& bw, int i,
+                         AccessPath& ap, double& sel, int& col){
+        const BoundWhere::Node& n = bw.nodes[(size_t)i];
+        switch (n.kind){
+        case Expr::Kind::PRED: {
+            if (n.pred.idx==-1) return -1;
+            if (n.pred.t==ColType::CHAR && n.pred.cmp==Cmp::NE) return -1;
+            const std::string& cname = sc.cols[n.pred.idx].name;
+            minidb::IndiceRef ref;
+            try { ref = db.indice_ref(tname, cname); } catch (...) { return -1; }
+            if (!ref) return -1;
+            sel = est_selectividad(n.pred, cname=="id");
+            col = n.pred.idx;
+            AccessPath::Node pn; pn.preds.push_back(i); pn.idx = ref;
+            ap.nodes.push_back(pn);
+            return (int)ap.nodes.size()-1;
+        }
+        case Expr::Kind::AND: {
+            struct Cand { int node; double sel; int col; };
+            std::vector<Cand> cands;
+            for (int c : n.args){
+                Cand k{-1, 1.0, -1};
+                k.node = plan_access_node(tname, sc, bw, c, ap, k.sel, k.col);
+                if (k.node>=0) cands.push_back(k);
             }
-            if (!used_index){
-                for (long i=0;i<n;++i) pids.push_back((int)i);
+            if (cands.empty()) return -1;
+            // rangos sobre la misma columna: un solo sondeo con ambas cotas (!= queda aparte)
+            auto rango = [&](const Cand& k){
+                if (k.col<0) return false;
+                const AccessPath::Node& pn = ap.nodes[(size_t)k.node];
+                if (pn.op!=AccessPath::Node::Op::PROBE) return false;
+                for (int q : pn.preds) if (bw.nodes[(size_t)q].pred.cmp==Cmp::NE) return false;
+                return true;
+            };
+            for (size_t a=0;a<cands.size();++a){
+                if (!rango(cands[a])) continue;
+                for (size_t b=a+1;b<cands.size();){
+                    if (cands[b].col!=cands[a].col || !rango(cands[b])){ ++b; continue; }
+                    auto& dst = ap.nodes[(size_t)cands[a].node].preds;
+                    const auto& src = ap.nodes[(size_t)cands[b].node].preds;
+                    dst.insert(dst.end(), src.begin(), src.end());
+                    cands[a].sel *= cands[b].sel;
+                    cands.erase(cands.begin() + (long)b);
+                }
             }
-
-            // Filtro final por predicados (AND/OR) sobre las filas concretas
-            std::vector<int> filtered; filtered.reserve(pids.size());
-            for (int pid : pids){
-                std::vector<Value> row;
-                if (!tbl.ReadRowByPageID(pid, row)) continue;
-                // saltar tombstones
-                int id_idx = -1; for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name=="id"){ id_idx=i; break; }
-                if (id_idx>=0 && row[id_idx].i==-1) continue;
-
-                bool r1 = w.p1 ? eval_pred_row(*w.p1, sc, row) : true;
-                bool r2 = w.p2 ? eval_pred_row(*w.p2, sc, row) : true;
-                bool ok = w.op=="AND" ? (r1 && r2) : (w.op=="OR" ? (r1 || r2) : r1);
-                if (ok) filtered.push_back(pid);
+            std::stable_sort(cands.begin(), cands.end(), [](const Cand& a, const Cand& b){ return a.sel < b.sel; });
+            sel = cands[0].sel; col = cands[0].col;
+            if (cands.size()==1 || sel <= SEL_UNICA) return cands[0].node;
+            AccessPath::Node an; an.op = AccessPath::Node::Op::AND;
+            std::vector<int> cols;
+            for (auto& k : cands){
+                if (!an.args.empty() && k.sel > SEL_INTERSECAR) break;
+                if (k.col>=0 && std::find(cols.begin(), cols.end(), k.col)!=cols.end()) continue;
+                if (k.col>=0) cols.push_back(k.col);
+                an.args.push_back(k.node);
+                if (an.args.size()>1) sel *= k.sel;
             }
-            pids.swap(filtered);
+            if (an.args.size()==1) return an.args[0];
+            col = -1;
+            ap.nodes.push_back(std::move(an));
+            return (int)ap.nodes.size()-1;
         }
-
-        // Encabezado
-        for (size_t j=0;j<proj_idx.size();++j){
-            os << sc.cols[proj_idx[j]].name << (j+1<proj_idx.size() ? " | " : "\n");
+        case Expr::Kind::OR: {
+            AccessPath::Node on; on.op = AccessPath::Node::Op::OR;
+            double total = 0.0;
+            for (int c : n.args){
+                double cs = 1.0; int cc = -1;
+                int k = plan_access_node(tname, sc, bw, c, ap, cs, cc);
+                if (k<0) return -1;
+                on.args.push_back(k);
+                total += cs;
+            }
+            sel = std::min(1.0, total); col = -1;
+            ap.nodes.push_back(std::move(on));
+            return (int)ap.nodes.size()-1;
+        }
+        case Expr::Kind::NOT: return -1;
         }
+        return -1;
+    }
 
-        // Cuerpo + conteo real
-        size_t printed = 0;
-        for (int pid : pids){
-            std::vector<Value> row; if (!tbl.ReadRowByPageID(pid, row)) continue;
-            // saltar tombstones también aquí por seguridad
-            int id_idx=-1; for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name=="id"){ id_idx=i; break; }
-            if (id_idx>=0 && row[id_idx].i==-1) continue;
+    // pageIDs de las filas vivas de la tabla del plan p que cumplen bw (vacío: todas), por la ruta
+    // de acceso del plan, ordenados y sin repetidos
+    void filas_que_cumplen(const Plan& p, BoundWhere bw, std::vector<int>& out){
+        auto pipe = armar_pipeline(*p.tbl, p.access, std::move(bw), p.id_idx);
+        out.clear();
+        RowBatch b;
+        while (pipe->next(b)) for (size_t i=0;i<b.size();++i) out.push_back((int)b.pid(i));
+    }
 
-            for (size_t j=0;j<proj_idx.size();++j){
-                int i = proj_idx[j];
-                if (sc.cols[i].type==ColType::INT32) os << row[i].i;
-                else if (sc.cols[i].type==ColType::FLOAT32) os << row[i].f;
-                else os << row[i].s;
-                os << (j+1<proj_idx.size() ? " | " : "\n");
+    // Plan de SELECT: proyección y WHERE resueltos contra el esquema, más la ruta de acceso
+    bool plan_select(Plan& p, const SelectStmt& st, const Where& w, std::string& err){
+        const CatalogEntry* ce = catalogo_tabla(st.table);
+        if (!ce){ err = "Tabla no existe."; return false; }
+        const TableSchema& sc = ce->sc;
+        p.kind = Plan::Kind::SELECT;
+        p.table = st.table; p.nparams = st.nparams;
+        p.tbl = ce->tbl;
+        p.has_where = st.where != nullptr;
+        p.agrega = !st.group.empty() ||
+                   std::any_of(st.items.begin(), st.items.end(), [](const SelectItem& it){ return it.fn!=AggFn::NONE; });
+        if (st.star){
+            if (p.agrega){ err = "SELECT * no admite GROUP BY."; return false; }
+            for (int i=0;i<sc.ncols;++i){ p.proj_idx.push_back(i); p.proj_names.push_back(sc.cols[i].name); }
+        } else if (p.agrega){
+            if (!plan_agregacion(p, st, *ce, err)) return false;
+        } else {
+            for (auto& it : st.items){
+                int idx = ce->col(it.col);
+                if (idx==-1){ err = "Columna no existe: " + it.col; return false; }
+                p.proj_idx.push_back(idx); p.proj_names.push_back(it.col);
             }
-            ++printed;
         }
-        os << "(filas: " << printed << ")\n";
-
+        p.id_idx = ce->col("id");
+        p.bw = bind_where(w, sc);
+        p.access = plan_access(p.table, sc, p.bw);
+        for (auto& o : st.order){
+            if (p.agrega){
+                // se ordenan las filas de los grupos: la clave es un elemento del SELECT
+                auto it = std::find(p.proj_names.begin(), p.proj_names.end(), o.col);
+                if (it==p.proj_names.end()){ err = "ORDER BY con agregados debe usar un elemento del SELECT: " + o.col; return false; }
+                const int j = (int)(it - p.proj_names.begin());
+                const gft::ColMetaDisk& m = p.agg.fmt.cols[(size_t)j];
+                p.orden.push_back(ClaveOrden{j, (ColType)m.type, m.offset, m.width, o.desc});
+                continue;
+            }
+            int idx = ce->col(o.col);
+            if (idx==-1){ err = "Columna no existe en ORDER BY: " + o.col; return false; }
+            const gft::ColMetaDisk& m = ce->tbl->col_meta(idx);
+            p.orden.push_back(ClaveOrden{idx, sc.cols[idx].type, m.offset, m.width, o.desc});
+        }
+        p.limite = st.limit;
+        p.offset = st.offset;
+        if (!p.agrega) plan_orden(p, sc);
+        p.gen = db.generacion();   // después de indice_ref (puede descubrir índices)
+        return true;
     }
 
-    // ---- DELETE FROM ----
-    // ---- DELETE FROM ----
-    void cmd_DELETE_FROM(const std::string& full){
-        if (!opened){ os << "Abra una base con USE.\n"; return; }
+    // Plan de UPDATE/DELETE sobre table: WHERE (nullptr: sin WHERE) ligado al esquema y ruta de
+    // acceso, como en SELECT
+    bool plan_dml(Plan& p, Plan::Kind kind, const std::string& table, int nparams, const Where* w, std::string& err){
+        const CatalogEntry* ce = catalogo_tabla(table);
+        if (!ce){ err = "Tabla no existe."; return false; }
+        p.kind = kind;
+        p.table = table; p.nparams = nparams;
+        p.tbl = ce->tbl;
+        p.id_idx = ce->col("id");
+        p.has_where = w != nullptr;
+        if (w){ p.bw = bind_where(*w, ce->sc); p.access = plan_access(table, ce->sc, p.bw); }
+        p.gen = db.generacion();   // después de indice_ref (puede descubrir índices)
+        return true;
+    }
 
-        // Sintaxis soportada: DELETE FROM table_name [WHERE <expr>]
-        auto up = to_upper(full);
-        size_t pdel = up.find("DELETE FROM");
-        if (pdel != 0){ os << "Sintaxis DELETE inválida.\n"; return; }
-
-        // obtener nombre de tabla y WHERE
-        size_t pwhere_kw = up.find(" WHERE ", 12);
-        std::string tname, wexpr;
-        if (pwhere_kw == std::string::npos) {
-            tname = trim(full.substr(12));
-            wexpr = "";
-        } else {
-            tname = trim(full.substr(12, pwhere_kw-12));
-            wexpr = trim(full.substr(pwhere_kw+7));
+    // Plan de UPDATE: además de plan_dml, la columna de cada SET y su literal convertido una vez
+    bool plan_update(Plan& p, const UpdateStmt& st, const Where* w, std::string& err){
+        if (!plan_dml(p, Plan::Kind::UPDATE, st.table, st.nparams, w, err)) return false;
+        const CatalogEntry& ce = *catalogo_tabla(st.table);
+        for (auto& si : st.sets){
+            const int idx = ce.col(si.col);
+            if (idx==-1){ err = "Columna desconocida en SET: " + si.col; return false; }
+            Value v; v.t = ce.sc.cols[idx].type;
+            if (si.param<0) v = parse_value_literal(si.lit, v.t);
+            p.sets.emplace_back(si.col, std::move(v));
+            p.set_params.push_back(si.param);
         }
+        return true;
+    }
 
-        // abrir esquema
-        fs::path tfile = dbdir / tname / (tname + ".tbl");
-        TableSchema sc;
-        if (!load_schema_from_tbl(tfile, sc)){ os << "Tabla no existe.\n"; return; }
+    // Agregación de un SELECT con agregados o GROUP BY: columnas de la clave, estado de cada
+    // agregado y formato de la fila de salida (una columna por elemento, llamada como en el
+    // SELECT: "b", "SUM(a)"). Una columna suelta debe estar en GROUP BY; SUM/AVG piden INT o FLOAT.
+    bool plan_agregacion(Plan& p, const SelectStmt& st, const CatalogEntry& ce, std::string& err){
+        Agregacion& a = p.agg;
+        for (auto& g : st.group){
+            int idx = ce.col(g);
+            if (idx==-1){ err = "Columna no existe en GROUP BY: " + g; return false; }
+            const gft::ColMetaDisk& m = ce.tbl->col_meta(idx);
+            a.grupo.push_back(CampoGrupo{idx, (ColType)m.type, m.offset, m.width, a.key_bytes});
+            a.key_bytes += (size_t)m.width;
+        }
+        p.conteo_directo = !p.has_where && a.grupo.empty();
+        for (auto& it : st.items){
+            const std::string name = it.name();
+            Agregacion::Salida s;
+            int idx = -1;
+            if (!it.col.empty() && (idx = ce.col(it.col))==-1){ err = "Columna no existe: " + it.col; return false; }
+            if (it.fn==AggFn::NONE){
+                for (size_t k=0;k<a.grupo.size();++k) if (a.grupo[k].idx==idx) s.grupo = (int)k;
+                if (s.grupo < 0){ err = "La columna " + it.col + " debe estar en GROUP BY o dentro de un agregado."; return false; }
+                const CampoGrupo& g = a.grupo[(size_t)s.grupo];
+                a.fmt.agregar(name, g.t, g.width);
+                p.conteo_directo = false;
+            } else {
+                Agregado ag; ag.fn = it.fn; ag.idx = idx;
+                if (idx >= 0){
+                    const gft::ColMetaDisk& m = ce.tbl->col_meta(idx);
+                    ag.t = (ColType)m.type; ag.off = m.offset; ag.width = m.width;
+                }
+                ag.est = a.state_bytes;
+                switch (it.fn){
+                case AggFn::COUNT:
+                    a.fmt.agregar(name, ColType::INT32, 4);
+                    break;
+                case AggFn::SUM: case AggFn::AVG:
+                    if (ag.t==ColType::CHAR){ err = std::string(agg_fn_name(it.fn)) + " requiere una columna INT o FLOAT: " + it.col; return false; }
+                    a.state_bytes += 8;
+                    a.fmt.agregar(name, it.fn==AggFn::SUM ? ag.t : ColType::FLOAT32, 4);
+                    p.conteo_directo = false;
+                    break;
+                default:   // MIN / MAX
+                    a.state_bytes += (size_t)ag.width;
+                    a.fmt.agregar(name, ag.t, ag.width);
+                    p.conteo_directo = false;
+                }
+                s.agg = (int)a.aggs.size();
+                a.aggs.push_back(ag);
+            }
+            a.salida.push_back(s);
+            p.proj_idx.push_back((int)p.proj_names.size());
+            p.proj_names.push_back(name);
+        }
+        return true;
+    }
 
-        GenericFixedTable tbl(tfile.string(), tname, std::vector<ColumnDef>{}, /*create_new*/false);
-        long n = tbl.Count();
+    // ORDER BY por índice, sin ordenar: una sola clave INT o CHAR de hasta 31 bytes (la clave del
+    // índice es exacta; FLOAT no tiene orden total con NaN) con índice, y un WHERE resuelto por un
+    // sondeo de esa misma columna (se recorre ese rango en orden de clave) o sin ruta de acceso pero
+    // con LIMIT (recorrer el índice completo lee filas sueltas: conviene si se piden pocas). Si no,
+    // se ordena el resultado del pipeline.
+    void plan_orden(Plan& p, const TableSchema& sc){
+        if (p.orden.size()!=1) return;
+        const ClaveOrden& k = p.orden[0];
+        if (k.t==ColType::FLOAT32 || (k.t==ColType::CHAR && k.width >= diskbtree::KeyChar32::KEY_BYTES)) return;
+        const AccessPath& ap = p.access;
+        if (ap.root>=0){
+            const AccessPath::Node& n = ap.nodes[(size_t)ap.root];
+            if (n.op!=AccessPath::Node::Op::PROBE || p.bw.nodes[(size_t)n.preds[0]].pred.idx!=k.idx) return;
+            p.preds_orden = n.preds;
+        } else if (p.limite < 0) return;
+        minidb::IndiceRef ref;
+        try { ref = db.indice_ref(p.table, sc.cols[k.idx].name); } catch (...) { return; }
+        if (!ref) return;
+        p.idx_orden = ref;
+        p.orden_indice = true;
+    }
 
-        // asegurar índices cargados si los vamos a usar
-        try { db.ensure_indices_loaded(tname); } catch (...) {}
+    // Pipeline de un SELECT con los parámetros ya ligados en bw: ruta de acceso + filtro y, con
+    // ORDER BY, el recorrido del índice en orden de clave (plan_orden) o TopN/Sort encima. Con
+    // agregados, la agregación (armar_agregacion) y el ORDER BY sobre sus filas.
+    std::unique_ptr<Operator> armar_select(const Plan& p, BoundWhere bw){
+        GenericFixedTable& tbl = *p.tbl;
+        const bool con_limite = p.limite >= 0;
+        if (p.agrega){
+            auto src = armar_agregacion(p, std::move(bw));
+            if (p.orden.empty()) return src;
+            return ordenar(p, std::move(src), nullptr, &p.agg.fmt);
+        }
+        if (p.orden.empty()) return armar_pipeline(tbl, p.access, std::move(bw), p.id_idx, con_limite);
+        if (p.orden_indice){
+            auto c = cursor_indice(p.idx_orden, p.orden[0].t, bw, p.preds_orden,
+                                   con_limite ? SQL_BATCH : SIZE_MAX, p.orden[0].desc);
+            if (c) return std::make_unique<FilterOp>(std::make_unique<IndexOrderOp>(tbl, std::move(c)), std::move(bw), p.id_idx);
+        }
+        return ordenar(p, armar_pipeline(tbl, p.access, std::move(bw), p.id_idx), &tbl, nullptr);
+    }
 
-        // recolectar candidatos a borrar (pageIDs)
-        std::vector<int> pids; pids.reserve((size_t)n);
+    // ORDER BY sobre src (filas de tbl o del formato fmt): top-N si entra en memoria, si no Sort
+    std::unique_ptr<Operator> ordenar(const Plan& p, std::unique_ptr<Operator> src, GenericFixedTable* tbl, const FormatoFila* fmt){
+        const size_t rec = (fmt ? fmt->rs : (size_t)tbl->row_size()) + 4;
+        // top-N: hacen falta las primeras OFFSET + LIMIT filas del orden
+        const long tope = p.limite >= 0 ? p.limite + p.offset : -1;
+        if (tope >= 0 && (size_t)tope <= sort_mem / rec)
+            return std::make_unique<TopNOp>(std::move(src), tbl, fmt, p.orden, (size_t)tope);
+        const fs::path tmp = dbdir / p.table / (".orden" + std::to_string(++nsort));
+        return std::make_unique<SortOp>(std::move(src), tbl, fmt, p.orden, tmp.string(), sort_mem);
+    }
 
-        auto is_tombstoned = [&](long pid)->bool{
-            std::vector<Value> row;
-            if (!tbl.ReadRowByPageID(pid, row)) return true; // si falla lectura, ignora
-            int id_idx = -1; for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name=="id"){ id_idx=i; break; }
-            return (id_idx>=0 && row[id_idx].i==-1);
-        };
+    // Agregación de un SELECT: solo COUNT sin WHERE ni GROUP BY sale de las filas vivas de la
+    // tabla; sin ruta de acceso y con tabla grande, agregación paralela por morsels; si no,
+    // agregación sobre el pipeline (sondeo de índice + filtro o recorrido)
+    std::unique_ptr<Operator> armar_agregacion(const Plan& p, BoundWhere bw){
+        GenericFixedTable& tbl = *p.tbl;
+        if (p.conteo_directo) return std::make_unique<ConteoOp>(p.agg.fmt, db.filas_vivas(p.table));
+        const std::string tmp = (dbdir / p.table / (".grupos" + std::to_string(++nsort))).string();
+        if (p.access.root < 0 && scan_threads() > 1 && tbl.Count() >= SQL_PAR_MIN_ROWS)
+            return std::make_unique<AggOp>(tbl, std::move(bw), p.id_idx, scan_threads(), p.agg, tmp, agg_mem);
+        return std::make_unique<AggOp>(armar_pipeline(tbl, p.access, std::move(bw), p.id_idx), tbl, p.agg, tmp, agg_mem);
+    }
 
-        if (wexpr.empty()){
-            // DELETE sin WHERE => borrar TODAS las filas "vivas"
-            for (long i=0;i<n;++i) {
-                if (!is_tombstoned(i)) pids.push_back((int)i);
-            }
-        } else {
-            // DELETE con WHERE => recolectar candidatos, usar índice si es posible (igual que en SELECT)
+    // Planifica un texto ya normalizado y lo deja en la caché
+    std::shared_ptr<const Plan> planificar(const std::string& sql, std::string& err){
+        auto p = std::make_shared<Plan>();
+        p->sql = sql;
+        try {
             Where w{};
-            if (!parse_where(wexpr, w)){ os << "WHERE inválido.\n"; return; }
-
-            auto use_pred = w.p1.value();
-            int cidx=-1; ColType ct{};
-            for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name==use_pred.col){ cidx=i; ct=sc.cols[i].type; break; }
-
-            bool used_index=false;
-            if (cidx!=-1 && index_exists(dbdir, tname, use_pred.col, ct)){
-                try {
-                    if (ct==ColType::INT32){
-                        int key = std::stoi(use_pred.lit);
-                        if (use_pred.cmp==Cmp::EQ){
-                            int pid = db.buscar_unitaria(tname, use_pred.col, key);
-                            if (pid>=0) pids.push_back(pid);
-                        } else if (use_pred.cmp==Cmp::GE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, key, std::numeric_limits<int>::max());
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, std::numeric_limits<int>::min(), key);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::GT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, key+1, std::numeric_limits<int>::max());
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, std::numeric_limits<int>::min(), key-1);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else { // NE
-                            auto t1 = db.buscar_rango(tname, use_pred.col, std::numeric_limits<int>::min(), key-1);
-                            auto t2 = db.buscar_rango(tname, use_pred.col, key+1, std::numeric_limits<int>::max());
-                            pids.insert(pids.end(), t1.begin(), t1.end());
-                            pids.insert(pids.end(), t2.begin(), t2.end());
-                        }
-                        used_index=true;
-
-                    } else if (ct==ColType::FLOAT32){
-                        float key = std::stof(use_pred.lit);
-                        auto ninf = -std::numeric_limits<float>::infinity();
-                        auto pinf =  std::numeric_limits<float>::infinity();
-
-                        if (use_pred.cmp==Cmp::EQ){
-                            int pid = db.buscar_unitaria(tname, use_pred.col, key);
-                            if (pid>=0) pids.push_back(pid);
-                        } else if (use_pred.cmp==Cmp::GE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, key, pinf);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, ninf, key);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::GT){
-                            float a = std::nextafter(key, pinf);
-                            auto tmp = db.buscar_rango(tname, use_pred.col, a, pinf);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LT){
-                            float b = std::nextafter(key, ninf);
-                            auto tmp = db.buscar_rango(tname, use_pred.col, ninf, b);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else { // NE
-                            float a = std::nextafter(key, ninf);
-                            float b = std::nextafter(key, pinf);
-                            auto t1 = db.buscar_rango(tname, use_pred.col, ninf, a);
-                            auto t2 = db.buscar_rango(tname, use_pred.col, b, pinf);
-                            pids.insert(pids.end(), t1.begin(), t1.end());
-                            pids.insert(pids.end(), t2.begin(), t2.end());
-                        }
-                        used_index=true;
-
-                    } else { // CHAR
-                        std::string L = use_pred.lit;
-                        if (L.size()>=2 && L.front()=='\'' && L.back()=='\'') L = L.substr(1,L.size()-2);
-                        std::string lo = "";
-                        std::string hi = std::string(1, char(127));
-
-                        if (use_pred.cmp==Cmp::EQ){
-                            int pid = db.buscar_unitaria(tname, use_pred.col, L);
-                            if (pid>=0) pids.push_back(pid);
-                            used_index=true;
-                        } else if (use_pred.cmp==Cmp::GE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, L, hi);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                            used_index=true;
-                        } else if (use_pred.cmp==Cmp::LE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, lo, L);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                            used_index=true;
-                        } else if (use_pred.cmp==Cmp::GT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, L, hi);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                            used_index=true;
-                        } else if (use_pred.cmp==Cmp::LT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, lo, L);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                            used_index=true;
-                        } else { // NE
-                            auto t1 = db.buscar_rango(tname, use_pred.col, lo, L);
-                            auto t2 = db.buscar_rango(tname, use_pred.col, L, hi);
-                            pids.insert(pids.end(), t1.begin(), t1.end());
-                            pids.insert(pids.end(), t2.begin(), t2.end());
-                            used_index=true;
-                        }
-                    }
-                } catch(...) { used_index=false; }
-            }
-
-            if (!used_index){
-                for (long i=0;i<n;++i) pids.push_back((int)i);
+            if (starts_kw(sql, "SELECT")){
+                SelectStmt st;
+                if (!parse_select(sql, st, err)) return nullptr;
+                if (st.where) to_where(*st.where, w);
+                if (!catalogo_tabla(st.table)){ err = "Tabla no existe."; return nullptr; }
+                if (st.star) ensure_default_id_index(st.table);
+                if (!plan_select(*p, st, w, err)) return nullptr;
+            } else if (starts_kw(sql, "DELETE FROM")){
+                DeleteStmt st;
+                if (!parse_delete(sql, st, err)) return nullptr;
+                if (st.where) to_where(*st.where, w);
+                if (!plan_dml(*p, Plan::Kind::DELETE, st.table, st.nparams, st.where ? &w : nullptr, err)) return nullptr;
+            } else if (starts_kw(sql, "UPDATE ")){
+                UpdateStmt st;
+                if (!parse_update(sql, st, err)) return nullptr;
+                if (st.where) to_where(*st.where, w);
+                if (!plan_update(*p, st, st.where ? &w : nullptr, err)) return nullptr;
+            } else {
+                err = "Solo se pueden preparar SELECT, UPDATE y DELETE.";
+                return nullptr;
             }
+        } catch (const std::exception& e){
+            err = std::string("Error: ") + e.what();
+            return nullptr;
+        }
+        if (planes.size() >= SQL_PLAN_CACHE) planes.clear();
+        planes[sql] = p;
+        return p;
+    }
 
-            // Filtrar exacto (AND/OR) y descartar tombstones
-            std::vector<int> filtered; filtered.reserve(pids.size());
-            for (int pid : pids){
-                std::vector<Value> row;
-                if (!tbl.ReadRowByPageID(pid, row)) continue;
-                int id_idx = -1; for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name=="id"){ id_idx=i; break; }
-                if (id_idx>=0 && row[id_idx].i==-1) continue;
-
-                bool r1 = w.p1 ? eval_pred_row(*w.p1, sc, row) : true;
-                bool r2 = w.p2 ? eval_pred_row(*w.p2, sc, row) : true;
-                bool ok = w.op=="AND" ? (r1 && r2) : (w.op=="OR" ? (r1 || r2) : r1);
-                if (ok) filtered.push_back(pid);
-            }
-            pids.swap(filtered);
+    // Primer step() de una sentencia: revalida el plan, liga los parámetros y abre el cursor
+    // (SELECT: sondeo del índice o inicio del recorrido) o ejecuta la modificación (UPDATE/DELETE)
+    bool abrir_cursor(Statement& s){
+        if (!opened){ s.err = "Abra una base con USE."; return false; }
+        if (s.plan->gen != db.generacion()){
+            auto p = planificar(s.plan->sql, s.err);
+            if (!p) return false;
+            s.plan = std::move(p);
         }
+        const Plan& p = *s.plan;
+        for (size_t i=0;i<s.params.size();++i)
+            if (!s.params[i]){ s.err = "Falta el valor del parámetro " + std::to_string(i+1) + "."; return false; }
+        auto invalido = [&](int q){
+            s.err = "Parámetro " + std::to_string(q+1) + " inválido: " + value_literal(*s.params[(size_t)q]);
+            return false;
+        };
 
-        // deduplicar pids por si vienen de NE/rangos superpuestos
-        std::sort(pids.begin(), pids.end());
-        pids.erase(std::unique(pids.begin(), pids.end()), pids.end());
+        BoundWhere bw = p.bw;
+        for (auto& n : bw.nodes){
+            if (n.kind!=Expr::Kind::PRED || n.pred.param<0) continue;
+            try { bind_param(n.pred, *s.params[(size_t)n.pred.param]); }
+            catch (...) { return invalido(n.pred.param); }
+        }
 
-        // ejecutar borrado lógico + actualización de índices
-        int borradas = 0;
-        for (int pid : pids) {
-            if (db.borrar_por_pageid(tname, pid)) ++borradas;
+        if (p.kind==Plan::Kind::SELECT){
+            try { s.pipe = armar_select(p, std::move(bw)); }
+            catch (const std::exception& e){ s.err = std::string("Error: ") + e.what(); return false; }
+            return true;
         }
 
-        os << "(filas borradas: " << borradas << ")\n";
+        // UPDATE/DELETE: misma ruta de acceso del plan, con los '?' ya ligados
+        try {
+            if (p.kind==Plan::Kind::DELETE){
+                s.nchanges = run_delete(p, std::move(bw));
+            } else {
+                auto sets = p.sets;
+                for (size_t k=0;k<sets.size();++k){
+                    const int q = p.set_params[k];
+                    if (q<0) continue;
+                    try { sets[k].second = value_as(*s.params[(size_t)q], sets[k].second.t); }
+                    catch (...) { return invalido(q); }
+                }
+                s.nchanges = run_update(p, std::move(bw), sets, s.err);
+            }
+        } catch (const std::exception& e){
+            s.err = std::string("Error: ") + e.what();
+        }
+        return s.err.empty();
     }
 
-    // ---- UPDATE ----
-    void cmd_UPDATE(const std::string& full){
+    // ---- PREPARE / EXECUTE / DEALLOCATE ----
+    // PREPARE <nombre> AS <SELECT|UPDATE|DELETE con '?'>
+    void cmd_PREPARE(const std::string& full){
         if (!opened){ os << "Abra una base con USE.\n"; return; }
-
-        std::string up = to_upper(full);
-        // UPDATE <tname> SET <asignaciones> [WHERE <expr>]
-        size_t p_update = up.find("UPDATE ");
-        if (p_update != 0){ os << "Sintaxis UPDATE inválida.\n"; return; }
-
-        size_t p_set_kw = up.find(" SET ", 7);
-        if (p_set_kw == std::string::npos){ os << "Falta SET en UPDATE.\n"; return; }
-
-        std::string tname = trim(full.substr(7, p_set_kw-7));
-
-        // localizar WHERE (si existe) **en la original** pero buscando con up
-        size_t p_where_kw_up = up.find(" WHERE ", p_set_kw+5);
-        std::string set_part, wexpr;
-        if (p_where_kw_up == std::string::npos) {
-            set_part = trim(full.substr(p_set_kw+5));
-            wexpr.clear();
-        } else {
-            set_part = trim(full.substr(p_set_kw+5, p_where_kw_up-(p_set_kw+5)));
-            wexpr    = trim(full.substr(p_where_kw_up+7));
-        }
-        if (tname.empty() || set_part.empty()){ os << "Sintaxis UPDATE inválida.\n"; return; }
-
-        // Parseo de asignaciones: "col = valor, col2 = valor2, ..."
-        auto assigns = split_csv(set_part);
-        if (assigns.empty()){ os << "SET vacío.\n"; return; }
-
-        // Abrir esquema
-        fs::path tfile = dbdir / tname / (tname + ".tbl");
-        TableSchema sc;
-        if (!load_schema_from_tbl(tfile, sc)){ os << "Tabla no existe.\n"; return; }
-
-        // Mapa nombre->idx para tipos
-        std::unordered_map<std::string,int> cix;
-        for (int i=0;i<sc.ncols;++i) cix[sc.cols[i].name]=i;
-
-        // construir setlist tipado
-        std::vector<std::pair<std::string, Value>> setlist; setlist.reserve(assigns.size());
-        for (auto& a : assigns){
-            auto eqp = a.find('=');
-            if (eqp==std::string::npos){ os << "Asignación inválida en SET: " << a << "\n"; return; }
-            std::string cname = trim(a.substr(0, eqp));
-            std::string lit   = trim(a.substr(eqp+1));
-            auto it = cix.find(cname);
-            if (it==cix.end()){ os << "Columna desconocida en SET: " << cname << "\n"; return; }
-            ColType ct = sc.cols[it->second].type;
-            setlist.emplace_back(cname, parse_value_literal(lit, ct));
+        std::string rest = trim(full.substr(8));
+        size_t sp = 0;
+        while (sp<rest.size() && !std::isspace((unsigned char)rest[sp])) ++sp;
+        std::string name = rest.substr(0, sp);
+        std::string body = trim(rest.substr(sp));
+        if (name.empty() || !starts_kw(body, "AS") || body.size()<3 || !std::isspace((unsigned char)body[2])){
+            os << "Sintaxis: PREPARE nombre AS <SELECT|UPDATE|DELETE ...>\n"; return;
         }
+        Statement st = prepare(trim(body.substr(3)));
+        if (!st.valid()){ os << st.error() << "\n"; return; }
+        int np = st.param_count();
+        preparadas[name] = std::move(st);
+        os << "Sentencia preparada: " << name << " (" << np << " parámetros)\n";
+    }
 
-        // recolectar PIDs como en SELECT
-        GenericFixedTable tbl(tfile.string(), tname, std::vector<ColumnDef>{}, /*create_new*/false);
-        long n = tbl.Count();
-        std::vector<int> pids;
+    // EXECUTE <nombre> [(v1, v2, ...)]
+    void cmd_EXECUTE(const std::string& full){
+        if (!opened){ os << "Abra una base con USE.\n"; return; }
+        std::string rest = trim(full.substr(8));
+        size_t sp = 0;
+        while (sp<rest.size() && !std::isspace((unsigned char)rest[sp]) && rest[sp]!='(') ++sp;
+        std::string name = rest.substr(0, sp);
+        std::string args = trim(rest.substr(sp));
+        std::vector<std::string> vals;
+        if (!args.empty()){
+            if (args.front()!='(' || args.back()!=')'){ os << "Sintaxis: EXECUTE nombre [(v1, v2, ...)]\n"; return; }
+            args = trim(args.substr(1, args.size()-2));
+            if (!args.empty()) vals = split_csv(args);
+        }
+        auto it = preparadas.find(name);
+        if (it==preparadas.end()){ os << "No existe la sentencia preparada: " << name << "\n"; return; }
+        Statement& st = it->second;
+        if ((int)vals.size()!=st.param_count()){
+            os << "EXECUTE " << name << " espera " << st.param_count() << " parámetros (recibió " << vals.size() << ").\n";
+            return;
+        }
+        for (size_t i=0;i<vals.size();++i) st.bind((int)i+1, literal_value(vals[i]));
+        st.reset();
+        if (st.plan->kind==Plan::Kind::SELECT){
+            TextSink sink(os); std::string err;
+            if (!emitir(st, sink, err)) os << err << "\n";
+            return;
+        }
+        st.step();
+        if (!st.error().empty()){ os << st.error() << "\n"; return; }
+        os << (st.plan->kind==Plan::Kind::DELETE ? "(filas borradas: " : "(filas actualizadas: ") << st.changes() << ")\n";
+    }
 
-        if (wexpr.empty()){
-            pids.resize(n);
-            for (long i=0;i<n;++i) pids[i]=(int)i;
-        } else {
-            Where w{};
-            if (!parse_where(wexpr, w)){ os << "WHERE inválido.\n"; return; }
-            auto use_pred = w.p1.value();
-            int cidx=-1; ColType ct{};
-            for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name==use_pred.col){ cidx=i; ct=sc.cols[i].type; break; }
+    // DEALLOCATE [PREPARE] <nombre>
+    void cmd_DEALLOCATE(const std::string& full){
+        std::string name = trim(full.substr(11));
+        if (starts_kw(name, "PREPARE ")) name = trim(name.substr(8));
+        if (preparadas.erase(name)) os << "Sentencia liberada: " << name << "\n";
+        else os << "No existe la sentencia preparada: " << name << "\n";
+    }
 
-            bool used_index=false;
-            if (cidx!=-1 && index_exists(dbdir, tname, use_pred.col, ct)){
-                try {
-                    if (ct==ColType::INT32){
-                        int key = std::stoi(use_pred.lit);
-                        if (use_pred.cmp==Cmp::EQ){
-                            int pid = db.buscar_unitaria(tname, use_pred.col, key);
-                            if (pid>=0) pids.push_back(pid);
-                        } else if (use_pred.cmp==Cmp::GE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, key, std::numeric_limits<int>::max());
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, std::numeric_limits<int>::min(), key);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::GT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, key+1, std::numeric_limits<int>::max());
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, std::numeric_limits<int>::min(), key-1);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else { // NE
-                            auto t1 = db.buscar_rango(tname, use_pred.col, std::numeric_limits<int>::min(), key-1);
-                            auto t2 = db.buscar_rango(tname, use_pred.col, key+1, std::numeric_limits<int>::max());
-                            pids.insert(pids.end(), t1.begin(), t1.end());
-                            pids.insert(pids.end(), t2.begin(), t2.end());
-                        }
-                        used_index=true;
-                    } else if (ct==ColType::FLOAT32){
-                        float key = std::stof(use_pred.lit);
-                        auto ninf = -std::numeric_limits<float>::infinity();
-                        auto pinf =  std::numeric_limits<float>::infinity();
-
-                        if (use_pred.cmp==Cmp::EQ){
-                            int pid = db.buscar_unitaria(tname, use_pred.col, key);
-                            if (pid>=0) pids.push_back(pid);
-                        } else if (use_pred.cmp==Cmp::GE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, key, pinf);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, ninf, key);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::GT){
-                            float a = std::nextafter(key, pinf);
-                            auto tmp = db.buscar_rango(tname, use_pred.col, a, pinf);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LT){
-                            float b = std::nextafter(key, ninf);
-                            auto tmp = db.buscar_rango(tname, use_pred.col, ninf, b);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else { // NE
-                            float a = std::nextafter(key, ninf);
-                            float b = std::nextafter(key, pinf);
-                            auto t1 = db.buscar_rango(tname, use_pred.col, ninf, a);
-                            auto t2 = db.buscar_rango(tname, use_pred.col, b, pinf);
-                            pids.insert(pids.end(), t1.begin(), t1.end());
-                            pids.insert(pids.end(), t2.begin(), t2.end());
-                        }
-                        used_index=true;
-                    } else { // CHAR
-                        std::string L = use_pred.lit;
-                        if (L.size()>=2 && L.front()=='\'' && L.back()=='\'') L = L.substr(1,L.size()-2);
-                        std::string lo = "";
-                        std::string hi = std::string(1, char(127));
-
-                        if (use_pred.cmp==Cmp::EQ){
-                            int pid = db.buscar_unitaria(tname, use_pred.col, L);
-                            if (pid>=0) pids.push_back(pid);
-                        } else if (use_pred.cmp==Cmp::GE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, L, hi);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LE){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, lo, L);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::GT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, L, hi);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else if (use_pred.cmp==Cmp::LT){
-                            auto tmp = db.buscar_rango(tname, use_pred.col, lo, L);
-                            pids.insert(pids.end(), tmp.begin(), tmp.end());
-                        } else { // NE
-                            auto t1 = db.buscar_rango(tname, use_pred.col, lo, L);
-                            auto t2 = db.buscar_rango(tname, use_pred.col, L, hi);
-                            pids.insert(pids.end(), t1.begin(), t1.end());
-                            pids.insert(pids.end(), t2.begin(), t2.end());
-                        }
-                        used_index=true;
-                    }
-                } catch(...) { used_index=false; }
-            }
-            if (!used_index){
-                for (long i=0;i<n;++i) pids.push_back((int)i);
-            }
-            // Filtrado exacto con eval_pred_row (+AND/OR)
-            std::vector<int> filtered; filtered.reserve(pids.size());
-            for (int pid : pids){
-                std::vector<Value> row;
-                if (!tbl.ReadRowByPageID(pid, row)) continue;
-                bool r1 = w.p1 ? eval_pred_row(*w.p1, sc, row) : true;
-                bool r2 = w.p2 ? eval_pred_row(*w.p2, sc, row) : true;
-                bool ok = w.op=="AND" ? (r1 && r2) : (w.op=="OR" ? (r1 || r2) : r1);
-                if (ok) filtered.push_back(pid);
+    // ---- COPY ----
+    // COPY table FROM 'archivo.csv' [HEADER] [DELIMITER 'c']
+    void cmd_COPY(const std::string& full){
+        if (!opened){ os << "Abra una base con USE.\n"; return; }
+        auto up = to_upper(full);
+        size_t pfrom = up.find(" FROM ", 5);
+        if (pfrom==std::string::npos){ os << "Sintaxis COPY inválida.\n"; return; }
+        auto tname = trim(full.substr(5, pfrom-5));
+        size_t q1 = full.find('\'', pfrom+6);
+        size_t q2 = q1==std::string::npos ? q1 : full.find('\'', q1+1);
+        if (q2==std::string::npos || !trim(full.substr(pfrom+6, q1-(pfrom+6))).empty()){
+            os << "Sintaxis COPY inválida (ruta entre comillas simples).\n"; return;
+        }
+        auto ruta = full.substr(q1+1, q2-q1-1);
+
+        csvload::CsvOptions opt;
+        std::istringstream rest(full.substr(q2+1));
+        std::string tok;
+        while (rest >> tok){
+            auto T = to_upper(tok);
+            if (T=="HEADER") opt.header = true;
+            else if (T=="DELIMITER"){
+                std::string d; rest >> d;
+                if (d.size()==3 && d.front()=='\'' && d.back()=='\'') opt.delim = d[1];
+                else if (d=="'\\t'") opt.delim = '\t';
+                else { os << "DELIMITER espera un carácter entre comillas simples.\n"; return; }
             }
-            pids.swap(filtered);
+            else { os << "Opción COPY desconocida: " << tok << "\n"; return; }
         }
-
-        // Ejecutar UPDATE (escritura + refresco de índices)
         try{
-            int nact = db.update_filas_by_pageIDs(tname, pids, setlist);
-            os << "(filas actualizadas: " << nact << ")\n";
-        } catch(const std::exception& e){
-            os << "Error en UPDATE: " << e.what() << "\n";
-        }
+            uint64_t n = db.copiar_csv(tname, ruta, opt);
+            os << "Copiadas " << n << " filas en " << tname << "\n";
+        } catch(const std::exception& e){ os << "Error: " << e.what() << "\n"; }
     }
 
     // ---- CREATE INDEX ----
+    // CREATE INDEX name ON table (col) [USING BTREE|BPLUS]
     void cmd_CREATE_INDEX(const std::string& full){
         if (!opened){ os << "Abra una base con USE.\n"; return; }
         auto up = to_upper(full);
@@ -1000,11 +2549,43 @@ private:
         if (p3==std::string::npos || p4==std::string::npos){ os << "Sintaxis CREATE INDEX inválida.\n"; return; }
         auto tname = trim(full.substr(p2+4, p3-(p2+4)));
         auto col = trim(full.substr(p3+1, p4-p3-1));
+        minidb::TipoIndice tipo = minidb::TipoIndice::BTREE;
+        auto resto = trim(up.substr(p4+1));
+        if (!resto.empty() && resto.back()==';') resto = trim(resto.substr(0, resto.size()-1));
+        if (resto == "USING BPLUS" || resto == "USING BPTREE") tipo = minidb::TipoIndice::BPLUS;
+        else if (!resto.empty() && resto != "USING BTREE"){ os << "Sintaxis CREATE INDEX inválida (USING BTREE|BPLUS).\n"; return; }
         try{
-            db.crear_indice(tname, col);
-            os << "Índice creado para " << tname << "." << col << "\n";
+            db.crear_indice(tname, col, 8, tipo);
+            os << "Índice " << (tipo==minidb::TipoIndice::BPLUS ? "B+Tree" : "B-Tree")
+               << " creado para " << tname << "." << col << "\n";
         } catch(const std::exception& e){ os << "Error: " << e.what() << "\n"; }
     }
 };
 
+inline bool Statement::step(){
+    if (!plan || done) return false;
+    if (!started){
+        started = true;
+        if (!ex->abrir_cursor(*this) || plan->kind!=Plan::Kind::SELECT){ done = true; return false; }
+    }
+    // LIMIT: al completarse se suelta el pipeline (deja de leer, para los hilos del recorrido)
+    if (plan->limite >= 0 && nfilas >= plan->limite){ done = true; pipe.reset(); return false; }
+    while (true){
+        while (bpos >= batch.size()){
+            bpos = 0;
+            bool hay;
+            try { hay = pipe->next(batch); }
+            catch (const std::exception& e){ err = std::string("Error: ") + e.what(); hay = false; }
+            if (!hay){ done = true; return false; }
+        }
+        if (nsaltadas >= plan->offset) break;
+        // OFFSET: se descartan de a lotes, sin armar las filas
+        const size_t k = std::min(batch.size() - bpos, (size_t)(plan->offset - nsaltadas));
+        bpos += k; nsaltadas += (long)k;
+    }
+    cur = batch.row(bpos++);
+    ++nfilas;
+    return true;
+}
+
 } // namespace sqlmini
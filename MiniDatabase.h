@@ -5,11 +5,19 @@
 #include <unordered_map>
 #include <memory>
 #include <filesystem>
+#include <fstream>
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
 
 #include "GenericFixedTable.h"
 #include "DiskBTreeMulti.h"
+#include "DiskBPlusTree.h"
+#include "ExternalSort.h"
+#include "CsvLoader.h"
 
 namespace minidb {
 
@@ -19,19 +27,79 @@ using gft::ColumnDef;
 using gft::ColType;
 using gft::Value;
 
+// Estructura de un índice de columna: B-Tree clásico o B+Tree con hojas enlazadas
+enum class TipoIndice { BTREE, BPLUS };
+
 struct TablaInfo {
     std::unique_ptr<GenericFixedTable> tabla; // tabla abierta en esta sesión
     // Índices por columna (nombre de columna -> índice)
     std::unordered_map<std::string, std::unique_ptr<diskbtree::BTreeInt>>    idx_int;
     std::unordered_map<std::string, std::unique_ptr<diskbtree::BTreeFloat>>  idx_float;
     std::unordered_map<std::string, std::unique_ptr<diskbtree::BTreeChar32>> idx_char;
+    // Índices B+Tree (una columna tiene a lo sumo un índice, de uno u otro tipo)
+    std::unordered_map<std::string, std::unique_ptr<diskbtree::BPTreeInt>>    bp_int;
+    std::unordered_map<std::string, std::unique_ptr<diskbtree::BPTreeFloat>>  bp_float;
+    std::unordered_map<std::string, std::unique_ptr<diskbtree::BPTreeChar32>> bp_char;
     // Mapa: nombre columna -> tipo
     std::unordered_map<std::string, ColType> col_tipos;
+    // Lote de inserción: pageIDs cuyas entradas de índice se difieren hasta volcar el lote
+    bool en_lote = false;
+    std::vector<long> lote_pids;
+    // Directorio de índices ya recorrido en esta sesión (los índices nuevos se registran al crearlos)
+    bool indices_escaneados = false;
+    // El .del ya marca todas las filas con id == -1 (marcador <tabla>.delsync en el directorio).
+    // El marcador se quita mientras haya marcas del .del sin escribir (marca_retirada).
+    bool borrados_sincronizados = false;
+    fs::path marca_sync;
+    bool marca_retirada = false;
+};
+
+// Referencia directa al índice de una columna (a lo sumo un puntero no nulo). Evita buscar por
+// nombre de tabla/columna en cada consulta; vale mientras MiniDatabase::generacion() no cambie.
+struct IndiceRef {
+    diskbtree::BTreeInt*     bt_int   = nullptr;
+    diskbtree::BTreeFloat*   bt_float = nullptr;
+    diskbtree::BTreeChar32*  bt_char  = nullptr;
+    diskbtree::BPTreeInt*    bp_int   = nullptr;
+    diskbtree::BPTreeFloat*  bp_float = nullptr;
+    diskbtree::BPTreeChar32* bp_char  = nullptr;
+    explicit operator bool() const { return bt_int || bt_float || bt_char || bp_int || bp_float || bp_char; }
 };
 
 class MiniDatabase {
 public:
-    MiniDatabase() = default;
+    // buffer_pool_mb: caché de nodos compartida por todos los índices de la sesión
+    explicit MiniDatabase(size_t buffer_pool_mb = BUFFER_POOL_MB)
+        : pool(diskbtree::BufferPool::with_mb(buffer_pool_mb)) {}
+    ~MiniDatabase() {
+        try { aplicar_lotes(); } catch (const std::exception& e) { std::cerr << e.what() << "\n"; }
+    }
+
+    // Reemplaza el buffer pool; los índices abiertos se cierran (volcando sus nodos)
+    // y se reabren bajo demanda con el pool nuevo.
+    void configurar_buffer_pool(size_t mb) {
+        aplicar_lotes();
+        for (auto& kv : tablas) {
+            kv.second.idx_int.clear();
+            kv.second.idx_float.clear();
+            kv.second.idx_char.clear();
+            kv.second.bp_int.clear();
+            kv.second.bp_float.clear();
+            kv.second.bp_char.clear();
+            kv.second.indices_escaneados = false;
+        }
+        pool = diskbtree::BufferPool::with_mb(mb);
+        ++gen;
+    }
+    const diskbtree::BufferPool& buffer_pool() const { return *pool; }
+
+    // Parámetros de la carga masiva de CREATE INDEX: ocupación de nodos (0..1] y
+    // memoria del ordenamiento externo antes de volcar corridas a disco
+    void configurar_carga_masiva(double factor_llenado, size_t memoria_mb) {
+        if (factor_llenado <= 0.0 || factor_llenado > 1.0) throw std::invalid_argument("factor_llenado fuera de (0,1]");
+        fill_factor = factor_llenado;
+        sort_mem_mb = std::max<size_t>(memoria_mb, 1);
+    }
 
     // --------- Gestión de base de datos (carpeta) ---------
     void crear_base_de_datos(const std::string& ruta) {
@@ -46,11 +114,15 @@ public:
             throw std::runtime_error("No existe carpeta de DB: " + ruta);
         }
         abierta = true;
+        aplicar_lotes();
         tablas.clear();
+        ++gen;
     }
 
     void cerrar_base_de_datos() {
+        aplicar_lotes();
         tablas.clear();
+        ++gen;
         abierta = false;
         root.clear();
     }
@@ -69,7 +141,11 @@ public:
         for (const auto& c : esquema) {
             ti.col_tipos[c.name] = c.type;
         }
+        ti.marca_sync = tdir / (nombre + ".delsync");
+        std::ofstream marca(ti.marca_sync);   // tabla nueva: .del y id == -1 van juntos desde el inicio
+        ti.borrados_sincronizados = true;
         tablas[nombre] = std::move(ti);
+        ++gen;
     }
 
     // Abre una tabla ya existente (si la cerraste o en una nueva sesión)
@@ -82,81 +158,135 @@ public:
         auto tabla = std::make_unique<GenericFixedTable>(tfile.string(), nombre, std::vector<ColumnDef>{}, /*create_new*/false);
         TablaInfo ti;
         ti.tabla = std::move(tabla);
+        ti.marca_sync = tdir / (nombre + ".delsync");
         // tipos se irán llenando bajo demanda (crear_indice / ensure_indices_loaded / detectar_tipo_columna)
         tablas[nombre] = std::move(ti);
     }
 
+    // Tabla abierta de la sesión, con el lote pendiente ya volcado, para lecturas directas.
+    // La referencia vale hasta el próximo USE/CLOSE o CREATE TABLE con el mismo nombre.
+    GenericFixedTable& tabla(const std::string& nombre) {
+        TablaInfo& ti = obtener_tabla(nombre);
+        aplicar_lote(ti);
+        return *ti.tabla;
+    }
+
+    // Cambia cuando un handle de tabla o de índice entregado antes puede haber dejado de valer o ya
+    // no es la mejor opción (USE/CLOSE, CREATE TABLE, índices creados, reconstruidos o descubiertos,
+    // buffer pool nuevo). Los planes cacheados de la capa SQL se revalidan contra este número.
+    uint64_t generacion() const { return gen; }
+
+    // Índice de la columna (B+Tree o B-Tree) para sondeos repetidos; vacío si no hay
+    IndiceRef indice_ref(const std::string& nt, const std::string& col) {
+        ensure_indices_loaded(nt);
+        TablaInfo& ti = obtener_tabla(nt);
+        IndiceRef r;
+        if (auto it = ti.bp_int.find(col);    it != ti.bp_int.end())    r.bp_int   = it->second.get();
+        if (auto it = ti.bp_float.find(col);  it != ti.bp_float.end())  r.bp_float = it->second.get();
+        if (auto it = ti.bp_char.find(col);   it != ti.bp_char.end())   r.bp_char  = it->second.get();
+        if (auto it = ti.idx_int.find(col);   it != ti.idx_int.end())   r.bt_int   = it->second.get();
+        if (auto it = ti.idx_float.find(col); it != ti.idx_float.end()) r.bt_float = it->second.get();
+        if (auto it = ti.idx_char.find(col);  it != ti.idx_char.end())  r.bt_char  = it->second.get();
+        return r;
+    }
+
     // --------- Índices ---------
-    // Crea índice para una columna; detecta ColType y construye el índice apropiado
-    void crear_indice(const std::string& nombre_tabla, const std::string& columna, int t_btree = 8) {
+    // Crea índice para una columna; detecta ColType y construye el índice apropiado.
+    // Se construye por carga masiva: una pasada secuencial sobre la tabla, ordenamiento externo
+    // de (clave, pageID) y escritura de los nodos de abajo hacia arriba.
+    // tipo elige B-Tree (.bti/.btf/.bts, grado t_btree) o B+Tree (.bpi/.bpf/.bps, nodo de una página);
+    // si la columna ya tenía un índice del otro tipo, se reemplaza.
+    void crear_indice(const std::string& nombre_tabla, const std::string& columna, int t_btree = 8,
+                      TipoIndice tipo_idx = TipoIndice::BTREE) {
         TablaInfo& ti = obtener_tabla(nombre_tabla);
         auto& tbl = *ti.tabla;
+        aplicar_lote(ti);   // la carga masiva debe ver todas las filas y ningún pendiente duplicarse
 
         ColType tipo = detectar_tipo_columna(tbl, ti, columna);
 
         fs::path tdir = root / nombre_tabla;
         fs::create_directories(tdir);
         std::string base = nombre_tabla + "_" + columna;
-        fs::path idx_file;
-
-        long n = tbl.Count();
+        quitar_indice(ti, tdir, base, columna);
+        bool bplus = (tipo_idx == TipoIndice::BPLUS);
 
         if (tipo == ColType::INT32) {
-            idx_file = tdir / (base + ".bti");
-            auto idx = std::make_unique<diskbtree::BTreeInt>(idx_file.string(), t_btree, /*create_new*/true);
-            for (long pid = 0; pid < n; ++pid) {
-                std::vector<Value> row;
-                if (!tbl.ReadRowByPageID(pid, row)) continue;
-                // saltar tombstones (id == -1)
-                int id_idx = tbl.col_index("id");
-                if (id_idx >= 0 && row[id_idx].i == -1) continue;
-                int v = tbl.ReadInt(pid, columna);
-                idx->insert(v, (int)pid);
+            if (bplus) {
+                auto idx = std::make_unique<diskbtree::BPTreeInt>((tdir / (base + ".bpi")).string(), /*create_new*/true, pool);
+                cargar_indice(tbl, *idx, columna, tdir / ("." + base));
+                ti.bp_int[columna] = std::move(idx);
+            } else {
+                auto idx = std::make_unique<diskbtree::BTreeInt>((tdir / (base + ".bti")).string(), t_btree, /*create_new*/true, pool);
+                cargar_indice(tbl, *idx, columna, tdir / ("." + base));
+                ti.idx_int[columna] = std::move(idx);
             }
-            ti.idx_int[columna] = std::move(idx);
             ti.col_tipos[columna] = ColType::INT32;
         } else if (tipo == ColType::FLOAT32) {
-            idx_file = tdir / (base + ".btf");
-            auto idx = std::make_unique<diskbtree::BTreeFloat>(idx_file.string(), t_btree, /*create_new*/true);
-            for (long pid = 0; pid < n; ++pid) {
-                std::vector<Value> row;
-                if (!tbl.ReadRowByPageID(pid, row)) continue;
-                int id_idx = tbl.col_index("id");
-                if (id_idx >= 0 && row[id_idx].i == -1) continue;
-                float v = tbl.ReadFloat(pid, columna);
-                idx->insert(v, (int)pid);
+            if (bplus) {
+                auto idx = std::make_unique<diskbtree::BPTreeFloat>((tdir / (base + ".bpf")).string(), true, pool);
+                cargar_indice(tbl, *idx, columna, tdir / ("." + base));
+                ti.bp_float[columna] = std::move(idx);
+            } else {
+                auto idx = std::make_unique<diskbtree::BTreeFloat>((tdir / (base + ".btf")).string(), t_btree, true, pool);
+                cargar_indice(tbl, *idx, columna, tdir / ("." + base));
+                ti.idx_float[columna] = std::move(idx);
             }
-            ti.idx_float[columna] = std::move(idx);
             ti.col_tipos[columna] = ColType::FLOAT32;
         } else if (tipo == ColType::CHAR) {
-            idx_file = tdir / (base + ".bts");
-            auto idx = std::make_unique<diskbtree::BTreeChar32>(idx_file.string(), t_btree, /*create_new*/true);
-            for (long pid = 0; pid < n; ++pid) {
-                std::vector<Value> row;
-                if (!tbl.ReadRowByPageID(pid, row)) continue;
-                int id_idx = tbl.col_index("id");
-                if (id_idx >= 0 && row[id_idx].i == -1) continue;
-                std::string v = tbl.ReadChar(pid, columna);
-                idx->insert(v, (int)pid);
+            if (bplus) {
+                auto idx = std::make_unique<diskbtree::BPTreeChar32>((tdir / (base + ".bps")).string(), true, pool);
+                cargar_indice(tbl, *idx, columna, tdir / ("." + base));
+                ti.bp_char[columna] = std::move(idx);
+            } else {
+                auto idx = std::make_unique<diskbtree::BTreeChar32>((tdir / (base + ".bts")).string(), t_btree, true, pool);
+                cargar_indice(tbl, *idx, columna, tdir / ("." + base));
+                ti.idx_char[columna] = std::move(idx);
             }
-            ti.idx_char[columna] = std::move(idx);
             ti.col_tipos[columna] = ColType::CHAR;
         } else {
             throw std::runtime_error("Tipo de columna no soportado para índice");
         }
     }
 
+    // Sin grado explícito: B+Tree, o B-Tree con el grado por defecto
+    void crear_indice(const std::string& nombre_tabla, const std::string& columna, TipoIndice tipo_idx) {
+        crear_indice(nombre_tabla, columna, 8, tipo_idx);
+    }
+
+    // Tipo del índice abierto sobre la columna (false si no hay índice cargado)
+    bool tipo_indice(const std::string& nombre_tabla, const std::string& columna, TipoIndice& out) {
+        TablaInfo& ti = obtener_tabla(nombre_tabla);
+        ensure_indices_loaded(nombre_tabla);
+        if (ti.bp_int.count(columna) || ti.bp_float.count(columna) || ti.bp_char.count(columna)) {
+            out = TipoIndice::BPLUS; return true;
+        }
+        if (ti.idx_int.count(columna) || ti.idx_float.count(columna) || ti.idx_char.count(columna)) {
+            out = TipoIndice::BTREE; return true;
+        }
+        return false;
+    }
+
     // ---------- NUEVO: Carga perezosa de índices existentes ----------
+    // También vuelca un lote de inserción pendiente: todas las lecturas/modificaciones pasan por aquí.
+    // El directorio se recorre una sola vez por tabla y sesión; después es solo una consulta en memoria.
     void ensure_indices_loaded(const std::string& nombre_tabla) {
         TablaInfo& ti = obtener_tabla(nombre_tabla);
+        aplicar_lote(ti);
+        if (ti.indices_escaneados) return;
+        ti.indices_escaneados = true;
         fs::path tdir = root / nombre_tabla;
         if (!fs::exists(tdir)) return;
 
+        // índices en formato de nodo anterior: se reconstruyen desde la tabla
+        struct Reconstruir { std::string col; ColType tipo; TipoIndice idx; };
+        std::vector<Reconstruir> reconstruir;
+
         for (auto& e : fs::directory_iterator(tdir)) {
             if (!e.is_regular_file()) continue;
-            auto fn = e.path().filename().string();     // ventas_col.bti / .btf / .bts
+            auto fn = e.path().filename().string();     // ventas_col.bti / .btf / .bts / .bpi / .bpf / .bps
             auto ext = e.path().extension().string();   // .bti etc.
-            if (ext!=".bti" && ext!=".btf" && ext!=".bts") continue;
+            if (ext!=".bti" && ext!=".btf" && ext!=".bts" &&
+                ext!=".bpi" && ext!=".bpf" && ext!=".bps") continue;
 
             // obtener nombre de columna a partir de "<tabla>_<col>.<ext>"
             auto stem = e.path().stem().string(); // ventas_col
@@ -166,51 +296,176 @@ public:
 
             try {
                 if (ext == ".bti" && ti.idx_int.find(col)==ti.idx_int.end()) {
-                    ti.idx_int[col] = std::make_unique<diskbtree::BTreeInt>(e.path().string(), /*t ignored*/2, /*create_new*/false);
+                    ti.idx_int[col] = std::make_unique<diskbtree::BTreeInt>(e.path().string(), /*t ignored*/2, /*create_new*/false, pool);
                     ti.col_tipos[col] = ColType::INT32;
                 } else if (ext == ".btf" && ti.idx_float.find(col)==ti.idx_float.end()) {
-                    ti.idx_float[col] = std::make_unique<diskbtree::BTreeFloat>(e.path().string(), 2, false);
+                    ti.idx_float[col] = std::make_unique<diskbtree::BTreeFloat>(e.path().string(), 2, false, pool);
                     ti.col_tipos[col] = ColType::FLOAT32;
                 } else if (ext == ".bts" && ti.idx_char.find(col)==ti.idx_char.end()) {
-                    ti.idx_char[col] = std::make_unique<diskbtree::BTreeChar32>(e.path().string(), 2, false);
+                    ti.idx_char[col] = std::make_unique<diskbtree::BTreeChar32>(e.path().string(), 2, false, pool);
+                    ti.col_tipos[col] = ColType::CHAR;
+                } else if (ext == ".bpi" && ti.bp_int.find(col)==ti.bp_int.end()) {
+                    ti.bp_int[col] = std::make_unique<diskbtree::BPTreeInt>(e.path().string(), /*create_new*/false, pool);
+                    ti.col_tipos[col] = ColType::INT32;
+                } else if (ext == ".bpf" && ti.bp_float.find(col)==ti.bp_float.end()) {
+                    ti.bp_float[col] = std::make_unique<diskbtree::BPTreeFloat>(e.path().string(), false, pool);
+                    ti.col_tipos[col] = ColType::FLOAT32;
+                } else if (ext == ".bps" && ti.bp_char.find(col)==ti.bp_char.end()) {
+                    ti.bp_char[col] = std::make_unique<diskbtree::BPTreeChar32>(e.path().string(), false, pool);
                     ti.col_tipos[col] = ColType::CHAR;
                 }
+            } catch (const diskbtree::IndexFormatError&) {
+                reconstruir.push_back({col, (ext == ".bti" || ext == ".bpi") ? ColType::INT32
+                                          : (ext == ".btf" || ext == ".bpf") ? ColType::FLOAT32 : ColType::CHAR,
+                                       ext[2] == 'p' ? TipoIndice::BPLUS : TipoIndice::BTREE});
             } catch (...) {
                 // ignorar errores de carga individual para no romper la sesión completa
             }
         }
+
+        for (auto& r : reconstruir) {
+            try {
+                ti.col_tipos[r.col] = r.tipo;
+                crear_indice(nombre_tabla, r.col, 8, r.idx);
+            } catch (...) {}
+        }
+        ++gen;
     }
 
     // ---------- NUEVO: Insert que actualiza índices ----------
     long insertar_fila(const std::string& nombre_tabla, const std::vector<Value>& row) {
         TablaInfo& ti = obtener_tabla(nombre_tabla);
-        ensure_indices_loaded(nombre_tabla); // para que actualicemos todo lo existente
+        if (!ti.en_lote) ensure_indices_loaded(nombre_tabla); // para que actualicemos todo lo existente
 
         long pid = ti.tabla->AppendRow(row);
+        marcar_si_borrada(ti, pid, row);
+        volcar_borrados(ti);
+        ti.lote_pids.push_back(pid);
+        // fuera de lote (o si el auto-commit ya volcó las filas) los índices se actualizan ahora
+        if (!ti.en_lote || ti.tabla->PendingRows() == 0) aplicar_lote(ti);
+        return pid;
+    }
 
-        // actualizar índices que tengamos cargados
-        for (auto& kv : ti.idx_int) {
-            const std::string& col = kv.first;
-            try {
-                int v = ti.tabla->ReadInt(pid, col);
-                kv.second->insert(v, (int)pid);
-            } catch(...) {}
+    // Inserta varias filas con un solo volcado: resuelve tabla e índices una vez, agrega todas las
+    // filas en un lote y luego inserta en cada índice sus entradas ordenadas por (clave, pageID).
+    // Devuelve el pageID de la primera fila (las demás son consecutivas).
+    long insertar_filas(const std::string& nombre_tabla, const std::vector<std::vector<Value>>& filas) {
+        TablaInfo& ti = obtener_tabla(nombre_tabla);
+        ensure_indices_loaded(nombre_tabla);   // también vuelca un lote previo
+        auto& tbl = *ti.tabla;
+        const long first = tbl.Count();
+        if (filas.empty()) return first;
+
+        const bool lote_previo = tbl.InBatch();
+        tbl.BeginBatch();
+        try {
+            for (const auto& f : filas) tbl.AppendRow(f);
+        } catch (...) {
+            if (!lote_previo) tbl.CommitBatch(); else tbl.FlushBatch();
+            throw;
         }
-        for (auto& kv : ti.idx_float) {
-            const std::string& col = kv.first;
-            try {
-                float v = ti.tabla->ReadFloat(pid, col);
-                kv.second->insert(v, (int)pid);
-            } catch(...) {}
+        if (!lote_previo) tbl.CommitBatch(); else tbl.FlushBatch();
+        for (size_t i = 0; i < filas.size(); ++i) marcar_si_borrada(ti, first + (long)i, filas[i]);
+        volcar_borrados(ti);
+
+        indexar_rango_ordenado(ti, nombre_tabla, first, first + (long)filas.size());
+        return first;
+    }
+
+    // ---------- Carga masiva desde CSV (COPY) ----------
+    // Parsea el CSV en paralelo directo al formato de la tabla y lo agrega con escrituras grandes.
+    // Con opt.header los campos se asocian por nombre; si no, siguen el orden de las columnas,
+    // con o sin 'id' (si falta, se autoincrementa como en INSERT). Después, si la carga al menos
+    // duplica la tabla, cada índice se reconstruye por carga masiva; si no, se insertan las
+    // claves nuevas ordenadas por (clave, pageID). Devuelve las filas cargadas.
+    uint64_t copiar_csv(const std::string& nombre_tabla, const std::string& ruta,
+                        const csvload::CsvOptions& opt = {}) {
+        TablaInfo& ti = obtener_tabla(nombre_tabla);
+        ensure_indices_loaded(nombre_tabla);   // también vuelca un lote previo
+        auto& tbl = *ti.tabla;
+        csvload::CsvLoader csv(ruta, opt);
+
+        const int id_col = tbl.col_index("id");
+        auto destino = [&](int c) {
+            const auto& m = tbl.col_meta(c);
+            return csvload::FieldTarget{(ColType)m.type, m.width, m.offset};
+        };
+        std::vector<csvload::FieldTarget> targets;
+        bool id_en_csv = false;
+        if (opt.header) {
+            std::vector<bool> vista((size_t)tbl.ncols(), false);
+            for (auto& name : csv.header()) {
+                int c = tbl.col_index(name);
+                if (c < 0) throw std::runtime_error("Columna desconocida en CSV: " + name);
+                if (vista[(size_t)c]) throw std::runtime_error("Columna repetida en CSV: " + name);
+                vista[(size_t)c] = true;
+                if (c == id_col) id_en_csv = true;
+                targets.push_back(destino(c));
+            }
+        } else {
+            id_en_csv = id_col < 0 || csv.first_record_fields() == (size_t)tbl.ncols();
+            for (int c = 0; c < tbl.ncols(); ++c) if (id_en_csv || c != id_col) targets.push_back(destino(c));
         }
-        for (auto& kv : ti.idx_char) {
-            const std::string& col = kv.first;
-            try {
-                std::string v = ti.tabla->ReadChar(pid, col);
-                kv.second->insert(v, (int)pid);
-            } catch(...) {}
+        const int id_off = (id_en_csv || id_col < 0) ? -1 : tbl.col_meta(id_col).offset;
+        const int id_csv = id_en_csv && id_col >= 0 ? tbl.col_meta(id_col).offset : -1;
+        const int rs = tbl.row_size();
+
+        const long antes = tbl.Count();
+        uint64_t n = 0;
+        try {
+            n = csv.load(targets, rs, [&](char* rows, size_t k) {
+                if (id_off >= 0) {
+                    int32_t id = (int32_t)tbl.Count() + 1;
+                    for (size_t i = 0; i < k; ++i, ++id) std::memcpy(rows + i * rs + id_off, &id, 4);
+                }
+                const long base = tbl.Count();
+                tbl.AppendPacked(rows, (long)k);
+                if (id_csv >= 0) {
+                    // filas que llegan ya borradas (id == -1): también al .del
+                    for (size_t i = 0; i < k; ++i) {
+                        int32_t id; std::memcpy(&id, rows + i * rs + id_csv, 4);
+                        if (id == -1) marcar_borrada(ti, base + (long)i);
+                    }
+                }
+            });
+        } catch (...) {
+            volcar_borrados(ti);
+            indexar_carga(ti, nombre_tabla, antes);   // lo ya agregado queda indexado
+            throw;
         }
-        return pid;
+        volcar_borrados(ti);
+        indexar_carga(ti, nombre_tabla, antes);
+        return n;
+    }
+
+    // ---------- Lotes de inserción (ingesta) ----------
+    // Entre iniciar_lote y confirmar_lote, insertar_fila acumula las filas en el buffer de la
+    // tabla (una escritura + un flush por lote) y difiere las inserciones en índices hasta el
+    // mismo volcado. max_filas / max_ms > 0 activan el auto-commit por tamaño / antigüedad: el
+    // tamaño se mira en cada fila; la antigüedad también en cada acceso a cualquier tabla y en
+    // vencer_lotes(). Cualquier lectura o modificación de la tabla vuelca antes lo pendiente.
+    void iniciar_lote(const std::string& nombre_tabla, size_t max_filas = 0, unsigned max_ms = 0) {
+        TablaInfo& ti = obtener_tabla(nombre_tabla);
+        ensure_indices_loaded(nombre_tabla);
+        ti.tabla->SetAutoCommit(max_filas, max_ms);
+        ti.tabla->BeginBatch();
+        ti.en_lote = true;
+    }
+    // Vuelca (filas y entradas de índice diferidas) los lotes con max_ms vencido. Quien deja un
+    // lote abierto sin volver a usar la base lo llama desde su propio temporizador, en el mismo
+    // hilo que usa la base, para que un lote inactivo no espere más que max_ms.
+    void vencer_lotes() {
+        for (auto& kv : tablas) {
+            TablaInfo& ti = kv.second;
+            if (ti.en_lote && ti.tabla->BatchExpired()) aplicar_lote(ti);
+        }
+    }
+    void confirmar_lote(const std::string& nombre_tabla) {
+        TablaInfo& ti = obtener_tabla(nombre_tabla);
+        aplicar_lote(ti);
+        ti.tabla->CommitBatch();
+        ti.tabla->SetAutoCommit(0, 0);
+        ti.en_lote = false;
     }
 
     // ---------- NUEVO: Borrado lógico por pageID con actualización de índices ----------
@@ -225,55 +480,80 @@ public:
         int id_idx = ti.tabla->col_index("id");
         if (id_idx >= 0 && row[id_idx].i == -1) return false;
 
-        // quitar de índices (nota: remove_key quita una ocurrencia; con claves duplicadas puede quitar cualquiera)
+        // quitar de índices: borrado exacto de la entrada (clave, pid), también con claves duplicadas
         for (auto& kv : ti.idx_int) {
             const std::string& col = kv.first;
-            try { int v = ti.tabla->ReadInt(pid, col); kv.second->remove_key(v); } catch(...) {}
+            try { int v = ti.tabla->ReadInt(pid, col); kv.second->remove(v, (int)pid); } catch(...) {}
         }
         for (auto& kv : ti.idx_float) {
             const std::string& col = kv.first;
-            try { float v = ti.tabla->ReadFloat(pid, col); kv.second->remove_key(v); } catch(...) {}
+            try { float v = ti.tabla->ReadFloat(pid, col); kv.second->remove(v, (int)pid); } catch(...) {}
         }
         for (auto& kv : ti.idx_char) {
             const std::string& col = kv.first;
-            try { std::string v = ti.tabla->ReadChar(pid, col); kv.second->remove_key(v); } catch(...) {}
+            try { std::string v = ti.tabla->ReadChar(pid, col); kv.second->remove(v, (int)pid); } catch(...) {}
+        }
+        // B+Tree: borrado exacto de la entrada (clave, pid)
+        for (auto& kv : ti.bp_int) {
+            try { kv.second->remove(ti.tabla->ReadInt(pid, kv.first), (int)pid); } catch(...) {}
+        }
+        for (auto& kv : ti.bp_float) {
+            try { kv.second->remove(ti.tabla->ReadFloat(pid, kv.first), (int)pid); } catch(...) {}
+        }
+        for (auto& kv : ti.bp_char) {
+            try { kv.second->remove(ti.tabla->ReadChar(pid, kv.first), (int)pid); } catch(...) {}
         }
 
-        // tombstone: id = -1
+        // tombstone: id = -1, y la marca en .del (CountLive / filas_vivas); el .del se escribe en
+        // confirmar_borrados, una vez por sentencia
         if (id_idx >= 0) row[id_idx] = Value::Int(-1);
         ti.tabla->WriteRowInDisk(pid, row);
+        marcar_borrada(ti, pid);
         return true;
     }
 
+    // Escribe al .del las marcas de borrado pendientes de la tabla. borrar_por_pageid y
+    // update_filas_by_pageIDs marcan fila a fila en memoria; quien los llama confirma al terminar
+    // la sentencia, así un corte del proceso no deja filas con id == -1 vivas en el .del.
+    void confirmar_borrados(const std::string& nombre_tabla) {
+        volcar_borrados(obtener_tabla(nombre_tabla));
+    }
+
     // --------- Operaciones sobre índices (lectura) ---------
     int buscar_unitaria(const std::string& nombre_tabla, const std::string& columna, int clave_int) {
         ensure_indices_loaded(nombre_tabla);
+        if (auto* bp = buscar_bplus_int(nombre_tabla, columna)) return bp->search_get_value(clave_int);
         auto* idx = obtener_indice_int(nombre_tabla, columna);
         return idx->search_get_value(clave_int);
     }
     int buscar_unitaria(const std::string& nombre_tabla, const std::string& columna, float clave_flt) {
         ensure_indices_loaded(nombre_tabla);
+        if (auto* bp = buscar_bplus_float(nombre_tabla, columna)) return bp->search_get_value(clave_flt);
         auto* idx = obtener_indice_float(nombre_tabla, columna);
         return idx->search_get_value(clave_flt);
     }
     int buscar_unitaria(const std::string& nombre_tabla, const std::string& columna, const std::string& clave_str) {
         ensure_indices_loaded(nombre_tabla);
+        if (auto* bp = buscar_bplus_char(nombre_tabla, columna)) return bp->search_get_value(clave_str);
         auto* idx = obtener_indice_char(nombre_tabla, columna);
         return idx->search_get_value(clave_str);
     }
 
     std::vector<int> buscar_rango(const std::string& nt, const std::string& col, int a, int b) {
         ensure_indices_loaded(nt);
+        if (auto* bp = buscar_bplus_int(nt, col)) return bp->range_search_values(a, b);
         auto* idx = obtener_indice_int(nt, col);
         return idx->range_search_values(a, b);
     }
     std::vector<int> buscar_rango(const std::string& nt, const std::string& col, float a, float b) {
         ensure_indices_loaded(nt);
+        if (auto* bp = buscar_bplus_float(nt, col)) return bp->range_search_values(a, b);
         auto* idx = obtener_indice_float(nt, col);
         return idx->range_search_values(a, b);
     }
     std::vector<int> buscar_rango(const std::string& nt, const std::string& col, const std::string& a, const std::string& b) {
         ensure_indices_loaded(nt);
+        if (auto* bp = buscar_bplus_char(nt, col)) return bp->range_search_values(a, b);
         auto* idx = obtener_indice_char(nt, col);
         return idx->range_search_values(a, b);
     }
@@ -281,20 +561,58 @@ public:
     // Eliminación de una ocurrencia por clave (en el índice)
     void eliminar_por_clave(const std::string& nt, const std::string& col, int clave_int) {
         ensure_indices_loaded(nt);
+        if (auto* bp = buscar_bplus_int(nt, col)) { bp->remove_key(clave_int); return; }
         auto* idx = obtener_indice_int(nt, col);
         idx->remove_key(clave_int);
     }
     void eliminar_por_clave(const std::string& nt, const std::string& col, float clave_flt) {
         ensure_indices_loaded(nt);
+        if (auto* bp = buscar_bplus_float(nt, col)) { bp->remove_key(clave_flt); return; }
         auto* idx = obtener_indice_float(nt, col);
         idx->remove_key(clave_flt);
     }
     void eliminar_por_clave(const std::string& nt, const std::string& col, const std::string& clave_str) {
         ensure_indices_loaded(nt);
+        if (auto* bp = buscar_bplus_char(nt, col)) { bp->remove_key(clave_str); return; }
         auto* idx = obtener_indice_char(nt, col);
         idx->remove_key(clave_str);
     }
 
+    // Filas físicas de la tabla (incluye borradas); usa el conteo en memoria del handle abierto
+    long contar_filas(const std::string& nombre_tabla) {
+        return obtener_tabla(nombre_tabla).tabla->Count();
+    }
+
+    // Filas vivas (sin las borradas con id == -1) sin recorrer la tabla: DELETE también marca el
+    // .del, así que alcanza con CountLive(). Sin el marcador <tabla>.delsync (tabla creada antes de
+    // eso, o proceso cortado con marcas del .del sin escribir) se sincroniza una vez: marca en .del
+    // cada fila con id == -1 y vuelve a crear el marcador.
+    long filas_vivas(const std::string& nombre_tabla) {
+        TablaInfo& ti = obtener_tabla(nombre_tabla);
+        aplicar_lote(ti);
+        auto& tbl = *ti.tabla;
+        if (!ti.borrados_sincronizados) {
+            const fs::path& marca = ti.marca_sync;
+            if (!fs::exists(marca)) {
+                const int id_idx = tbl.col_index("id");
+                if (id_idx >= 0 && tbl.col_meta(id_idx).type == (int)ColType::INT32) {
+                    const int off = tbl.col_meta(id_idx).offset;
+                    std::vector<long> borradas;
+                    tbl.ScanRows([&](long pid, const char* r) {
+                        int32_t id; std::memcpy(&id, r + off, 4);
+                        if (id == -1) borradas.push_back(pid);
+                    });
+                    for (long pid : borradas) tbl.MarkDeleted(pid);
+                    tbl.FlushDeleted();
+                }
+                std::ofstream crear(marca);
+                ti.marca_retirada = false;
+            }
+            ti.borrados_sincronizados = true;
+        }
+        return tbl.CountLive();
+    }
+
     // Lectura de una fila por pageID (devuelve vector<Value>)
     bool leer_fila(const std::string& nombre_tabla, long pageID, std::vector<Value>& out) {
         TablaInfo& ti = obtener_tabla(nombre_tabla);
@@ -341,7 +659,8 @@ public:
             if (eq_val(vold, vnew)) continue; // sin cambio
 
             // Registrar delta solo si esa columna tiene índice
-            bool has_index = (ti.idx_int.count(cname) || ti.idx_float.count(cname) || ti.idx_char.count(cname));
+            bool has_index = (ti.idx_int.count(cname) || ti.idx_float.count(cname) || ti.idx_char.count(cname) ||
+                              ti.bp_int.count(cname) || ti.bp_float.count(cname) || ti.bp_char.count(cname));
             if (has_index) deltas.push_back({cname, vnew.t, vold, vnew});
 
             row[cix] = vnew; // aplicar cambio en memoria
@@ -358,22 +677,25 @@ public:
 
         // Persistir fila
         tbl.WriteRowInDisk(pageID, row);
+        marcar_si_borrada(ti, pageID, row);
+        volcar_borrados(ti);
 
         // Actualizar índices (remove old -> insert new)
         for (auto& d : deltas){
+            if (actualizar_bplus(ti, d.col, pageID, d.oldv, d.newv)) continue;
             if (d.t==ColType::INT32){
                 auto it = ti.idx_int.find(d.col); if (it!=ti.idx_int.end()){
-                    it->second->remove_key(d.oldv.i);
+                    it->second->remove(d.oldv.i, (int)pageID);
                     it->second->insert(d.newv.i, (int)pageID);
                 }
             } else if (d.t==ColType::FLOAT32){
                 auto it = ti.idx_float.find(d.col); if (it!=ti.idx_float.end()){
-                    it->second->remove_key(d.oldv.f);
+                    it->second->remove(d.oldv.f, (int)pageID);
                     it->second->insert(d.newv.f, (int)pageID);
                 }
             } else { // CHAR
                 auto it = ti.idx_char.find(d.col); if (it!=ti.idx_char.end()){
-                    it->second->remove_key(d.oldv.s);
+                    it->second->remove(d.oldv.s, (int)pageID);
                     it->second->insert(d.newv.s, (int)pageID);
                 }
             }
@@ -405,24 +727,26 @@ public:
                                     const std::vector<Value>& row_despues)
     {
         TablaInfo& ti = obtener_tabla(nt);
+        aplicar_lote(ti);
 
         auto apply_one = [&](const std::string& c, const Value& before, const Value& after){
+            if (actualizar_bplus(ti, c, pid, before, after)) return;
             auto itI = ti.idx_int.find(c);
             if (itI != ti.idx_int.end()) {
-                // quitar clave vieja e insertar nueva
-                itI->second->remove_key(before.i);
+                // quitar la entrada (clave vieja, pid) e insertar la nueva
+                itI->second->remove(before.i, (int)pid);
                 itI->second->insert(after.i, (int)pid);
                 return;
             }
             auto itF = ti.idx_float.find(c);
             if (itF != ti.idx_float.end()) {
-                itF->second->remove_key(before.f);
+                itF->second->remove(before.f, (int)pid);
                 itF->second->insert(after.f, (int)pid);
                 return;
             }
             auto itS = ti.idx_char.find(c);
             if (itS != ti.idx_char.end()) {
-                itS->second->remove_key(before.s);
+                itS->second->remove(before.s, (int)pid);
                 itS->second->insert(after.s, (int)pid);
                 return;
             }
@@ -455,6 +779,7 @@ public:
     {
         TablaInfo& ti = obtener_tabla(nt);
         auto& tbl = *ti.tabla;
+        aplicar_lote(ti);
 
         // Mapear nombre->indice físico para aplicar más rápido
         std::vector<int> idxs; idxs.reserve(setlist.size());
@@ -498,6 +823,7 @@ public:
 
             // Persistir
             tbl.WriteRowInDisk(pid, after);
+            marcar_si_borrada(ti, pid, after);
             // Refrescar índices abiertos solo de columnas afectadas
             actualizar_fila_en_indices(nt, pid, setlist, before, after);
 
@@ -509,15 +835,47 @@ public:
 private:
     fs::path root;
     bool abierta = false;
+    std::shared_ptr<diskbtree::BufferPool> pool;
+    double fill_factor = BULK_FILL_FACTOR;
+    size_t sort_mem_mb = EXTSORT_MEM_MB;
 
     std::unordered_map<std::string, TablaInfo> tablas;
+    uint64_t gen = 0;   // ver generacion()
 
     void asegurar_abierta() const {
         if (!abierta) throw std::runtime_error("No hay base de datos abierta");
     }
 
+    // Marca pid en el .del. Antes de la primera marca sin escribir se quita <tabla>.delsync: si el
+    // proceso se corta antes de volcar_borrados, filas_vivas vuelve a sincronizar en vez de contar
+    // con un .del atrasado.
+    static void marcar_borrada(TablaInfo& ti, long pid) {
+        if (!ti.marca_retirada && !ti.tabla->DeletedPending()) {
+            std::error_code ec;
+            ti.marca_retirada = fs::remove(ti.marca_sync, ec);
+        }
+        ti.tabla->MarkDeleted(pid);
+    }
+
+    // Escribe las marcas pendientes del .del y repone el marcador si se había quitado
+    static void volcar_borrados(TablaInfo& ti) {
+        ti.tabla->FlushDeleted();
+        if (ti.marca_retirada) {
+            std::ofstream crear(ti.marca_sync);
+            ti.marca_retirada = false;
+        }
+    }
+
+    // Borrado lógico (id == -1) escrito por INSERT/UPDATE: también al .del
+    static void marcar_si_borrada(TablaInfo& ti, long pid, const std::vector<Value>& row) {
+        const int id_idx = ti.tabla->col_index("id");
+        if (id_idx >= 0 && id_idx < (int)row.size() && row[id_idx].t == ColType::INT32 && row[id_idx].i == -1)
+            marcar_borrada(ti, pid);
+    }
+
     TablaInfo& obtener_tabla(const std::string& nombre_tabla) {
         asegurar_abierta();
+        vencer_lotes();
         auto it = tablas.find(nombre_tabla);
         if (it == tablas.end()) {
             // Intentar abrir si no está en el mapa (sesión nueva)
@@ -542,6 +900,202 @@ private:
         throw std::runtime_error("No se puede inferir tipo de columna (tabla vacía o columna inexistente): " + col);
     }
 
+    // Registro del ordenamiento externo de entradas: clave codificada (TRAITS::put) + pageID,
+    // ordenado por (clave, pageID)
+    template<class TRAITS>
+    struct MenorEntrada {
+        bool operator()(const uint8_t* a, const uint8_t* b) const {
+            int c = TRAITS::cmp_mem(a, b);
+            if (c != 0) return c < 0;
+            int32_t pa, pb;
+            std::memcpy(&pa, a + TRAITS::KEY_BYTES, 4); std::memcpy(&pb, b + TRAITS::KEY_BYTES, 4);
+            return pa < pb;
+        }
+    };
+    template<class TRAITS> using OrdenEntradas = extsort::ExternalSorter<MenorEntrada<TRAITS>>;
+
+    // Extrae (clave, pageID) de las filas vivas [first, last) con ScanRange, saltando tombstones
+    // (id == -1), y las agrega al ordenamiento externo
+    template<class TRAITS>
+    static void ordenar_entradas(GenericFixedTable& tbl, const std::string& columna, long first, long last,
+                                 OrdenEntradas<TRAITS>& sorter) {
+        constexpr int KB = TRAITS::KEY_BYTES;
+        const gft::ColMetaDisk& meta = tbl.col_meta(tbl.col_index(columna));
+        const int id_col = tbl.col_index("id");
+        const int id_off = id_col >= 0 ? tbl.col_meta(id_col).offset : -1;
+
+        uint8_t rec[KB + 4];
+        tbl.ScanRange(first, last, [&](long pid, const char* row) {
+            if (id_off >= 0) { int32_t id; std::memcpy(&id, row + id_off, 4); if (id == -1) return; }
+            const char* p = row + meta.offset;
+            if ((ColType)meta.type == ColType::CHAR) {
+                // mismo formato que KeyChar32::put: hasta KB-1 bytes y relleno con ceros
+                size_t len = std::min<size_t>(strnlen(p, meta.width), KB - 1);
+                std::memset(rec, 0, KB);
+                std::memcpy(rec, p, len);
+            } else {
+                std::memcpy(rec, p, KB);
+            }
+            int32_t pid32 = (int32_t)pid;
+            std::memcpy(rec + KB, &pid32, 4);
+            sorter.add(rec);
+        });
+        sorter.finish();
+    }
+
+    // Carga masiva de un índice recién creado (vacío): ordena externamente las entradas de toda
+    // la tabla con los archivos temporales bajo tmp_prefix y entrega el flujo a bulk_load.
+    template<class IDX>
+    void cargar_indice(GenericFixedTable& tbl, IDX& idx, const std::string& columna, const fs::path& tmp_prefix) {
+        using TRAITS = typename IDX::Traits;
+        constexpr int KB = TRAITS::KEY_BYTES;
+        OrdenEntradas<TRAITS> sorter(KB + 4, {}, tmp_prefix.string(), sort_mem_mb << 20);
+        tbl.FlushBatch();
+        ordenar_entradas<TRAITS>(tbl, columna, 0, tbl.Count(), sorter);
+        idx.bulk_load(sorter.size(), [&](uint8_t* kb, int& value) {
+            const uint8_t* r = sorter.next();
+            if (!r) return false;
+            std::memcpy(kb, r, KB);
+            std::memcpy(&value, r + KB, 4);
+            return true;
+        }, fill_factor);
+    }
+
+    // Vuelca las filas pendientes del lote y agrega a los índices abiertos sus entradas diferidas
+    // (en orden de pageID, igual que si se hubieran insertado una a una)
+    void aplicar_lote(TablaInfo& ti) {
+        ti.tabla->FlushBatch();
+        if (ti.lote_pids.empty()) return;
+        auto& tbl = *ti.tabla;
+        gft::RowView rv;
+        for (long pid : ti.lote_pids) {
+            if (!tbl.ViewRowByPageID(pid, rv)) continue;
+            indexar_columnas(tbl, ti.idx_int,   ColType::INT32,   rv, pid, [](const gft::RowView& r, int c){ return r.get_int(c); });
+            indexar_columnas(tbl, ti.idx_float, ColType::FLOAT32, rv, pid, [](const gft::RowView& r, int c){ return r.get_float(c); });
+            indexar_columnas(tbl, ti.idx_char,  ColType::CHAR,    rv, pid, [](const gft::RowView& r, int c){ return std::string(r.get_char_view(c)); });
+            indexar_columnas(tbl, ti.bp_int,    ColType::INT32,   rv, pid, [](const gft::RowView& r, int c){ return r.get_int(c); });
+            indexar_columnas(tbl, ti.bp_float,  ColType::FLOAT32, rv, pid, [](const gft::RowView& r, int c){ return r.get_float(c); });
+            indexar_columnas(tbl, ti.bp_char,   ColType::CHAR,    rv, pid, [](const gft::RowView& r, int c){ return std::string(r.get_char_view(c)); });
+        }
+        ti.lote_pids.clear();
+    }
+    void aplicar_lotes() {
+        for (auto& kv : tablas) aplicar_lote(kv.second);
+    }
+
+    template<class MAPA, class GET>
+    static void indexar_columnas(GenericFixedTable& tbl, MAPA& indices, ColType tipo,
+                                 const gft::RowView& rv, long pid, GET get) {
+        for (auto& kv : indices) {
+            int c = tbl.col_index(kv.first);
+            if (c < 0 || rv.type(c) != tipo) continue;
+            try { kv.second->insert(get(rv, c), (int)pid); } catch(...) {}
+        }
+    }
+
+    // Inserta en los índices abiertos las claves de las filas [first, last), ordenadas por
+    // (clave, pageID): descensos consecutivos recorren los mismos nodos del buffer pool.
+    // El orden usa el mismo ordenamiento externo que CREATE INDEX (memoria acotada por sort_mem_mb).
+    void indexar_rango_ordenado(TablaInfo& ti, const std::string& nombre_tabla, long first, long last) {
+        const fs::path tmp = root / nombre_tabla / ("." + nombre_tabla + "_");
+        indexar_ordenado(ti, ti.idx_int,   ColType::INT32,   first, last, tmp);
+        indexar_ordenado(ti, ti.idx_float, ColType::FLOAT32, first, last, tmp);
+        indexar_ordenado(ti, ti.idx_char,  ColType::CHAR,    first, last, tmp);
+        indexar_ordenado(ti, ti.bp_int,    ColType::INT32,   first, last, tmp);
+        indexar_ordenado(ti, ti.bp_float,  ColType::FLOAT32, first, last, tmp);
+        indexar_ordenado(ti, ti.bp_char,   ColType::CHAR,    first, last, tmp);
+    }
+    template<class MAPA>
+    void indexar_ordenado(TablaInfo& ti, MAPA& indices, ColType tipo, long first, long last,
+                          const fs::path& tmp_prefix) {
+        using TRAITS = typename MAPA::mapped_type::element_type::Traits;
+        constexpr int KB = TRAITS::KEY_BYTES;
+        auto& tbl = *ti.tabla;
+        for (auto& kv : indices) {
+            int c = tbl.col_index(kv.first);
+            if (c < 0 || (ColType)tbl.col_meta(c).type != tipo) continue;
+            OrdenEntradas<TRAITS> sorter(KB + 4, {}, tmp_prefix.string() + kv.first, sort_mem_mb << 20);
+            ordenar_entradas<TRAITS>(tbl, kv.first, first, last, sorter);
+            typename TRAITS::Key k{};
+            while (const uint8_t* r = sorter.next()) {
+                int32_t pid; std::memcpy(&pid, r + KB, 4);
+                TRAITS::get(r, k);
+                try { kv.second->insert(k, pid); } catch(...) {}
+            }
+        }
+    }
+
+    // Índices tras una carga masiva de filas [antes, Count()): reconstrucción por carga masiva si
+    // lo nuevo es al menos tanto como lo previo, inserción ordenada si no
+    void indexar_carga(TablaInfo& ti, const std::string& nombre_tabla, long antes) {
+        const long despues = ti.tabla->Count();
+        if (despues == antes) return;
+        if (despues - antes < antes) { indexar_rango_ordenado(ti, nombre_tabla, antes, despues); return; }
+        // B-Tree conserva su grado; B+Tree no tiene (el nodo ocupa una página)
+        std::vector<std::pair<std::string, int>> btree;
+        std::vector<std::string> bplus;
+        for (auto& kv : ti.idx_int)   btree.emplace_back(kv.first, kv.second->T());
+        for (auto& kv : ti.idx_float) btree.emplace_back(kv.first, kv.second->T());
+        for (auto& kv : ti.idx_char)  btree.emplace_back(kv.first, kv.second->T());
+        for (auto& kv : ti.bp_int)    bplus.push_back(kv.first);
+        for (auto& kv : ti.bp_float)  bplus.push_back(kv.first);
+        for (auto& kv : ti.bp_char)   bplus.push_back(kv.first);
+        for (auto& [col, t] : btree) crear_indice(nombre_tabla, col, t, TipoIndice::BTREE);
+        for (auto& col : bplus)      crear_indice(nombre_tabla, col, TipoIndice::BPLUS);
+    }
+
+    // Cierra y borra cualquier índice (de cualquier tipo) existente sobre la columna
+    void quitar_indice(TablaInfo& ti, const fs::path& tdir, const std::string& base, const std::string& col) {
+        ++gen;
+        ti.idx_int.erase(col); ti.idx_float.erase(col); ti.idx_char.erase(col);
+        ti.bp_int.erase(col);  ti.bp_float.erase(col);  ti.bp_char.erase(col);
+        std::error_code ec;
+        for (const char* ext : {".bti", ".btf", ".bts", ".bpi", ".bpf", ".bps"}) {
+            fs::remove(tdir / (base + ext), ec);
+        }
+    }
+
+    // Mantiene un índice B+Tree de la columna ante un cambio de valor; false si no hay B+Tree
+    static bool actualizar_bplus(TablaInfo& ti, const std::string& col, long pid,
+                                 const Value& before, const Value& after) {
+        auto itI = ti.bp_int.find(col);
+        if (itI != ti.bp_int.end()) {
+            itI->second->remove(before.i, (int)pid);
+            itI->second->insert(after.i, (int)pid);
+            return true;
+        }
+        auto itF = ti.bp_float.find(col);
+        if (itF != ti.bp_float.end()) {
+            itF->second->remove(before.f, (int)pid);
+            itF->second->insert(after.f, (int)pid);
+            return true;
+        }
+        auto itS = ti.bp_char.find(col);
+        if (itS != ti.bp_char.end()) {
+            itS->second->remove(before.s, (int)pid);
+            itS->second->insert(after.s, (int)pid);
+            return true;
+        }
+        return false;
+    }
+
+    // B+Tree de la columna si existe (nullptr si no)
+    diskbtree::BPTreeInt* buscar_bplus_int(const std::string& nt, const std::string& col) {
+        TablaInfo& ti = obtener_tabla(nt);
+        auto it = ti.bp_int.find(col);
+        return it == ti.bp_int.end() ? nullptr : it->second.get();
+    }
+    diskbtree::BPTreeFloat* buscar_bplus_float(const std::string& nt, const std::string& col) {
+        TablaInfo& ti = obtener_tabla(nt);
+        auto it = ti.bp_float.find(col);
+        return it == ti.bp_float.end() ? nullptr : it->second.get();
+    }
+    diskbtree::BPTreeChar32* buscar_bplus_char(const std::string& nt, const std::string& col) {
+        TablaInfo& ti = obtener_tabla(nt);
+        auto it = ti.bp_char.find(col);
+        return it == ti.bp_char.end() ? nullptr : it->second.get();
+    }
+
     // Obtención de índices (lanza si no existen)
     diskbtree::BTreeInt* obtener_indice_int(const std::string& nt, const std::string& col) {
         TablaInfo& ti = obtener_tabla(nt);
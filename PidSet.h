@@ -0,0 +1,138 @@
+// PidSet.h
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+#include "GenericFixedTable.h"   // gft::detail::popcount64 / ctz64
+
+// =================== CONFIG ===================
+#define PIDSET_DENSO 32   // bitmap cuando hay más de 1 pageID cada PIDSET_DENSO filas
+// ==============================================
+
+namespace pidset {
+
+// Conjunto de pageIDs de una tabla de n filas, para combinar resultados de índices antes de leer
+// filas. Dos representaciones según la densidad, como los contenedores de un roaring bitmap:
+// vector ordenado sin repetidos (pocos pageIDs) o bitmap de n bits (muchos). Intersección y
+// unión eligen el algoritmo por representación; pageIDs fuera de [0, n) se descartan.
+class PidSet {
+public:
+    PidSet() = default;
+
+    // Desde pageIDs en cualquier orden y con repetidos (lo que devuelve un sondeo de índice)
+    static PidSet from_unsorted(std::vector<int>&& v, long nrows) {
+        PidSet s; s.n = nrows;
+        if ((long)v.size() * PIDSET_DENSO > nrows) {
+            // denso: directo al bitmap, sin ordenar
+            s.bm = true;
+            s.bits.assign(words(nrows), 0);
+            for (int p : v) if (p >= 0 && p < nrows) s.bits[(size_t)p >> 6] |= uint64_t(1) << (p & 63);
+            s.recount();
+        } else {
+            std::sort(v.begin(), v.end());
+            v.erase(std::unique(v.begin(), v.end()), v.end());
+            v.erase(std::remove_if(v.begin(), v.end(), [&](int p) { return p < 0 || p >= nrows; }), v.end());
+            s.v = std::move(v);
+            s.cnt = s.v.size();
+        }
+        s.compact();
+        return s;
+    }
+
+    size_t size() const { return cnt; }
+    bool empty() const { return cnt == 0; }
+    bool is_bitmap() const { return bm; }
+
+    void intersect(const PidSet& o) {
+        if (bm && o.bm) {
+            for (size_t i = 0; i < bits.size(); ++i) bits[i] &= o.bits[i];
+            recount();
+        } else if (!bm && o.bm) {
+            v.erase(std::remove_if(v.begin(), v.end(), [&](int p) { return !o.test(p); }), v.end());
+            cnt = v.size();
+        } else if (bm && !o.bm) {
+            std::vector<int> r; r.reserve(o.v.size());
+            for (int p : o.v) if (test(p)) r.push_back(p);
+            set_vector(std::move(r));
+        } else {
+            set_vector(intersect_sorted(v, o.v));
+        }
+        compact();
+    }
+
+    void unite(const PidSet& o) {
+        if (!bm && !o.bm) {
+            std::vector<int> r; r.reserve(v.size() + o.v.size());
+            std::set_union(v.begin(), v.end(), o.v.begin(), o.v.end(), std::back_inserter(r));
+            set_vector(std::move(r));
+        } else {
+            to_bitmap();
+            if (o.bm) for (size_t i = 0; i < bits.size(); ++i) bits[i] |= o.bits[i];
+            else for (int p : o.v) bits[(size_t)p >> 6] |= uint64_t(1) << (p & 63);
+            recount();
+        }
+        compact();
+    }
+
+    // pageIDs en orden ascendente
+    void to_vector(std::vector<int>& out) const {
+        if (!bm) { out = v; return; }
+        out.clear(); out.reserve(cnt);
+        for (size_t w = 0; w < bits.size(); ++w) {
+            uint64_t x = bits[w];
+            while (x) {
+                out.push_back((int)(w * 64 + (size_t)gft::detail::ctz64(x)));
+                x &= x - 1;
+            }
+        }
+    }
+
+private:
+    std::vector<int> v;          // representación dispersa
+    std::vector<uint64_t> bits;  // representación densa
+    bool bm = false;
+    long n = 0;
+    size_t cnt = 0;
+
+    static size_t words(long nrows) { return (size_t)(nrows + 63) / 64; }
+    bool test(int p) const { return p >= 0 && p < n && ((bits[(size_t)p >> 6] >> (p & 63)) & 1u); }
+    void recount() {
+        cnt = 0;
+        for (uint64_t x : bits) cnt += (size_t)gft::detail::popcount64(x);
+    }
+    void set_vector(std::vector<int>&& r) { bm = false; bits.clear(); v = std::move(r); cnt = v.size(); }
+    void to_bitmap() {
+        if (bm) return;
+        bits.assign(words(n), 0);
+        for (int p : v) bits[(size_t)p >> 6] |= uint64_t(1) << (p & 63);
+        v.clear(); v.shrink_to_fit();
+        bm = true;
+    }
+    // cambio de representación con histéresis (no oscilar cerca del umbral)
+    void compact() {
+        if (!bm && (long)cnt * PIDSET_DENSO > n) to_bitmap();
+        else if (bm && (long)cnt * PIDSET_DENSO * 2 < n) { std::vector<int> r; to_vector(r); set_vector(std::move(r)); }
+    }
+
+    // con tamaños muy distintos, búsqueda del más chico en el más grande (avanzando); si no, mezcla
+    static std::vector<int> intersect_sorted(const std::vector<int>& a, const std::vector<int>& b) {
+        const std::vector<int>& s = a.size() <= b.size() ? a : b;
+        const std::vector<int>& g = a.size() <= b.size() ? b : a;
+        std::vector<int> r; r.reserve(s.size());
+        if (s.size() * 16 < g.size()) {
+            auto it = g.begin();
+            for (int p : s) {
+                it = std::lower_bound(it, g.end(), p);
+                if (it == g.end()) break;
+                if (*it == p) r.push_back(p);
+            }
+        } else {
+            std::set_intersection(s.begin(), s.end(), g.begin(), g.end(), std::back_inserter(r));
+        }
+        return r;
+    }
+};
+
+} // namespace pidset
@@ -6,23 +6,14 @@ ResultTableModel::ResultTableModel(QObject* parent)
     : QAbstractTableModel(parent) {}
 
 void ResultTableModel::setData(const QStringList& headers,
-                               const std::vector<std::vector<Value>>& rows,
-                               const sqlmini::TableSchema& schema)
+                               std::vector<std::vector<Value>> rows,
+                               std::vector<ColType> types)
 {
     beginResetModel();
     headers_ = headers;
-    rows_ = rows;
-
-    // Derivar tipos desde schema según headers
-    types_.clear(); types_.reserve(headers_.size());
-    for (const auto& h : headers_) {
-        gft::ColType ct = gft::ColType::INT32;
-        for (auto& c : schema.cols) {
-            if (h.toStdString() == c.name) { ct = c.type; break; }
-        }
-        types_.push_back(ct);
-    }
-
+    rows_ = std::move(rows);
+    types_ = std::move(types);
+    types_.resize((size_t)headers_.size(), ColType::INT32);
     endResetModel();
 }
 
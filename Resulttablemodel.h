@@ -3,16 +3,16 @@
 #include <QStringList>
 #include <vector>
 #include "GenericFixedTable.h" // gft::Value, gft::ColType
-#include "MiniDBSQL.h"         // sqlmini::TableSchema
 
 class ResultTableModel : public QAbstractTableModel {
     Q_OBJECT
 public:
     explicit ResultTableModel(QObject* parent=nullptr);
 
+    // types: tipo de cada columna (mismo orden que headers)
     void setData(const QStringList& headers,
-                 const std::vector<std::vector<gft::Value>>& rows,
-                 const sqlmini::TableSchema& schema_for_types);
+                 std::vector<std::vector<gft::Value>> rows,
+                 std::vector<gft::ColType> types);
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
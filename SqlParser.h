@@ -0,0 +1,440 @@
+// SqlParser.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cctype>
+#include <charconv>
+
+namespace sqlmini {
+
+enum class Cmp { EQ, GE, LE, GT, LT, NE };
+
+// Predicado "columna op literal"; lit conserva las comillas de un texto ('ANA').
+// Con un parámetro '?' lit queda "?" y param es su posición (desde 0) en la sentencia.
+struct Pred { std::string col; Cmp cmp; std::string lit; int param = -1; };
+
+// =================== Lexer ===================
+enum class Tok { IDENT, NUMBER, STRING, OP, LPAREN, RPAREN, COMMA, STAR, SEMI, PARAM, END, BAD };
+
+struct Token {
+    Tok kind = Tok::END;
+    std::string_view text;   // vista sobre la sentencia original (STRING incluye las comillas)
+    size_t pos = 0;
+};
+
+inline bool iequals(std::string_view a, std::string_view b){
+    if (a.size()!=b.size()) return false;
+    for (size_t i=0;i<a.size();++i)
+        if (std::toupper((unsigned char)a[i]) != std::toupper((unsigned char)b[i])) return false;
+    return true;
+}
+
+// Palabras reservadas: no valen como nombre de columna/tabla (CREATE TABLE las rechaza) ni como
+// literal sin comillas. La lista está también en la ayuda del CLI y en el README.
+inline bool is_keyword(std::string_view w){
+    for (const char* k : {"SELECT","FROM","WHERE","AND","OR","NOT","SET","UPDATE","DELETE"})
+        if (iequals(w, k)) return true;
+    return false;
+}
+
+// Palabras de cláusula: solo son palabra clave donde puede empezar o seguir una cláusula (tras la
+// tabla, la condición WHERE o la lista de GROUP BY); en cualquier otro lugar valen como nombre, así
+// que una columna "desc" creada antes de existir ORDER BY se sigue pudiendo usar. Sí se rechazan
+// como literal sin comillas (detrás de un valor puede empezar una cláusula).
+inline bool is_clause_word(std::string_view w){
+    for (const char* k : {"ORDER","BY","ASC","DESC","LIMIT","OFFSET","GROUP"})
+        if (iequals(w, k)) return true;
+    return false;
+}
+
+// Tokenizador de una sola pasada: no copia ni pasa a mayúsculas, cada token es una vista
+// sobre el texto de entrada (que debe vivir mientras se usen los tokens).
+class Lexer {
+public:
+    explicit Lexer(std::string_view src) : s(src) {}
+
+    Token next(){
+        while (i<s.size() && std::isspace((unsigned char)s[i])) ++i;
+        Token t; t.pos = i;
+        if (i>=s.size()) return t;
+        const char c = s[i];
+        if (std::isalpha((unsigned char)c) || c=='_'){
+            size_t b = i;
+            while (i<s.size() && (std::isalnum((unsigned char)s[i]) || s[i]=='_')) ++i;
+            return make(t, Tok::IDENT, b);
+        }
+        // número con signo opcional (no hay aritmética, así que '-'/'+' pegado a un dígito es parte del literal)
+        if (std::isdigit((unsigned char)c) || c=='.' ||
+            ((c=='-' || c=='+') && i+1<s.size() && (std::isdigit((unsigned char)s[i+1]) || s[i+1]=='.'))){
+            size_t b = i++;
+            while (i<s.size() && (std::isalnum((unsigned char)s[i]) || s[i]=='.' ||
+                   ((s[i]=='-' || s[i]=='+') && (s[i-1]=='e' || s[i-1]=='E')))) ++i;
+            return make(t, Tok::NUMBER, b);
+        }
+        if (c=='\''){
+            size_t b = i++;
+            while (i<s.size() && s[i]!='\'') ++i;
+            if (i>=s.size()) return make(t, Tok::BAD, b);   // comilla sin cerrar
+            ++i;
+            return make(t, Tok::STRING, b);
+        }
+        size_t b = i++;
+        switch (c){
+        case '(': return make(t, Tok::LPAREN, b);
+        case ')': return make(t, Tok::RPAREN, b);
+        case ',': return make(t, Tok::COMMA, b);
+        case '*': return make(t, Tok::STAR, b);
+        case ';': return make(t, Tok::SEMI, b);
+        case '?': return make(t, Tok::PARAM, b);
+        case '=':
+            if (i<s.size() && s[i]=='=') ++i;
+            return make(t, Tok::OP, b);
+        case '!':
+            if (i<s.size() && s[i]=='='){ ++i; return make(t, Tok::OP, b); }
+            return make(t, Tok::BAD, b);
+        case '<':
+            if (i<s.size() && (s[i]=='=' || s[i]=='>')) ++i;
+            return make(t, Tok::OP, b);
+        case '>':
+            if (i<s.size() && s[i]=='=') ++i;
+            return make(t, Tok::OP, b);
+        }
+        return make(t, Tok::BAD, b);
+    }
+
+private:
+    std::string_view s;
+    size_t i = 0;
+
+    Token make(Token t, Tok k, size_t b) const { t.kind = k; t.text = s.substr(b, i-b); return t; }
+};
+
+// =================== AST ===================
+// Árbol de la condición WHERE: hojas PRED; AND/OR n-arios (cadenas aplanadas); NOT unario
+struct Expr {
+    enum class Kind { PRED, AND, OR, NOT };
+    Kind kind = Kind::PRED;
+    Pred pred;
+    std::vector<std::unique_ptr<Expr>> args;
+};
+using ExprPtr = std::unique_ptr<Expr>;
+
+// Clave de ORDER BY (col es el nombre de un elemento del SELECT si es un agregado: "SUM(a)")
+struct OrderItem { std::string col; bool desc = false; };
+
+// Funciones de agregado (no son palabras reservadas: solo cuentan seguidas de '(')
+enum class AggFn { NONE, COUNT, SUM, AVG, MIN, MAX };
+
+inline const char* agg_fn_name(AggFn f){
+    switch (f){
+    case AggFn::COUNT: return "COUNT";
+    case AggFn::SUM:   return "SUM";
+    case AggFn::AVG:   return "AVG";
+    case AggFn::MIN:   return "MIN";
+    case AggFn::MAX:   return "MAX";
+    default:           return "";
+    }
+}
+
+// Elemento de la lista del SELECT: columna o agregado (col vacía en COUNT(*))
+struct SelectItem {
+    AggFn fn = AggFn::NONE;
+    std::string col;
+    // Nombre en el resultado: la columna, o "SUM(a)" / "COUNT(*)"
+    std::string name() const {
+        if (fn==AggFn::NONE) return col;
+        return std::string(agg_fn_name(fn)) + "(" + (col.empty() ? "*" : col) + ")";
+    }
+};
+
+struct SelectStmt {
+    bool star = false;
+    std::vector<SelectItem> items;   // proyección (vacía si star)
+    std::string table;
+    ExprPtr where;                   // nullptr: sin WHERE
+    std::vector<std::string> group;  // vacía: sin GROUP BY
+    std::vector<OrderItem> order;    // vacía: sin ORDER BY
+    long limit = -1;                 // -1: sin LIMIT
+    long offset = 0;                 // OFFSET (solo con LIMIT)
+    int nparams = 0;                 // cantidad de '?'
+};
+
+struct DeleteStmt {
+    std::string table;
+    ExprPtr where;
+    int nparams = 0;
+};
+
+// col = lit en SET (param >= 0 si el valor es '?')
+struct SetItem { std::string col; std::string lit; int param = -1; };
+
+struct UpdateStmt {
+    std::string table;
+    std::vector<SetItem> sets;
+    ExprPtr where;
+    int nparams = 0;
+};
+
+// =================== Parser ===================
+// Descenso recursivo sobre los tokens del Lexer. Gramática:
+//   SELECT ('*' | item {',' item}) FROM tabla [WHERE expr] [GROUP BY col {',' col}]
+//          [ORDER BY item [ASC|DESC] {',' ...}] [LIMIT n [OFFSET m]]
+//   item := col | fn '(' col ')' | COUNT '(' '*' ')'      fn: COUNT SUM AVG MIN MAX
+//   DELETE FROM tabla [WHERE expr]
+//   UPDATE tabla SET col = lit {',' col = lit} [WHERE expr]
+//   expr := and {OR and};  and := unario {AND unario};  unario := NOT unario | '(' expr ')' | pred
+//   pred := col op lit      op: == = != <> <= >= < >      lit: número | 'texto' | palabra | ?
+// Los errores se devuelven como texto (false + error()), igual que el resto de la capa SQL.
+class Parser {
+public:
+    explicit Parser(std::string_view sql) : lex(sql) { advance(); }
+
+    const std::string& error() const { return err; }
+
+    bool parse_select(SelectStmt& out){
+        stmt = "SELECT";
+        if (!keyword("SELECT")) return fail("se esperaba SELECT");
+        if (cur.kind==Tok::STAR){ out.star = true; advance(); }
+        else {
+            do {
+                SelectItem it;
+                if (!select_item(it)) return false;
+                out.items.push_back(std::move(it));
+            } while (accept(Tok::COMMA));
+        }
+        if (!keyword("FROM")) return fail("se esperaba FROM");
+        if (!ident(out.table)) return fail("se esperaba el nombre de la tabla");
+        if (!opt_where(out.where) || !opt_group(out.group) || !opt_order(out.order) || !opt_limit(out.limit, out.offset) || !finish()) return false;
+        out.nparams = nparams;
+        return true;
+    }
+
+    bool parse_delete(DeleteStmt& out){
+        stmt = "DELETE";
+        if (!keyword("DELETE") || !keyword("FROM")) return fail("se esperaba DELETE FROM");
+        if (!ident(out.table)) return fail("se esperaba el nombre de la tabla");
+        if (!opt_where(out.where) || !finish()) return false;
+        out.nparams = nparams;
+        return true;
+    }
+
+    bool parse_update(UpdateStmt& out){
+        stmt = "UPDATE";
+        if (!keyword("UPDATE")) return fail("se esperaba UPDATE");
+        if (!ident(out.table)) return fail("se esperaba el nombre de la tabla");
+        if (!keyword("SET")) return fail("se esperaba SET");
+        do {
+            SetItem it;
+            if (!ident(it.col)) return fail("se esperaba una columna en SET");
+            if (cur.kind!=Tok::OP || (cur.text!="=" && cur.text!="==")) return fail("se esperaba '='");
+            advance();
+            if (!literal(it.lit, it.param)) return fail("se esperaba un valor");
+            out.sets.push_back(std::move(it));
+        } while (accept(Tok::COMMA));
+        if (!opt_where(out.where) || !finish()) return false;
+        out.nparams = nparams;
+        return true;
+    }
+
+    // Solo una condición (lo que va después de WHERE)
+    bool parse_condition(ExprPtr& out){
+        stmt = "WHERE";
+        out = or_expr();
+        return out && finish();
+    }
+
+private:
+    Lexer lex;
+    Token cur;
+    std::string err;
+    const char* stmt = "";
+    int nparams = 0;
+
+    void advance(){ cur = lex.next(); }
+    bool accept(Tok k){ if (cur.kind!=k) return false; advance(); return true; }
+    bool is_kw(const char* kw) const { return cur.kind==Tok::IDENT && iequals(cur.text, kw); }
+    bool keyword(const char* kw){ if (!is_kw(kw)) return false; advance(); return true; }
+
+    bool ident(std::string& out){
+        if (cur.kind!=Tok::IDENT || is_keyword(cur.text)) return false;
+        out.assign(cur.text); advance(); return true;
+    }
+
+    bool literal(std::string& out, int& param){
+        if (cur.kind==Tok::NUMBER || cur.kind==Tok::STRING || cur.kind==Tok::PARAM ||
+            (cur.kind==Tok::IDENT && !is_keyword(cur.text) && !is_clause_word(cur.text))){
+            if (cur.kind==Tok::PARAM) param = nparams++;
+            out.assign(cur.text); advance(); return true;
+        }
+        return false;
+    }
+
+    bool fail(const char* what){
+        if (!err.empty()) return false;   // conservar el primer error
+        if (cur.kind==Tok::BAD && cur.text.size() && cur.text[0]=='\'') what = "comilla sin cerrar";
+        err = std::string("Sintaxis ") + stmt + " inválida: " + what;
+        if (cur.kind==Tok::END) err += " (fin de la sentencia)";
+        else err += " cerca de '" + std::string(cur.text) + "'";
+        return false;
+    }
+
+    bool opt_where(ExprPtr& out){
+        if (!keyword("WHERE")) return true;
+        out = or_expr();
+        return out != nullptr;
+    }
+
+    // col | fn '(' col ')' | COUNT '(' '*' ')'
+    bool select_item(SelectItem& out){
+        if (cur.kind==Tok::IDENT && next_is(Tok::LPAREN)){
+            for (AggFn f : {AggFn::COUNT, AggFn::SUM, AggFn::AVG, AggFn::MIN, AggFn::MAX})
+                if (iequals(cur.text, agg_fn_name(f))) out.fn = f;
+            if (out.fn==AggFn::NONE) return fail("función de agregado desconocida");
+            advance(); advance();
+            if (!(out.fn==AggFn::COUNT && accept(Tok::STAR)) && !ident(out.col))
+                return fail(out.fn==AggFn::COUNT ? "se esperaba una columna o '*'" : "se esperaba una columna");
+            if (!accept(Tok::RPAREN)) return fail("falta ')'");
+            return true;
+        }
+        if (!ident(out.col)) return fail("se esperaba una columna");
+        return true;
+    }
+
+    bool next_is(Tok k) const { Lexer l = lex; return l.next().kind==k; }
+
+    bool opt_group(std::vector<std::string>& out){
+        if (!keyword("GROUP")) return true;
+        if (!keyword("BY")) return fail("se esperaba BY");
+        do {
+            std::string c;
+            if (!ident(c)) return fail("se esperaba una columna en GROUP BY");
+            out.push_back(std::move(c));
+        } while (accept(Tok::COMMA));
+        return true;
+    }
+
+    bool opt_order(std::vector<OrderItem>& out){
+        if (!keyword("ORDER")) return true;
+        if (!keyword("BY")) return fail("se esperaba BY");
+        do {
+            OrderItem it;
+            SelectItem e;
+            if (!select_item(e)) return false;
+            it.col = e.name();
+            if (keyword("DESC")) it.desc = true;
+            else keyword("ASC");
+            out.push_back(std::move(it));
+        } while (accept(Tok::COMMA));
+        return true;
+    }
+
+    bool opt_limit(long& limit, long& offset){
+        if (!keyword("LIMIT")) return true;
+        if (!entero(limit)) return fail("se esperaba un entero no negativo en LIMIT");
+        if (keyword("OFFSET") && !entero(offset)) return fail("se esperaba un entero no negativo en OFFSET");
+        return true;
+    }
+
+    bool entero(long& out){
+        const std::string_view t = cur.text;
+        long n = -1;
+        if (cur.kind!=Tok::NUMBER) return false;
+        auto r = std::from_chars(t.data(), t.data() + t.size(), n);
+        if (r.ec!=std::errc() || r.ptr!=t.data() + t.size() || n < 0) return false;
+        out = n; advance();
+        return true;
+    }
+
+    bool finish(){
+        accept(Tok::SEMI);
+        if (cur.kind!=Tok::END) return fail("texto inesperado");
+        return true;
+    }
+
+    // AND/OR n-arios: a OR b OR c queda como un solo nodo con tres hijos
+    ExprPtr chain(Expr::Kind k, const char* kw, ExprPtr (Parser::*sub)()){
+        ExprPtr first = (this->*sub)();
+        if (!first || !is_kw(kw)) return first;
+        auto node = std::make_unique<Expr>();
+        node->kind = k;
+        node->args.push_back(std::move(first));
+        while (keyword(kw)){
+            ExprPtr e = (this->*sub)();
+            if (!e) return nullptr;
+            node->args.push_back(std::move(e));
+        }
+        return node;
+    }
+    ExprPtr or_expr(){ return chain(Expr::Kind::OR, "OR", &Parser::and_expr); }
+    ExprPtr and_expr(){ return chain(Expr::Kind::AND, "AND", &Parser::unary); }
+
+    ExprPtr unary(){
+        if (keyword("NOT")){
+            ExprPtr e = unary();
+            if (!e) return nullptr;
+            auto node = std::make_unique<Expr>();
+            node->kind = Expr::Kind::NOT;
+            node->args.push_back(std::move(e));
+            return node;
+        }
+        if (accept(Tok::LPAREN)){
+            ExprPtr e = or_expr();
+            if (!e) return nullptr;
+            if (!accept(Tok::RPAREN)){ fail("falta ')'"); return nullptr; }
+            return e;
+        }
+        return predicate();
+    }
+
+    ExprPtr predicate(){
+        auto node = std::make_unique<Expr>();
+        Pred& p = node->pred;
+        if (!ident(p.col)){ fail("se esperaba una columna"); return nullptr; }
+        if (cur.kind!=Tok::OP){ fail("se esperaba un operador de comparación"); return nullptr; }
+        const std::string_view op = cur.text;
+        if      (op=="==" || op=="=") p.cmp = Cmp::EQ;
+        else if (op=="!=" || op=="<>") p.cmp = Cmp::NE;
+        else if (op==">=") p.cmp = Cmp::GE;
+        else if (op=="<=") p.cmp = Cmp::LE;
+        else if (op==">")  p.cmp = Cmp::GT;
+        else               p.cmp = Cmp::LT;
+        advance();
+        if (!literal(p.lit, p.param)){ fail("se esperaba un valor"); return nullptr; }
+        return node;
+    }
+};
+
+inline bool parse_select(std::string_view sql, SelectStmt& out, std::string& err){
+    Parser p(sql); bool ok = p.parse_select(out); err = p.error(); return ok;
+}
+inline bool parse_delete(std::string_view sql, DeleteStmt& out, std::string& err){
+    Parser p(sql); bool ok = p.parse_delete(out); err = p.error(); return ok;
+}
+inline bool parse_update(std::string_view sql, UpdateStmt& out, std::string& err){
+    Parser p(sql); bool ok = p.parse_update(out); err = p.error(); return ok;
+}
+inline bool parse_condition(std::string_view expr, ExprPtr& out, std::string& err){
+    Parser p(expr); bool ok = p.parse_condition(out); err = p.error(); return ok;
+}
+
+// Texto canónico de una sentencia (clave de la caché de planes): tokens separados por un espacio,
+// palabras reservadas en mayúsculas y sin ';' final. "select *  from t where id=?" y
+// "SELECT * FROM t WHERE id = ?" dan la misma clave. Las palabras de cláusula quedan como se
+// escribieron: el plan se arma parseando la clave y "desc" puede ser el nombre de una columna.
+inline std::string normalize_sql(std::string_view sql){
+    Lexer lx(sql);
+    std::string out; out.reserve(sql.size());
+    for (Token t = lx.next(); t.kind!=Tok::END; t = lx.next()){
+        if (t.kind==Tok::SEMI) continue;
+        if (!out.empty()) out += ' ';
+        if (t.kind==Tok::IDENT && is_keyword(t.text))
+            for (char c : t.text) out += (char)std::toupper((unsigned char)c);
+        else out.append(t.text);
+    }
+    return out;
+}
+
+} // namespace sqlmini
@@ -18,7 +18,9 @@ void SqlHighlighter::highlightBlock(const QString& text) {
     // Palabras clave básicas
     static const QStringList kws = {
         "SELECT","FROM","WHERE","AND","OR","CREATE","TABLE","DATABASE","INDEX","ON",
-        "INSERT","INTO","VALUES","USE","CLOSE","SHOW","DELETE","UPDATE","SET","TABLES"
+        "INSERT","INTO","VALUES","USE","CLOSE","SHOW","DELETE","UPDATE","SET","TABLES",
+        "ORDER","BY","ASC","DESC","LIMIT","OFFSET","GROUP",
+        "COUNT","SUM","AVG","MIN","MAX"
     };
     for (const auto& k : kws) {
         QRegularExpression re("\\b" + k + "\\b", QRegularExpression::CaseInsensitiveOption);
@@ -17,28 +17,6 @@
 using namespace std;
 namespace fs = std::filesystem;
 
-// ===== Helpers locales (copian semántica de las del headers SQL, para no depender de privados) =====
-std::string MainWindow::trim_local(const std::string& s){
-    size_t a = 0, b = s.size();
-    while (a<b && isspace((unsigned char)s[a])) ++a;
-    while (b>a && isspace((unsigned char)s[b-1])) --b;
-    return s.substr(a, b-a);
-}
-std::string MainWindow::to_upper_local(std::string s){
-    for (auto& c : s) c = (char)toupper((unsigned char)c);
-    return s;
-}
-std::vector<std::string> MainWindow::split_csv_local(const std::string& s){
-    std::vector<std::string> out; std::string cur; bool inq=false;
-    for(char c : s){
-        if (c=='\''){ inq=!inq; cur.push_back(c); }
-        else if (!inq && c==','){ out.push_back(trim_local(cur)); cur.clear(); }
-        else cur.push_back(c);
-    }
-    if (!cur.empty()) out.push_back(trim_local(cur));
-    return out;
-}
-
 // ===== MainWindow =====
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
@@ -201,119 +179,62 @@ bool MainWindow::isSelect(const QString& sql) {
 void MainWindow::executeAndMaybeShowTable(const QString& sql) {
     console_->appendLine(">> " + sql);
 
-    // 1) Ejecuta el SQL (si es USE, MiniDBSQL cambiará internamente)
+    // 1) SELECT: las filas van directo a la tabla (una sola ejecución)
+    if (isSelect(sql) && tryRenderSelect(sql)) return;
+
+    // 2) Resto (o SELECT con error): ejecuta con salida textual (si es USE, MiniDBSQL cambiará internamente)
     executor_.execute(sql.toStdString());
 
-    // 2) Actualiza el GUI si era un USE (para que tryRenderSelect sepa la ruta)
+    // 3) Actualiza el GUI si era un USE
     applyUseFromSQL(sql);
-
-    // 3) Si es SELECT, intenta renderizarlo en la tabla
-    if (isSelect(sql)) {
-        if (!tryRenderSelect(sql)) {
-            // Si falla, deja solo el output textual del executor
-            // (opcional: console_->appendLine("[GUI] No se pudo renderizar SELECT");
-        }
-    }
 }
 
 
-// --------- SELECT renderer (no modifica tu executor; lee directamente la tabla) ----------
+// --------- SELECT renderer (sink del pipeline del executor) ----------
 #include "MiniDBSQL.h"  // reutilizamos helpers públicos
 
-bool MainWindow::tryRenderSelect(const QString& qsql) {
-    using namespace sqlmini;
-    using gft::GenericFixedTable; using gft::Value; using gft::ColType;
-
-    std::string full = qsql.toStdString();
-    auto up = to_upper_local(full);
-    size_t psel = up.find("SELECT "); if (psel!=0) return false;
-    size_t pfrom = up.find(" FROM ", 7); if (pfrom==std::string::npos) return false;
-    auto proj = trim_local(full.substr(7, pfrom-7));
-
-    size_t pwhere = up.find(" WHERE ", pfrom+6);
-    std::string tname, wexpr;
-    if (pwhere==std::string::npos) tname = trim_local(full.substr(pfrom+6));
-    else {
-        tname = trim_local(full.substr(pfrom+6, pwhere-(pfrom+6)));
-        wexpr = trim_local(full.substr(pwhere+7));
-    }
-
-    // Localiza ruta de tabla bajo currentDbPath_
-    if (currentDbPath_.isEmpty()) return false;
-    fs::path tfile = fs::path(currentDbPath_.toStdString()) / tname / (tname + ".tbl");
+namespace {
+// La tabla guarda a lo sumo kMaxFilasTabla filas; el resto solo se cuenta (memoria acotada)
+constexpr size_t kMaxFilasTabla = 100000;
 
-    // Reutilizar la lectura del esquema desde MiniDBSQL.h (función global)
-    sqlmini::TableSchema sc;
-    if (!sqlmini::load_schema_from_tbl(tfile, sc)) return false;
-
-    // Proyección
-    std::vector<int> proj_idx;
-    if (proj == "*") {
-        for (int i=0;i<sc.ncols;++i) proj_idx.push_back(i);
-    } else {
-        auto cs = split_csv_local(proj);
-        for (auto& c : cs){
-            int idx=-1;
-            for (int i=0;i<sc.ncols;++i) if (sc.cols[i].name==c){ idx=i; break; }
-            if (idx==-1) return false;
-            proj_idx.push_back(idx);
-        }
-    }
+// Recibe las filas proyectadas del SELECT y las guarda para el QTableView
+class TableSink : public sqlmini::RowSink {
+public:
+    QStringList headers;
+    std::vector<std::vector<gft::Value>> data;
+    std::vector<gft::ColType> types;
+    size_t total = 0;
 
-    // Localiza índice de la columna 'id' (para filtrar borrados lógicos id == -1)
-    int id_idx = -1;
-    for (int i=0;i<sc.ncols;++i) {
-        if (sc.cols[i].name == "id" && sc.cols[i].type == ColType::INT32) { id_idx = i; break; }
+    void begin(const std::vector<std::string>& names) override {
+        for (const auto& n : names) headers << QString::fromStdString(n);
     }
-    auto is_deleted = [&](const std::vector<Value>& row)->bool {
-        if (id_idx < 0) return false;
-        return row[id_idx].i == -1;
-    };
-
-    // Cargar toda la tabla (para simplicidad; si quieres, puedes replicar el uso de índices aquí)
-    GenericFixedTable tbl(tfile.string(), tname, std::vector<gft::ColumnDef>{}, /*create_new*/false);
-    const long n = tbl.Count();
-
-    // Si hay WHERE, filtramos con helpers del executor:
-    std::vector<int> pids;
-    if (wexpr.empty()) {
-        for (long i=0;i<n;++i) {
-            std::vector<Value> row;
-            if (!tbl.ReadRowByPageID(i, row)) continue;
-            if (is_deleted(row)) continue;              // <<--- filtra borradas
-            pids.push_back((int)i);
-        }
-    } else {
-        sqlmini::Where w{};
-        if (!sqlmini::parse_where(wexpr, w)) return false;
-        for (long i=0;i<n;++i){
-            std::vector<Value> row;
-            if (!tbl.ReadRowByPageID(i, row)) continue;
-            if (is_deleted(row)) continue;              // <<--- filtra borradas antes de evaluar WHERE
-            bool r1 = w.p1 ? sqlmini::eval_pred_row(*w.p1, sc, row) : true;
-            bool r2 = w.p2 ? sqlmini::eval_pred_row(*w.p2, sc, row) : true;
-            bool ok = w.op=="AND" ? (r1 && r2) : (w.op=="OR" ? (r1 || r2) : r1);
-            if (ok) pids.push_back((int)i);
+    bool row(const gft::RowView& r, const std::vector<int>& proj) override {
+        if (types.empty()) for (int j : proj) types.push_back(r.type(j));
+        if (data.size() < kMaxFilasTabla) {
+            std::vector<gft::Value> out;
+            out.reserve(proj.size());
+            for (int j : proj) out.push_back(r.get(j));
+            data.push_back(std::move(out));
         }
+        return true;
     }
+    void end(size_t n) override { total = n; }
+};
+}
 
-    // Construye headers y filas para el QTableView
-    QStringList headers;
-    for (int j : proj_idx) headers << QString::fromStdString(sc.cols[j].name);
-
-    std::vector<std::vector<Value>> data;
-    data.reserve(pids.size());
-    for (int pid : pids){
-        std::vector<Value> row;
-        if (!tbl.ReadRowByPageID(pid, row)) continue;
-        if (is_deleted(row)) continue;
-        std::vector<Value> out;
-        out.reserve(proj_idx.size());
-        for (int j : proj_idx) out.push_back(row[j]);
-        data.push_back(std::move(out));
-    }
-
-    resultsModel_->setData(headers, data, sc); // muestra
+bool MainWindow::tryRenderSelect(const QString& qsql) {
+    // Mismo parser, plan y ruta de acceso (índices) que el executor; con '?' o error responde
+    // executor_.execute con su mensaje
+    TableSink sink;
+    std::string err;
+    if (!executor_.select(qsql.toStdString(), sink, err)) return false;
+
+    QString msg = QString("(filas: %1)").arg(sink.total);
+    if (sink.total > sink.data.size())
+        msg += QString(" — la tabla muestra las primeras %1").arg(sink.data.size());
+    console_->appendLine(msg);
+
+    resultsModel_->setData(sink.headers, std::move(sink.data), std::move(sink.types)); // muestra
     resultsView_->resizeColumnsToContents();
     return true;
 }
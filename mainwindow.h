@@ -79,12 +79,6 @@ private:
     // Devuelve true si se pudo mostrar
     bool tryRenderSelect(const QString& sql);
 
-    // Utilidades de parsing (usamos funciones libres de MiniDBSQL.h si están accesibles)
-    // Aquí duplicamos una mínima parte necesaria (nombres idénticos a las del header):
-    std::vector<std::string> split_csv_local(const std::string& s);
-    std::string trim_local(const std::string& s);
-    std::string to_upper_local(std::string s);
-
     bool applyUseFromSQL(const QString& sql);   // detecta y aplica USE
     void setCurrentDbPath(const QString& path); // normaliza y guarda ruta
 };
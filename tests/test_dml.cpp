@@ -0,0 +1,149 @@
+// DELETE/UPDATE por SQL sobre una tabla con índices B-Tree y B+Tree en columnas con valores
+// repetidos: COUNT(*) y los recorridos por índice deben coincidir con un modelo de las filas,
+// antes y después de cerrar y reabrir la base.
+#include "MiniDBSQL.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Fila { int k; float g; std::string s; bool viva = true; };
+
+class Sesion {
+public:
+    explicit Sesion(const fs::path& dir) : ex(out) { ejecutar("USE " + dir.string()); }
+
+    std::string ejecutar(const std::string& sql) {
+        out.str(""); out.clear();
+        ex.execute(sql);
+        return out.str();
+    }
+
+    // Primera celda del resultado en texto (encabezado, valor, "(filas: 1)")
+    long contar(const std::string& sql) {
+        std::string r = ejecutar(sql);
+        size_t nl = r.find('\n');
+        EXPECT_NE(nl, std::string::npos) << sql << "\n" << r;
+        return nl == std::string::npos ? -1 : std::stol(r.substr(nl + 1));
+    }
+
+    // Filas que entrega el SELECT recorriendo el cursor
+    long filas(const std::string& sql) {
+        sqlmini::Statement st = ex.prepare(sql);
+        EXPECT_TRUE(st.valid()) << st.error();
+        long n = 0;
+        while (st.step()) ++n;
+        EXPECT_TRUE(st.error().empty()) << st.error();
+        return n;
+    }
+
+    sqlmini::SQLExecutor& executor() { return ex; }
+
+private:
+    std::ostringstream out;
+    sqlmini::SQLExecutor ex;
+};
+
+long cuantas(const std::vector<Fila>& m, const std::function<bool(const Fila&)>& pred) {
+    long n = 0;
+    for (const auto& f : m) if (f.viva && pred(f)) ++n;
+    return n;
+}
+
+void verificar(Sesion& db, const std::vector<Fila>& m) {
+    const long vivas = cuantas(m, [](const Fila&) { return true; });
+    EXPECT_EQ(db.contar("SELECT COUNT(*) FROM t"), vivas);
+    // cada WHERE cubre todas las filas pero se resuelve por el índice de su columna
+    EXPECT_EQ(db.contar("SELECT COUNT(*) FROM t WHERE g >= 0"), vivas);
+    EXPECT_EQ(db.filas("SELECT id FROM t WHERE g >= 0"), vivas);
+    EXPECT_EQ(db.filas("SELECT id FROM t WHERE k >= 0"), vivas);
+    EXPECT_EQ(db.filas("SELECT id FROM t WHERE s >= 'a'"), vivas);
+    for (int k : {3, 10, 33}) {
+        EXPECT_EQ(db.filas("SELECT id FROM t WHERE k == " + std::to_string(k)),
+                  cuantas(m, [&](const Fila& f) { return f.k == k; })) << "k == " << k;
+    }
+    for (int g : {0, 2, 9}) {
+        EXPECT_EQ(db.contar("SELECT COUNT(*) FROM t WHERE g == " + std::to_string(g)),
+                  cuantas(m, [&](const Fila& f) { return f.g == (float)g; })) << "g == " << g;
+    }
+    EXPECT_EQ(db.filas("SELECT id FROM t WHERE s == 'x'"),
+              cuantas(m, [](const Fila& f) { return f.s == "x"; }));
+}
+
+class DmlReabrir : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir = fs::temp_directory_path() / "minidb_test_dml";
+        fs::remove_all(dir);
+        std::ostringstream out;
+        sqlmini::SQLExecutor ex(out);
+        ex.execute("CREATE DATABASE " + dir.string());
+    }
+    void TearDown() override { fs::remove_all(dir); }
+    fs::path dir;
+};
+
+} // namespace
+
+TEST_F(DmlReabrir, DeleteUpdateYCountConIndices) {
+    std::vector<Fila> m;
+    {
+        Sesion db(dir);
+        db.ejecutar("CREATE TABLE t (k INT, g FLOAT, s CHAR(8))");
+        std::string ins = "INSERT INTO t (k, g, s) VALUES ";
+        for (int i = 0; i < 300; ++i) {
+            Fila f{(i * 37) % 61, (float)(i % 6), std::string(1, (char)('a' + i % 7))};
+            ins += (i ? ", (" : "(") + std::to_string(f.k) + ", " + std::to_string((int)f.g) + ", '" + f.s + "')";
+            m.push_back(f);
+        }
+        db.ejecutar(ins);
+        db.ejecutar("CREATE INDEX ON t (g) USING BTREE");
+        db.ejecutar("CREATE INDEX ON t (k) USING BPLUS");
+        db.ejecutar("CREATE INDEX ON t (s) USING BTREE");
+        verificar(db, m);
+
+        for (int k : {30, 12, 45, 7}) {
+            db.ejecutar("DELETE FROM t WHERE k == " + std::to_string(k));
+            for (auto& f : m) if (f.k == k) f.viva = false;
+        }
+        db.ejecutar("UPDATE t SET g = 9 WHERE k < 10");
+        for (auto& f : m) if (f.viva && f.k < 10) f.g = 9;
+        db.ejecutar("UPDATE t SET s = 'x' WHERE g == 2");
+        for (auto& f : m) if (f.viva && f.g == 2) f.s = "x";
+        verificar(db, m);
+
+        // sentencias preparadas: mismo mantenimiento de índices
+        sqlmini::Statement del = db.executor().prepare("DELETE FROM t WHERE k == ? AND g != ?");
+        ASSERT_TRUE(del.valid()) << del.error();
+        del.bind(1, gft::Value::Int(3));
+        del.bind(2, gft::Value::Flt(9.0f));
+        EXPECT_FALSE(del.step());
+        EXPECT_TRUE(del.error().empty()) << del.error();
+        for (auto& f : m) if (f.viva && f.k == 3 && f.g != 9) f.viva = false;
+        sqlmini::Statement upd = db.executor().prepare("UPDATE t SET k = ? WHERE s == ?");
+        ASSERT_TRUE(upd.valid()) << upd.error();
+        upd.bind(1, gft::Value::Int(33));
+        upd.bind(2, gft::Value::Chr("c"));
+        EXPECT_FALSE(upd.step());
+        EXPECT_EQ(upd.changes(), cuantas(m, [](const Fila& f) { return f.s == "c"; }));
+        for (auto& f : m) if (f.viva && f.s == "c") f.k = 33;
+        verificar(db, m);
+    }
+    {
+        Sesion db(dir);
+        verificar(db, m);
+        db.ejecutar("DELETE FROM t WHERE g == 0");
+        for (auto& f : m) if (f.g == 0) f.viva = false;
+        verificar(db, m);
+    }
+    Sesion db(dir);
+    verificar(db, m);
+}
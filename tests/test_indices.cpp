@@ -0,0 +1,136 @@
+// Chequeo contra un modelo en memoria (multimap) de DiskBTree y DiskBPlusTree: inserciones y
+// borrados aleatorios con muchas claves repetidas, comparando las entradas (clave, pageID).
+#include "DiskBTreeMulti.h"
+#include "DiskBPlusTree.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <set>
+
+namespace fs = std::filesystem;
+using namespace diskbtree;
+
+namespace {
+
+using Modelo = std::multimap<int, int>;
+
+fs::path archivo_temporal(const std::string& ext) {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    std::string nombre = std::string(info->test_suite_name()) + "_" + info->name();
+    for (char& c : nombre) if (c == '/') c = '_';
+    fs::path p = fs::temp_directory_path() / ("minidb_" + nombre + ext);
+    fs::remove(p);
+    return p;
+}
+
+// Los pageID de cada clave deben coincidir con el modelo, y un recorrido completo debe salir
+// en orden de clave con todas las entradas
+template<class IDX>
+void comparar(const IDX& idx, const Modelo& m, int max_clave) {
+    for (int k = 0; k < max_clave; ++k) {
+        auto v = idx.range_search_values(k, k);
+        std::multiset<int> got(v.begin(), v.end()), want;
+        auto r = m.equal_range(k);
+        for (auto it = r.first; it != r.second; ++it) want.insert(it->second);
+        ASSERT_EQ(got, want) << "clave " << k;
+    }
+    size_t n = 0; int prev = INT32_MIN;
+    idx.range_scan(INT32_MIN, INT32_MAX, [&](const uint8_t* kb, int) {
+        int k; KeyInt::get(kb, k);
+        EXPECT_LE(prev, k);
+        prev = k; ++n;
+        return true;
+    });
+    EXPECT_EQ(n, m.size());
+}
+
+// Mezcla inserciones, borrados exactos de una entrada existente, borrados de entradas que no
+// existen y remove_key; cada tanto compara contra el modelo
+template<class IDX>
+void ejercitar(IDX& idx, Modelo& m, int& pid, unsigned semilla, int max_clave, int ops) {
+    std::mt19937 rng(semilla);
+    for (int op = 0; op < ops; ++op) {
+        const unsigned dado = rng() % 10;
+        if (m.empty() || dado < 6) {
+            int k = (int)(rng() % (unsigned)max_clave);
+            idx.insert(k, pid); m.emplace(k, pid); ++pid;
+        } else if (dado < 8) {
+            auto it = m.begin(); std::advance(it, rng() % m.size());
+            ASSERT_TRUE(idx.remove(it->first, it->second)) << "op " << op;
+            m.erase(it);
+        } else if (dado < 9) {
+            ASSERT_FALSE(idx.remove((int)(rng() % (unsigned)max_clave), -1 - op));
+        } else {
+            int k = (int)(rng() % (unsigned)max_clave);
+            auto r = m.equal_range(k);
+            std::set<int> antes;
+            for (auto it = r.first; it != r.second; ++it) antes.insert(it->second);
+            idx.remove_key(k);
+            if (antes.empty()) continue;
+            // quitó exactamente una entrada de la clave: la que ya no aparece
+            auto v = idx.range_search_values(k, k);
+            std::set<int> despues(v.begin(), v.end());
+            ASSERT_EQ(despues.size() + 1, antes.size());
+            for (auto it = r.first; it != r.second; ++it) {
+                if (!despues.count(it->second)) { m.erase(it); break; }
+            }
+        }
+        if (op % 500 == 0) comparar(idx, m, max_clave);
+    }
+    comparar(idx, m, max_clave);
+}
+
+} // namespace
+
+class BTreeModelo : public ::testing::TestWithParam<int> {};
+
+TEST_P(BTreeModelo, DuplicadosInsertarYBorrar) {
+    const int t = GetParam();
+    const fs::path p = archivo_temporal(".bti");
+    Modelo m; int pid = 0;
+    {
+        BTreeInt idx(p.string(), t, /*create_new*/true);
+        for (unsigned s = 0; s < 4; ++s) ejercitar(idx, m, pid, s * 7919u + (unsigned)t, 25, 3000);
+    }
+    BTreeInt idx(p.string(), t, /*create_new*/false);   // reabrir conserva las entradas
+    comparar(idx, m, 25);
+    fs::remove(p);
+}
+
+INSTANTIATE_TEST_SUITE_P(Grados, BTreeModelo, ::testing::Values(2, 3, 8));
+
+TEST(BPlusTreeModelo, DuplicadosInsertarYBorrar) {
+    const fs::path p = archivo_temporal(".bpi");
+    Modelo m; int pid = 0;
+    {
+        BPTreeInt idx(p.string(), /*create_new*/true);
+        for (unsigned s = 0; s < 4; ++s) ejercitar(idx, m, pid, s * 104729u + 1, 40, 6000);
+        EXPECT_EQ(idx.size(), m.size());
+    }
+    BPTreeInt idx(p.string(), /*create_new*/false);
+    comparar(idx, m, 40);
+    fs::remove(p);
+}
+
+// Vaciar por completo con borrados exactos y volver a llenar
+TEST(BTreeVaciar, BorradosExactosHastaVaciarYRellenar) {
+    const fs::path p = archivo_temporal(".bti");
+    BTreeInt idx(p.string(), 2, true);
+    Modelo m;
+    for (int i = 0; i < 400; ++i) { idx.insert(i % 5, i); m.emplace(i % 5, i); }
+    std::mt19937 rng(17);
+    while (!m.empty()) {
+        auto it = m.begin(); std::advance(it, rng() % m.size());
+        ASSERT_TRUE(idx.remove(it->first, it->second));
+        m.erase(it);
+    }
+    comparar(idx, m, 5);
+    EXPECT_EQ(idx.root_offset(), 0u);
+    for (int i = 0; i < 50; ++i) { idx.insert(3, i); m.emplace(3, i); }
+    comparar(idx, m, 5);
+    fs::remove(p);
+}